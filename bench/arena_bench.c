@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "arena.h"
+
+// Allocation throughput of thread-local shards against one arena behind a mutex,
+// for 1 to N threads. Every allocation is the size of an SK node and is touched once.
+
+#define S_NODE 32
+
+typedef struct bench_job {
+  Arena arena;
+  pthread_mutex_t* lock;
+  uint64_t count;
+} BenchJob;
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void* _bench_shards(void* arg) {
+  BenchJob* job = (BenchJob*)arg;
+  Arena shard = arena_shard(job->arena);
+  if (shard == NULL)
+    return (void*)1;
+  for (uint64_t i = 0; i < job->count; i++) {
+    uint64_t* node = (uint64_t*)arena_alloc(shard, S_NODE);
+    if (node == NULL)
+      return (void*)1;
+    node[0] = i;
+  }
+  return NULL;
+}
+
+static void* _bench_locked(void* arg) {
+  BenchJob* job = (BenchJob*)arg;
+  for (uint64_t i = 0; i < job->count; i++) {
+    pthread_mutex_lock(job->lock);
+    uint64_t* node = (uint64_t*)arena_alloc(job->arena, S_NODE);
+    pthread_mutex_unlock(job->lock);
+    if (node == NULL)
+      return (void*)1;
+    node[0] = i;
+  }
+  return NULL;
+}
+
+static double _bench_run(uint32_t s_threads, uint64_t count, bool sharded) {
+  Arena arena = arena_create_growable(1 << 20, 64, 0, 0);
+  if (arena == NULL)
+    return -1;
+
+  pthread_mutex_t lock;
+  pthread_mutex_init(&lock, NULL);
+
+  pthread_t threads[s_threads];
+  BenchJob job = { .arena = arena, .lock = &lock, .count = count };
+
+  bool failed = false;
+  double start = _bench_now();
+  for (uint32_t t = 0; t < s_threads; t++)
+    pthread_create(&threads[t], NULL, sharded ? _bench_shards : _bench_locked, &job);
+  for (uint32_t t = 0; t < s_threads; t++) {
+    void* result = NULL;
+    pthread_join(threads[t], &result);
+    failed |= result != NULL;
+  }
+  double elapsed = _bench_now() - start;
+
+  pthread_mutex_destroy(&lock);
+  arena_destroy(arena);
+  return failed ? -1 : elapsed;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  long s_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t max_threads = argc > 1 ? (uint32_t)atoi(argv[1]) : (uint32_t)(s_cpus > 0 ? s_cpus : 1);
+  uint64_t count = argc > 2 ? strtoull(argv[2], NULL, 10) : 1 << 22;
+  if (max_threads == 0 || count == 0) {
+    fprintf(stderr, "usage: arena_bench [threads] [allocations per thread]\n");
+    return 1;
+  }
+
+  fprintf(stdout, "%-8s %-14s %-14s %-14s %-14s\n", "threads", "shard Malloc/s", "shard speedup", "mutex Malloc/s", "mutex speedup");
+
+  double base_shard = 0, base_locked = 0;
+  for (uint32_t s_threads = 1; s_threads <= max_threads; s_threads++) {
+    double t_shard  = _bench_run(s_threads, count, true),
+           t_locked = _bench_run(s_threads, count, false);
+    if (t_shard < 0 || t_locked < 0) {
+      fprintf(stderr, "[BENCH]: arena allocation failed with %u threads\n", s_threads);
+      return 1;
+    }
+
+    double r_shard  = (double)(count * s_threads) / t_shard  / 1e6,
+           r_locked = (double)(count * s_threads) / t_locked / 1e6;
+    if (s_threads == 1) {
+      base_shard  = r_shard;
+      base_locked = r_locked;
+    }
+    fprintf(
+      stdout, "%-8u %-14.1f %-14.2f %-14.1f %-14.2f\n",
+      s_threads, r_shard, r_shard / base_shard, r_locked, r_locked / base_locked
+    );
+  }
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+// Files per second of `interpreter --batch` against running the interpreter once per file,
+// the way a build forks it, with as many processes at a time as the batch has threads.
+// Both sides compile the same generated .ld files, 1 and N jobs wide, printed as JSON.
+//
+//   batch_bench [interpreter] [files] [jobs]
+
+#ifndef BENCH_REVISION
+#define BENCH_REVISION "unknown"
+#endif
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// a few dozen small definitions in the style of test/test1.ld, different in every file
+static void _generate(FILE* file, uint32_t seed) {
+  fprintf(file, "let s = \\x, y, z -> x z (y z);\nlet k = \\x, y -> x;\n");
+  for (uint32_t i = 0; i < 60; i++) {
+    switch ((i + seed) % 5) {
+      case 0: fprintf(file, "let id%u = \\x -> x;\n", i); break;
+      case 1: fprintf(file, "let pair%u = \\a, b, f -> f a b;\n", i); break;
+      case 2: fprintf(file, "let num%u = \\f, x -> f (f (f x));\n", i); break;
+      case 3: fprintf(file, "let app%u = s k k;\n", i); break;
+      case 4: fprintf(file, "let add%u = \\n, m, f, x -> m f (n f x);\n", i); break;
+    }
+  }
+}
+
+static pid_t _bench_spawn(char* const argv[]) {
+  pid_t pid = fork();
+  if (pid != 0)
+    return pid;
+
+  // the trees printed for every file would otherwise be timed too
+  int32_t null = open("/dev/null", O_WRONLY);
+  if (null >= 0) {
+    dup2(null, STDOUT_FILENO);
+    dup2(null, STDERR_FILENO);
+  }
+  execv(argv[0], argv);
+  _exit(127);
+}
+
+static bool _bench_wait(void) {
+  int32_t status = 0;
+  return wait(&status) > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static double _bench_fork(const char* interpreter, char** paths, uint32_t s_files, uint32_t jobs, bool* ok) {
+  double start = _bench_now();
+  uint32_t running = 0;
+  for (uint32_t i = 0; i < s_files; i++) {
+    if (running == jobs) {
+      *ok = _bench_wait() && *ok;
+      running--;
+    }
+    char* argv[] = { (char*)interpreter, paths[i], NULL };
+    if (_bench_spawn(argv) < 0) {
+      *ok = false;
+      continue;
+    }
+    running++;
+  }
+  for (; running > 0; running--)
+    *ok = _bench_wait() && *ok;
+  return _bench_now() - start;
+}
+
+static double _bench_batch(const char* interpreter, const char* dir, uint32_t jobs, bool* ok) {
+  char s_jobs[32];
+  snprintf(s_jobs, sizeof(s_jobs), "--jobs=%u", jobs);
+  char* argv[] = { (char*)interpreter, "--batch", s_jobs, (char*)dir, NULL };
+
+  double start = _bench_now();
+  if (_bench_spawn(argv) < 0)
+    *ok = false;
+  else
+    *ok = _bench_wait() && *ok;
+  return _bench_now() - start;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  const char* interpreter = argc > 1 ? argv[1] : "bin/interpreter";
+  uint32_t s_files = argc > 2 ? (uint32_t)atoi(argv[2]) : 1000,
+           jobs    = argc > 3 ? (uint32_t)atoi(argv[3]) : (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+  if (s_files == 0 || jobs == 0 || access(interpreter, X_OK) != 0) {
+    fprintf(stderr, "usage: batch_bench [interpreter] [files] [jobs]\n");
+    return 1;
+  }
+
+  char dir[64];
+  snprintf(dir, sizeof(dir), "/tmp/batch_bench_%d", (int32_t)getpid());
+  if (mkdir(dir, 0700) != 0) {
+    fprintf(stderr, "[BENCH]: could not create %s\n", dir);
+    return 1;
+  }
+
+  char** paths = (char**)malloc(s_files * sizeof(char*));
+  if (paths == NULL)
+    return 1;
+  for (uint32_t i = 0; i < s_files; i++) {
+    paths[i] = (char*)malloc(sizeof(dir) + 32);
+    if (paths[i] == NULL)
+      return 1;
+    snprintf(paths[i], sizeof(dir) + 32, "%s/f%05u.ld", dir, i);
+    FILE* file = fopen(paths[i], "w");
+    if (file == NULL) {
+      fprintf(stderr, "[BENCH]: could not write %s\n", paths[i]);
+      return 1;
+    }
+    _generate(file, i);
+    fclose(file);
+  }
+
+  fprintf(stdout, "{\n  \"revision\": \"%s\",\n  \"files\": %u,\n  \"runs\": [", BENCH_REVISION, s_files);
+  uint32_t widths[2] = { 1, jobs };
+  bool ok = true;
+  for (uint32_t i = 0; i < (jobs > 1 ? 2u : 1u); i++) {
+    double t_fork  = _bench_fork(interpreter, paths, s_files, widths[i], &ok),
+           t_batch = _bench_batch(interpreter, dir, widths[i], &ok);
+    fprintf(
+      stdout, "%s\n    { \"jobs\": %u, \"fork_s\": %.3f, \"batch_s\": %.3f, \"fork_files_per_s\": %.1f,"
+      " \"batch_files_per_s\": %.1f, \"speedup\": %.2f }",
+      i > 0 ? "," : "", widths[i], t_fork, t_batch, s_files / t_fork, s_files / t_batch, t_fork / t_batch
+    );
+  }
+  fprintf(stdout, "\n  ]\n}\n");
+
+  // every file left its .sk behind, the directory goes with them
+  for (uint32_t i = 0; i < s_files; i++) {
+    char* dot = strrchr(paths[i], '.');
+    remove(paths[i]);
+    strcpy(dot, ".sk");
+    remove(paths[i]);
+    free(paths[i]);
+  }
+  free(paths);
+  rmdir(dir);
+
+  if (!ok)
+    fprintf(stderr, "[BENCH]: some runs of %s failed\n", interpreter);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parser.tab.h"
+#include "interpreter_priv.h"
+#include "scanner.h"
+#include "diagnostics.h"
+
+// Locality and cost of compacting converted SK terms. For every program the terms out of bracket
+// abstraction are walked before and after _skt_compact, counting the edges whose child lies in the
+// same 64 byte line as its parent or the next one ("near") and those that cross a 4 KiB page, for
+// every edge and for the spine (left) edges alone. Then ast_convert is timed with every
+// skt_set_compact mode. Printed as JSON.
+//
+//   compact_bench [iterations]   runs the suite
+//   compact_bench KIND SIZE      prints the generated program instead
+
+extern __thread Scanner* scanner;
+extern __thread Diagnostics* parser_diagnostics;
+
+__thread const char* filename;
+__thread Arena arena = NULL;
+__thread AST*  ast   = NULL;
+
+typedef struct bench_program {
+  const char* kind;
+  void      (*generate)(FILE*, uint32_t);
+  uint32_t    sizes[3];
+} BenchProgram;
+
+typedef struct bench_edges {
+  uint64_t s_edges, s_near, s_pages;
+  uint64_t s_spine, s_spine_near, s_spine_pages;
+} BenchEdges;
+
+static void _generate_church (FILE* file, uint32_t size);
+static void _generate_wide   (FILE* file, uint32_t size);
+static void _generate_nested (FILE* file, uint32_t size);
+static void _generate_huge   (FILE* file, uint32_t size);
+
+static const BenchProgram programs[] = {
+  { "church", _generate_church, { 256,  1024,  4096   } },
+  { "wide",   _generate_wide,   { 8,    12,    16     } },
+  { "nested", _generate_nested, { 8,    12,    16     } },
+  { "huge",   _generate_huge,   { 1000, 10000, 100000 } }
+};
+static const size_t s_programs = sizeof(programs) / sizeof(programs[0]);
+
+static const char* modes[] = { "off", "convert", "phases" };
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// a numeral nested size deep applied to suc and zero, the programs are those of phase_bench
+static void _generate_church(FILE* file, uint32_t size) {
+  fprintf(file, "let zero = \\f, x -> x;\n");
+  fprintf(file, "let suc = \\n, f, x -> f (n f x);\n");
+  fprintf(file, "let deep = \\f, x -> ");
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "f (");
+  fprintf(file, "x");
+  for (uint32_t i = 0; i < size; i++)
+    fputc(')', file);
+  fprintf(file, ";\n");
+  fprintf(file, "let count = deep suc zero;\n");
+}
+
+static void _generate_wide(FILE* file, uint32_t size) {
+  for (uint32_t j = 0; j < 8; j++) {
+    fprintf(file, "let w%u = \\", j);
+    for (uint32_t i = 0; i < size; i++)
+      fprintf(file, "%sx%u", i > 0 ? ", " : "", i);
+    fprintf(file, " ->");
+    for (uint32_t i = 0; i < size; i++)
+      fprintf(file, " x%u", (i * (j + 1)) % size);
+    fprintf(file, ";\n");
+  }
+}
+
+static void _generate_nested(FILE* file, uint32_t size) {
+  fprintf(file, "let nest = ");
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "\\x%u -> ", i);
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "%s(x%u x%u)", i > 0 ? " " : "", i, (i * 7 + 3) % size);
+  fprintf(file, ";\n");
+}
+
+static void _generate_huge(FILE* file, uint32_t size) {
+  fprintf(file, "let s = \\x, y, z -> x z (y z);\nlet k = \\x, y -> x;\n");
+  for (uint32_t i = 0; i < size; i++) {
+    switch (i % 6) {
+      case 0: fprintf(file, "let id%u = \\x -> x;\n", i); break;
+      case 1: fprintf(file, "let pair%u = \\a, b, f -> f a b;\n", i); break;
+      case 2: fprintf(file, "let num%u = \\f, x -> f (f (f x));\n", i); break;
+      case 3: fprintf(file, "let app%u = s k k;\n", i); break;
+      case 4: fprintf(file, "let add%u = \\n, m, f, x -> m f (n f x);\n", i); break;
+      case 5: fprintf(file, "let use%u = pair%u (num%u) (id%u);\n", i, i - 4, i - 3, i - 5); break;
+    }
+  }
+}
+
+static void _bench_edge(BenchEdges* edges, const SK_Tree* parent, const SK_Tree* child, bool spine) {
+  uintptr_t from = (uintptr_t)parent, to = (uintptr_t)child;
+  bool near  = to / 64 == from / 64 || to / 64 == from / 64 + 1,
+       pages = to / 4096 != from / 4096;
+  edges->s_edges++;
+  edges->s_near  += near;
+  edges->s_pages += pages;
+  if (spine) {
+    edges->s_spine++;
+    edges->s_spine_near  += near;
+    edges->s_spine_pages += pages;
+  }
+}
+
+// a REF is shared, what it points to is not walked again
+static void _bench_walk(BenchEdges* edges, const SK_Tree* node) {
+  for (; node != NULL && node->type == APP_NODE; node = node->left) {
+    _bench_edge(edges, node, node->left, true);
+    _bench_edge(edges, node, node->right, false);
+    _bench_walk(edges, node->right);
+  }
+}
+
+static bool _bench_load(const char* path, Diagnostics* diagnostics, HashTable* table) {
+  arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+  ast = NULL;
+  parser_diagnostics = diagnostics;
+  *table = NULL;
+
+  scanner = scanner_open(arena, path);
+  if (scanner != NULL) {
+    size_t s_source = 0;
+    const char* source = scanner_get_source(scanner, &s_source);
+    diagnostics_set_source(diagnostics, source, s_source);
+    (void)yyparse();
+  }
+  if (ast == NULL)
+    return false;
+  *table = ast_check(ast, 1 << 5, diagnostics);
+  if (*table == NULL)
+    return false;
+  ast_transform(arena, ast);
+  ast_resolve(ast, *table);
+  return true;
+}
+
+static void _bench_unload(Diagnostics* diagnostics, HashTable table) {
+  (void)diagnostics_flush(diagnostics, stderr);
+  if (table != NULL)
+    hashtable_free(table);
+  scanner_close(scanner);
+  scanner = NULL;
+  arena_destroy(arena);
+}
+
+// the terms bracket abstraction gives, as they are and once compacted
+static bool _bench_locality(const char* path, BenchEdges* before, BenchEdges* after) {
+  Diagnostics* diagnostics = diagnostics_create(path);
+  HashTable table = NULL;
+  bool ok = _bench_load(path, diagnostics, &table);
+  if (ok) {
+    Arena scratch = arena_shard_create(arena);
+    assert(scratch != NULL);
+    SKT_Spaces spaces = { .arenas = { scratch, arena_shard(arena) }, .current = 0 };
+    spaces.marks[0] = arena_mark(spaces.arenas[0]);
+    spaces.marks[1] = arena_mark(spaces.arenas[1]);
+
+    for (ASTN_Stmt* stmt = ast->stmts; stmt != NULL; stmt = stmt->next) {
+      SK_Tree* root = _ast_expr_convert(spaces.arenas[spaces.current], stmt->expr, NULL, diagnostics);
+      _bench_walk(before, root);
+      root = _skt_compact(&spaces, root);
+      _bench_walk(after, root);
+      // later statements refer to it, it is evacuated into the arena unreduced
+      (void)_ast_stmt_define(arena, spaces.arenas[spaces.current], stmt, root);
+      (void)arena_release(spaces.arenas[spaces.current], spaces.marks[spaces.current]);
+    }
+    ok = diagnostics_count(diagnostics) == 0;
+  }
+  _bench_unload(diagnostics, table);
+  diagnostics_destroy(diagnostics);
+  return ok;
+}
+
+static bool _bench_convert(const char* path, SK_Compact mode, double* t_convert) {
+  Diagnostics* diagnostics = diagnostics_create(path);
+  HashTable table = NULL;
+  bool ok = _bench_load(path, diagnostics, &table);
+  if (ok) {
+    skt_set_compact(mode);
+    double start = _bench_now();
+    (void)ast_convert(arena, ast, table, diagnostics);
+    *t_convert += _bench_now() - start;
+    ok = diagnostics_count(diagnostics) == 0;
+  }
+  _bench_unload(diagnostics, table);
+  diagnostics_destroy(diagnostics);
+  return ok;
+}
+
+static void _bench_print_edges(const char* name, const BenchEdges* edges) {
+  fprintf(stdout, " \"%s\": { \"edges\": %lu, \"near\": %.3f, \"pages\": %.3f, \"spine_near\": %.3f, \"spine_pages\": %.3f },",
+    name, (unsigned long)edges->s_edges,
+    edges->s_edges > 0 ? (double)edges->s_near / (double)edges->s_edges : 0,
+    edges->s_edges > 0 ? (double)edges->s_pages / (double)edges->s_edges : 0,
+    edges->s_spine > 0 ? (double)edges->s_spine_near / (double)edges->s_spine : 0,
+    edges->s_spine > 0 ? (double)edges->s_spine_pages / (double)edges->s_spine : 0);
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  if (argc == 3 && (argv[1][0] < '0' || argv[1][0] > '9')) {
+    for (size_t i = 0; i < s_programs; i++) {
+      if (strcmp(argv[1], programs[i].kind) == 0) {
+        programs[i].generate(stdout, (uint32_t)atoi(argv[2]));
+        return 0;
+      }
+    }
+    fprintf(stderr, "[BENCH]: unknown program kind %s (church, wide, nested, huge)\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t iterations = argc > 1 ? (uint32_t)atoi(argv[1]) : 3;
+  if (iterations == 0) {
+    fprintf(stderr, "usage: compact_bench [iterations]\n       compact_bench church|wide|nested|huge SIZE\n");
+    return 1;
+  }
+
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/compact_bench_%d.ld", (int32_t)getpid());
+  filename = path;
+
+  fprintf(stdout, "{\n  \"iterations\": %u,\n  \"runs\": [", iterations);
+  bool ok = true, first = true;
+  for (size_t i = 0; i < s_programs; i++) {
+    for (size_t j = 0; j < sizeof(programs[i].sizes) / sizeof(programs[i].sizes[0]); j++) {
+      uint32_t size = programs[i].sizes[j];
+
+      FILE* file = fopen(path, "w");
+      if (file == NULL) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", path);
+        return 1;
+      }
+      programs[i].generate(file, size);
+      fclose(file);
+
+      BenchEdges before = { 0 }, after = { 0 };
+      double t_convert[3] = { 0 };
+      bool done = _bench_locality(path, &before, &after);
+      for (uint32_t n = 0; n < iterations && done; n++)
+        for (size_t m = 0; m < 3 && done; m++)
+          done = _bench_convert(path, (SK_Compact)m, &t_convert[m]);
+      if (!done) {
+        fprintf(stderr, "[BENCH]: %s %u failed\n", programs[i].kind, size);
+        ok = false;
+        continue;
+      }
+
+      fprintf(stdout, "%s\n    {", first ? "" : ",");
+      fprintf(stdout, " \"program\": \"%s\", \"size\": %u,", programs[i].kind, size);
+      _bench_print_edges("converted", &before);
+      _bench_print_edges("compacted", &after);
+      for (size_t m = 0; m < 3; m++)
+        fprintf(stdout, " \"convert_%s_ms\": %.3f%s", modes[m], 1e3 * t_convert[m] / iterations, m < 2 ? "," : " }");
+      first = false;
+    }
+  }
+  fprintf(stdout, "\n  ]\n}\n");
+
+  remove(path);
+  return ok ? 0 : 1;
+}
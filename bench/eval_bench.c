@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parser.tab.h"
+#include "ast_priv.h"
+#include "interpreter.h"
+#include "skeval.h"
+#include "sksuper.h"
+#include "sknet.h"
+#include "scanner.h"
+#include "diagnostics.h"
+
+// The backends on Church arithmetic: ast_convert (bracket abstraction, then S and K reduction)
+// against ast_evaluate (the Krivine machine, then bracket abstraction of the normal form),
+// ast_supercombine (lambda lifting and graph reduction, then the same bracket abstraction) and
+// ast_interact (an interaction net on one thread, then the same bracket abstraction). The last
+// definition of every program is a numeral, read by applying its root to two fresh names and
+// reducing it with skt_beta_redu until it is f (... (f x)). The SK roots are only reduced at the
+// head, so for them that is where the arithmetic happens, and both times are printed as JSON with
+// the SK reductions, the machine steps, the supercombinator instantiations and the interactions.
+//
+//   eval_bench [iterations]   runs the suite
+//   eval_bench KIND SIZE      prints the generated program instead
+
+extern __thread Scanner* scanner;
+extern __thread Diagnostics* parser_diagnostics;
+
+__thread const char* filename;
+__thread Arena arena = NULL;
+__thread AST*  ast   = NULL;
+
+typedef struct bench_program {
+  const char* kind;
+  void      (*generate)(FILE*, uint32_t);
+  uint32_t    sizes[3];
+} BenchProgram;
+
+typedef struct bench_backend {
+  const char* name;
+  SK_Tree** (*convert)(Arena, AST*, HashTable, Diagnostics*);
+} BenchBackend;
+
+typedef struct bench_run {
+  double   t_convert, t_read;
+  uint64_t s_reductions, s_steps, s_super, s_net;
+  int64_t  value;
+} BenchRun;
+
+static void _generate_parity (FILE* file, uint32_t size);
+static void _generate_square (FILE* file, uint32_t size);
+static void _generate_sum    (FILE* file, uint32_t size);
+
+static const BenchProgram programs[] = {
+  { "parity", _generate_parity, { 6,  8,  10  } },
+  { "square", _generate_square, { 4,  6,  8   } },
+  { "sum",    _generate_sum,    { 32, 64, 128 } }
+};
+static const size_t s_programs = sizeof(programs) / sizeof(programs[0]);
+
+static const BenchBackend backends[] = {
+  { "sk",      ast_convert  },
+  { "krivine", ast_evaluate     },
+  { "super",   ast_supercombine },
+  { "net",     ast_interact     }
+};
+static const size_t s_backends = sizeof(backends) / sizeof(backends[0]);
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void _generate_prelude(FILE* file) {
+  fprintf(file, "let true = \\x, y -> x;\nlet false = \\x, y -> y;\nlet not = \\p -> p false true;\n");
+  fprintf(file, "let zero = \\f, x -> x;\nlet one = \\f, x -> f x;\nlet two = \\f, x -> f (f x);\n");
+  fprintf(file, "let suc = \\n, f, x -> f (n f x);\n");
+  fprintf(file, "let add = \\n, m, f, x -> m f (n f x);\nlet mul = \\n, m, f -> n (m f);\nlet exp = \\b, n -> n b;\n");
+  fprintf(file, "let pair = \\a, b, f -> f a b;\nlet fst = \\p -> p true;\nlet snd = \\p -> p false;\n");
+  fprintf(file, "let next = \\p -> pair (snd p) (suc (snd p));\nlet pre = \\n -> fst (n next (pair zero zero));\n");
+  fprintf(file, "let sub = \\n, m -> m pre n;\n");
+}
+
+// a numeral written out as size applications
+static void _generate_numeral(FILE* file, const char* name, uint32_t size) {
+  fprintf(file, "let %s = \\f, x -> ", name);
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "f (");
+  fprintf(file, "x");
+  for (uint32_t i = 0; i < size; i++)
+    fputc(')', file);
+  fprintf(file, ";\n");
+}
+
+// 2^size negations of true, the answer is one
+static void _generate_parity(FILE* file, uint32_t size) {
+  _generate_prelude(file);
+  _generate_numeral(file, "n", size);
+  fprintf(file, "let r = exp two n not true one zero;\n");
+}
+
+// size^2 - size (size - 1) through pre, which rebuilds a pair for every step, the answer is size
+static void _generate_square(FILE* file, uint32_t size) {
+  _generate_prelude(file);
+  _generate_numeral(file, "n", size);
+  fprintf(file, "let r = sub (mul n n) (mul n (pre n));\n");
+}
+
+// size definitions, each adding one to the one before it, the answer is size
+static void _generate_sum(FILE* file, uint32_t size) {
+  _generate_prelude(file);
+  fprintf(file, "let s0 = zero;\n");
+  for (uint32_t i = 1; i <= size; i++)
+    fprintf(file, "let s%u = add one s%u;\n", i, i - 1);
+}
+
+static SK_Tree* _bench_node(uint32_t type, SK_Tree* left, SK_Tree* right, ASTN_Ident* ident) {
+  SK_Tree* node = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
+  assert(node != NULL);
+  *node = (SK_Tree){ .type = type, .span = 0, .left = left, .right = right, .ld_ident = ident };
+  return node;
+}
+
+static SK_Tree* _bench_strip(SK_Tree* node) {
+  while (node->type == REF_NODE)
+    node = node->left;
+  return node;
+}
+
+// skt_copy copies the names of the terms it unfolds, they are told apart by their string
+static bool _bench_is_name(SK_Tree* node, const char* name) {
+  return node->type == LD_NODE && strcmp(node->ld_ident->token->str, name) == 0;
+}
+
+// the number of f applied to x, or -1 when the root is not a numeral
+static int64_t _bench_read(SK_Tree* root) {
+  static struct astn_token f_token = { .str = "f" }, x_token = { .str = "x" };
+  static struct astn_id    f = { .token = &f_token }, x = { .token = &x_token };
+  SK_Tree* term = _bench_node(APP_NODE, _bench_node(APP_NODE, root, _bench_node(LD_NODE, NULL, NULL, &f), NULL), _bench_node(LD_NODE, NULL, NULL, &x), NULL);
+
+  // skt_beta_redu stops after MAX_BETA_REDUCTIONS steps, it is called until it does nothing
+  for (int64_t value = 0;;) {
+    uint64_t s_reductions = skt_get_reductions();
+    term = _bench_strip(skt_beta_redu(arena, term));
+    if (skt_get_reductions() != s_reductions)
+      continue;
+    if (_bench_is_name(term, "x"))
+      return value;
+    if (term->type != APP_NODE || !_bench_is_name(_bench_strip(term->left), "f"))
+      return -1;
+    term = term->right;
+    value++;
+  }
+}
+
+static bool _bench_iteration(const char* path, const BenchBackend* backend, BenchRun* run) {
+  arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+  ast = NULL;
+  Diagnostics* diagnostics = diagnostics_create(path);
+  parser_diagnostics = diagnostics;
+  HashTable table = NULL;
+  bool ok = false;
+
+  scanner = scanner_open(arena, path);
+  if (scanner != NULL) {
+    size_t s_source = 0;
+    const char* source = scanner_get_source(scanner, &s_source);
+    diagnostics_set_source(diagnostics, source, s_source);
+    (void)yyparse();
+  }
+  if (ast == NULL)
+    goto done;
+  table = ast_check(ast, 1 << 5, diagnostics);
+  if (table == NULL)
+    goto done;
+  ast_transform(arena, ast);
+  ast_resolve(ast, table);
+
+  uint64_t s_reductions = skt_get_reductions(),
+           s_steps      = ske_get_steps(),
+           s_super      = sks_get_steps(),
+           s_net        = skn_get_steps();
+  double start = _bench_now();
+  SK_Tree** roots = backend->convert(arena, ast, table, diagnostics);
+  double end = _bench_now();
+  run->t_convert += end - start;
+
+  start = end;
+  run->value = _bench_read(roots[ast->s_stmts - 1]);
+  run->t_read += _bench_now() - start;
+  run->s_reductions = skt_get_reductions() - s_reductions;
+  run->s_steps      = ske_get_steps() - s_steps;
+  run->s_super      = sks_get_steps() - s_super;
+  run->s_net        = skn_get_steps() - s_net;
+  ok = diagnostics_count(diagnostics) == 0;
+
+done:
+  (void)diagnostics_flush(diagnostics, stderr);
+  if (table != NULL)
+    hashtable_free(table);
+  scanner_close(scanner);
+  scanner = NULL;
+  diagnostics_destroy(diagnostics);
+  arena_destroy(arena);
+  return ok;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  if (argc == 3 && (argv[1][0] < '0' || argv[1][0] > '9')) {
+    for (size_t i = 0; i < s_programs; i++) {
+      if (strcmp(argv[1], programs[i].kind) == 0) {
+        programs[i].generate(stdout, (uint32_t)atoi(argv[2]));
+        return 0;
+      }
+    }
+    fprintf(stderr, "[BENCH]: unknown program kind %s (parity, square, sum)\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t iterations = argc > 1 ? (uint32_t)atoi(argv[1]) : 3;
+  if (iterations == 0) {
+    fprintf(stderr, "usage: eval_bench [iterations]\n       eval_bench parity|square|sum SIZE\n");
+    return 1;
+  }
+
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/eval_bench_%d.ld", (int32_t)getpid());
+  filename = path;
+
+  fprintf(stdout, "{\n  \"iterations\": %u,\n  \"runs\": [", iterations);
+  bool ok = true, first = true;
+  for (size_t i = 0; i < s_programs; i++) {
+    for (size_t j = 0; j < sizeof(programs[i].sizes) / sizeof(programs[i].sizes[0]); j++) {
+      uint32_t size = programs[i].sizes[j];
+
+      FILE* file = fopen(path, "w");
+      if (file == NULL) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", path);
+        return 1;
+      }
+      programs[i].generate(file, size);
+      fclose(file);
+
+      int64_t value = 0;
+      for (size_t k = 0; k < s_backends; k++) {
+        BenchRun run = { 0 };
+        bool done = true;
+        for (uint32_t n = 0; n < iterations && done; n++)
+          done = _bench_iteration(path, &backends[k], &run);
+        if (!done) {
+          fprintf(stderr, "[BENCH]: %s %u failed on the %s backend\n", programs[i].kind, size, backends[k].name);
+          ok = false;
+          continue;
+        }
+
+        // the backends must agree on every numeral
+        if (k == 0)
+          value = run.value;
+        else if (run.value != value) {
+          fprintf(stderr, "[BENCH]: %s %u is %ld on the %s backend and %ld on the %s one\n",
+            programs[i].kind, size, (long)run.value, backends[k].name, (long)value, backends[0].name);
+          ok = false;
+        }
+
+        fprintf(stdout, "%s\n    {", first ? "" : ",");
+        fprintf(stdout, " \"program\": \"%s\", \"size\": %u, \"backend\": \"%s\", \"value\": %ld,", programs[i].kind, size, backends[k].name, (long)run.value);
+        fprintf(stdout, " \"convert_ms\": %.3f, \"read_ms\": %.3f, \"total_ms\": %.3f,", 1e3 * run.t_convert / iterations, 1e3 * run.t_read / iterations, 1e3 * (run.t_convert + run.t_read) / iterations);
+        fprintf(stdout, " \"reductions\": %lu, \"machine_steps\": %lu, \"super_steps\": %lu, \"net_steps\": %lu }",
+          (unsigned long)run.s_reductions, (unsigned long)run.s_steps, (unsigned long)run.s_super, (unsigned long)run.s_net);
+        first = false;
+      }
+    }
+  }
+  fprintf(stdout, "\n  ]\n}\n");
+
+  remove(path);
+  return ok ? 0 : 1;
+}
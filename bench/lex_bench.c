@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "parser.tab.h"
+#include "ast_priv.h"
+#include "scanner.h"
+
+// Tokens per second of the flex lexer against the mapped scanner on the same .ld source,
+// next to a plain memchr pass over the file as the memory bandwidth ceiling.
+
+extern FILE* yyin;
+extern int yylex_destroy(void);
+extern int32_t yylex(YYSTYPE* yylval, YYLTYPE* yylloc);
+extern __thread Scanner* scanner;
+
+__thread Arena arena = NULL;
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static size_t _bench_lex(void) {
+  YYSTYPE lval;
+  YYLTYPE lloc;
+  size_t s_tokens = 0;
+  for (; yylex(&lval, &lloc) > 0; s_tokens++);
+  return s_tokens;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  const char* filename = argc > 1 ? argv[1] : "test/test1.ld";
+  uint32_t iterations = argc > 2 ? (uint32_t)atoi(argv[2]) : 20;
+  if (iterations == 0) {
+    fprintf(stderr, "usage: lex_bench [file.ld] [iterations]\n");
+    return 1;
+  }
+
+  struct stat st;
+  if (stat(filename, &st) != 0) {
+    fprintf(stderr, "[BENCH]: could not stat %s\n", filename);
+    return 1;
+  }
+
+  double t_flex = 0, t_scan = 0, t_memchr = 0;
+  size_t s_flex = 0, s_scan = 0, s_lines = 0;
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+
+    double start = _bench_now();
+    yyin = fopen(filename, "r");
+    if (yyin == NULL) {
+      fprintf(stderr, "[BENCH]: could not open %s\n", filename);
+      return 1;
+    }
+    s_flex = _bench_lex();
+    fclose(yyin);
+    yylex_destroy();
+    t_flex += _bench_now() - start;
+
+    arena_destroy(arena);
+  }
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+
+    double start = _bench_now();
+    scanner = scanner_open(arena, filename);
+    if (scanner == NULL)
+      return 1;
+    s_scan = _bench_lex();
+    scanner_close(scanner);
+    scanner = NULL;
+    t_scan += _bench_now() - start;
+
+    arena_destroy(arena);
+  }
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL)
+      return 1;
+
+    double start = _bench_now();
+    char* buffer = (char*)malloc((size_t)st.st_size + 1);
+    size_t s_buffer = fread(buffer, 1, (size_t)st.st_size, file);
+    s_lines = 0;
+    for (const char* c = buffer; (c = memchr(c, '\n', s_buffer - (size_t)(c - buffer))) != NULL; c++, s_lines++);
+    t_memchr += _bench_now() - start;
+
+    free(buffer);
+    fclose(file);
+  }
+
+  if (s_flex != s_scan)
+    fprintf(stderr, "[BENCH]: flex saw %zu tokens and the scanner %zu\n", s_flex, s_scan);
+
+  double s_mb = (double)st.st_size * iterations / 1e6;
+  fprintf(stdout, "%zu bytes, %zu lines, %zu tokens\n", (size_t)st.st_size, s_lines, s_scan);
+  fprintf(stdout, "%-10s %-12s %-12s\n", "lexer", "ms/run", "MB/s");
+  fprintf(stdout, "%-10s %-12.3f %-12.1f\n", "flex",    1e3 * t_flex / iterations,   s_mb / t_flex);
+  fprintf(stdout, "%-10s %-12.3f %-12.1f\n", "scanner", 1e3 * t_scan / iterations,   s_mb / t_scan);
+  fprintf(stdout, "%-10s %-12.3f %-12.1f\n", "memchr",  1e3 * t_memchr / iterations, s_mb / t_memchr);
+
+  return s_flex == s_scan ? 0 : 1;
+}
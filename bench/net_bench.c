@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parser.tab.h"
+#include "ast_priv.h"
+#include "interpreter.h"
+#include "sknet.h"
+#include "scanner.h"
+#include "diagnostics.h"
+
+// Core scaling of ast_interact on Church exponentiation: 2^size negations of true, and size^size
+// negations out of a numeral applied to itself, whose duplicators meet copies of themselves. The
+// program is reduced on 1, 2, 4, ... online CPUs threads, its last definition read as a numeral
+// like in eval_bench, and the times, the interactions and the speedup over one thread are printed
+// as JSON.
+//
+//   net_bench [iterations]   runs the suite
+//   net_bench KIND SIZE      prints the generated program instead
+
+extern __thread Scanner* scanner;
+extern __thread Diagnostics* parser_diagnostics;
+
+__thread const char* filename;
+__thread Arena arena = NULL;
+__thread AST*  ast   = NULL;
+
+typedef struct bench_program {
+  const char* kind;
+  void      (*generate)(FILE*, uint32_t);
+  uint32_t    sizes[3];
+} BenchProgram;
+
+typedef struct bench_run {
+  double   t_convert;
+  uint64_t s_steps;
+  int64_t  value;
+} BenchRun;
+
+static void _generate_parity (FILE* file, uint32_t size);
+static void _generate_self   (FILE* file, uint32_t size);
+
+static const BenchProgram programs[] = {
+  { "parity", _generate_parity, { 10, 12, 14 } },
+  { "self",   _generate_self,   { 3,  4,  5  } }
+};
+static const size_t s_programs = sizeof(programs) / sizeof(programs[0]);
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void _generate_prelude(FILE* file, uint32_t size) {
+  fprintf(file, "let true = \\x, y -> x;\nlet false = \\x, y -> y;\nlet not = \\p -> p false true;\n");
+  fprintf(file, "let zero = \\f, x -> x;\nlet one = \\f, x -> f x;\nlet two = \\f, x -> f (f x);\n");
+  fprintf(file, "let exp = \\b, n -> n b;\nlet n = \\f, x -> ");
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "f (");
+  fprintf(file, "x");
+  for (uint32_t i = 0; i < size; i++)
+    fputc(')', file);
+  fprintf(file, ";\n");
+}
+
+// the answer is one
+static void _generate_parity(FILE* file, uint32_t size) {
+  _generate_prelude(file, size);
+  fprintf(file, "let r = exp two n not true one zero;\n");
+}
+
+// an odd number of negations starts from false
+static void _generate_self(FILE* file, uint32_t size) {
+  _generate_prelude(file, size);
+  fprintf(file, "let r = (\\y -> y y) n not %s one zero;\n", size % 2 == 0 ? "true" : "false");
+}
+
+static SK_Tree* _bench_node(uint32_t type, SK_Tree* left, SK_Tree* right, ASTN_Ident* ident) {
+  SK_Tree* node = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
+  assert(node != NULL);
+  *node = (SK_Tree){ .type = type, .span = 0, .left = left, .right = right, .ld_ident = ident };
+  return node;
+}
+
+static SK_Tree* _bench_strip(SK_Tree* node) {
+  while (node->type == REF_NODE)
+    node = node->left;
+  return node;
+}
+
+static bool _bench_is_name(SK_Tree* node, const char* name) {
+  return node->type == LD_NODE && strcmp(node->ld_ident->token->str, name) == 0;
+}
+
+// the number of f applied to x, or -1 when the root is not a numeral
+static int64_t _bench_read(SK_Tree* root) {
+  static struct astn_token f_token = { .str = "f" }, x_token = { .str = "x" };
+  static struct astn_id    f = { .token = &f_token }, x = { .token = &x_token };
+  SK_Tree* term = _bench_node(APP_NODE, _bench_node(APP_NODE, root, _bench_node(LD_NODE, NULL, NULL, &f), NULL), _bench_node(LD_NODE, NULL, NULL, &x), NULL);
+
+  for (int64_t value = 0;;) {
+    uint64_t s_reductions = skt_get_reductions();
+    term = _bench_strip(skt_beta_redu(arena, term));
+    if (skt_get_reductions() != s_reductions)
+      continue;
+    if (_bench_is_name(term, "x"))
+      return value;
+    if (term->type != APP_NODE || !_bench_is_name(_bench_strip(term->left), "f"))
+      return -1;
+    term = term->right;
+    value++;
+  }
+}
+
+static bool _bench_iteration(const char* path, uint32_t s_threads, BenchRun* run) {
+  arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+  ast = NULL;
+  Diagnostics* diagnostics = diagnostics_create(path);
+  parser_diagnostics = diagnostics;
+  HashTable table = NULL;
+  bool ok = false;
+
+  scanner = scanner_open(arena, path);
+  if (scanner != NULL) {
+    size_t s_source = 0;
+    const char* source = scanner_get_source(scanner, &s_source);
+    diagnostics_set_source(diagnostics, source, s_source);
+    (void)yyparse();
+  }
+  if (ast == NULL)
+    goto done;
+  table = ast_check(ast, 1 << 5, diagnostics);
+  if (table == NULL)
+    goto done;
+  ast_transform(arena, ast);
+  ast_resolve(ast, table);
+
+  skn_set_threads(s_threads);
+  uint64_t s_steps = skn_get_steps();
+  double start = _bench_now();
+  SK_Tree** roots = ast_interact(arena, ast, table, diagnostics);
+  run->t_convert += _bench_now() - start;
+  run->s_steps = skn_get_steps() - s_steps;
+  run->value   = _bench_read(roots[ast->s_stmts - 1]);
+  ok = diagnostics_count(diagnostics) == 0;
+
+done:
+  (void)diagnostics_flush(diagnostics, stderr);
+  if (table != NULL)
+    hashtable_free(table);
+  scanner_close(scanner);
+  scanner = NULL;
+  diagnostics_destroy(diagnostics);
+  arena_destroy(arena);
+  return ok;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  if (argc == 3 && (argv[1][0] < '0' || argv[1][0] > '9')) {
+    for (size_t i = 0; i < s_programs; i++) {
+      if (strcmp(argv[1], programs[i].kind) == 0) {
+        programs[i].generate(stdout, (uint32_t)atoi(argv[2]));
+        return 0;
+      }
+    }
+    fprintf(stderr, "[BENCH]: unknown program kind %s (parity, self)\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t iterations = argc > 1 ? (uint32_t)atoi(argv[1]) : 3;
+  if (iterations == 0) {
+    fprintf(stderr, "usage: net_bench [iterations]\n       net_bench parity|self SIZE\n");
+    return 1;
+  }
+
+  char path[64];
+  snprintf(path, sizeof(path), "/tmp/net_bench_%d.ld", (int32_t)getpid());
+  filename = path;
+
+  long s_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t max_threads = s_cpus > 1 ? (uint32_t)s_cpus : 2;
+
+  fprintf(stdout, "{\n  \"iterations\": %u,\n  \"cpus\": %ld,\n  \"runs\": [", iterations, s_cpus);
+  bool ok = true, first = true;
+  for (size_t i = 0; i < s_programs; i++) {
+    for (size_t j = 0; j < sizeof(programs[i].sizes) / sizeof(programs[i].sizes[0]); j++) {
+      uint32_t size = programs[i].sizes[j];
+
+      FILE* file = fopen(path, "w");
+      if (file == NULL) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", path);
+        return 1;
+      }
+      programs[i].generate(file, size);
+      fclose(file);
+
+      // one thread, then doubling up to the online CPUs, the last step cut to them
+      double t_single = 0;
+      for (uint32_t s_threads = 1;; s_threads = 2 * s_threads < max_threads ? 2 * s_threads : max_threads) {
+        BenchRun run = { 0 };
+        bool done = true;
+        for (uint32_t n = 0; n < iterations && done; n++)
+          done = _bench_iteration(path, s_threads, &run);
+        if (!done || run.value != 1) {
+          fprintf(stderr, "[BENCH]: %s %u on %u threads %s\n", programs[i].kind, size, s_threads, done ? "is not one" : "failed");
+          ok = false;
+        }
+
+        double t_convert = run.t_convert / iterations;
+        if (s_threads == 1)
+          t_single = t_convert;
+        fprintf(stdout, "%s\n    {", first ? "" : ",");
+        fprintf(stdout, " \"program\": \"%s\", \"size\": %u, \"threads\": %u, \"value\": %ld,", programs[i].kind, size, s_threads, (long)run.value);
+        fprintf(stdout, " \"convert_ms\": %.3f, \"interactions\": %lu, \"speedup\": %.2f }",
+          1e3 * t_convert, (unsigned long)run.s_steps, t_convert > 0 ? t_single / t_convert : 0);
+        first = false;
+
+        if (s_threads == max_threads)
+          break;
+      }
+    }
+  }
+  fprintf(stdout, "\n  ]\n}\n");
+
+  remove(path);
+  return ok ? 0 : 1;
+}
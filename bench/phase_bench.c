@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#include "parser.tab.h"
+#include "ast_priv.h"
+#include "interpreter.h"
+#include "scanner.h"
+#include "diagnostics.h"
+
+// Time of every phase of the interpreter (lexing and parsing, checking, transformation, bracket
+// abstraction with reduction, writing the .sk) on synthetic .ld programs of growing size, printed
+// as JSON so that runs of different commits can be compared. Every program runs in a child
+// process so that its peak RSS is its own.
+//
+//   phase_bench [iterations] [scale]   runs the suite, sizes are multiplied by scale
+//   phase_bench KIND SIZE              prints the generated program instead
+
+#ifndef BENCH_REVISION
+#define BENCH_REVISION "unknown"
+#endif
+
+extern __thread Scanner* scanner;
+extern __thread Diagnostics* parser_diagnostics;
+
+__thread const char* filename;
+__thread Arena arena = NULL;
+__thread AST*  ast   = NULL;
+
+typedef struct bench_program {
+  const char* kind;
+  void      (*generate)(FILE*, uint32_t);
+  uint32_t    sizes[3];
+} BenchProgram;
+
+typedef struct bench_run {
+  bool     ok;
+  size_t   s_stmts;
+  double   t_parse, t_check, t_transform, t_convert, t_write;
+  uint64_t s_reductions, s_reserved;
+} BenchRun;
+
+static void _generate_church (FILE* file, uint32_t size);
+static void _generate_chain  (FILE* file, uint32_t size);
+static void _generate_wide   (FILE* file, uint32_t size);
+static void _generate_huge   (FILE* file, uint32_t size);
+static void _generate_nested (FILE* file, uint32_t size);
+
+static const BenchProgram programs[] = {
+  { "church", _generate_church, { 64,   256,   1024   } },
+  { "chain",  _generate_chain,  { 64,   256,   1024   } },
+  { "wide",   _generate_wide,   { 8,    16,    32     } },
+  { "huge",   _generate_huge,   { 1000, 10000, 100000 } },
+  { "nested", _generate_nested, { 8,    16,    24     } }
+};
+static const size_t s_programs = sizeof(programs) / sizeof(programs[0]);
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// a numeral that is a single application nested size deep, applied to suc and zero
+static void _generate_church(FILE* file, uint32_t size) {
+  fprintf(file, "let zero = \\f, x -> x;\n");
+  fprintf(file, "let suc = \\n, f, x -> f (n f x);\n");
+  fprintf(file, "let deep = \\f, x -> ");
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "f (");
+  fprintf(file, "x");
+  for (uint32_t i = 0; i < size; i++)
+    fputc(')', file);
+  fprintf(file, ";\n");
+  fprintf(file, "let count = deep suc zero;\n");
+}
+
+// size definitions, each one referencing the one before it
+static void _generate_chain(FILE* file, uint32_t size) {
+  fprintf(file, "let c0 = \\f, x -> x;\n");
+  for (uint32_t i = 1; i <= size; i++)
+    fprintf(file, "let c%u = \\f, x -> c%u f (f x);\n", i, i - 1);
+}
+
+// lambdas binding size variables at once, bracket abstraction grows with the square of it
+static void _generate_wide(FILE* file, uint32_t size) {
+  for (uint32_t j = 0; j < 8; j++) {
+    fprintf(file, "let w%u = \\", j);
+    for (uint32_t i = 0; i < size; i++)
+      fprintf(file, "%sx%u", i > 0 ? ", " : "", i);
+    fprintf(file, " ->");
+    for (uint32_t i = 0; i < size; i++)
+      fprintf(file, " x%u", (i * (j + 1)) % size);
+    fprintf(file, ";\n");
+  }
+}
+
+// size small definitions in the style of test/test1.ld, the file grows to megabytes
+static void _generate_huge(FILE* file, uint32_t size) {
+  fprintf(file, "let s = \\x, y, z -> x z (y z);\nlet k = \\x, y -> x;\n");
+  for (uint32_t i = 0; i < size; i++) {
+    switch (i % 6) {
+      case 0: fprintf(file, "// block %u\nlet id%u = \\x -> x;\n", i / 6, i); break;
+      case 1: fprintf(file, "let pair%u = \\a, b, f -> f a b;\n", i); break;
+      case 2: fprintf(file, "let num%u = \\f, x -> f (f (f x));\n", i); break;
+      case 3: fprintf(file, "let app%u = s k k;\n", i); break;
+      case 4: fprintf(file, "let add%u = \\n, m, f, x -> m f (n f x);\n", i); break;
+      case 5: fprintf(file, "let use%u = pair%u (num%u) (id%u);\n", i, i - 4, i - 3, i - 5); break;
+    }
+  }
+}
+
+// one abstraction per variable, nested size deep, over pairs of them, the converter abstracts the
+// body once for every binder around it
+static void _generate_nested(FILE* file, uint32_t size) {
+  fprintf(file, "let nest = ");
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "\\x%u -> ", i);
+  for (uint32_t i = 0; i < size; i++)
+    fprintf(file, "%s(x%u x%u)", i > 0 ? " " : "", i, (i * 7 + 3) % size);
+  fprintf(file, ";\n");
+}
+
+static bool _bench_iteration(const char* path, const char* outpath, BenchRun* run) {
+  arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+  ast = NULL;
+  Diagnostics* diagnostics = diagnostics_create(path);
+  parser_diagnostics = diagnostics;
+  HashTable table = NULL;
+  bool ok = false;
+
+  double start = _bench_now();
+  scanner = scanner_open(arena, path);
+  if (scanner != NULL) {
+    size_t s_source = 0;
+    const char* source = scanner_get_source(scanner, &s_source);
+    diagnostics_set_source(diagnostics, source, s_source);
+    (void)yyparse();
+  }
+  double end = _bench_now();
+  run->t_parse += end - start;
+  if (ast == NULL)
+    goto done;
+
+  start = end;
+  table = ast_check(ast, 1 << 5, diagnostics);
+  end = _bench_now();
+  run->t_check += end - start;
+  if (table == NULL)
+    goto done;
+
+  start = end;
+  ast_transform(arena, ast);
+  ast_resolve(ast, table);
+  end = _bench_now();
+  run->t_transform += end - start;
+
+  start = end;
+  uint64_t s_reductions = skt_get_reductions();
+  SK_Tree** roots = ast_convert(arena, ast, table, diagnostics);
+  end = _bench_now();
+  run->t_convert += end - start;
+  run->s_reductions = skt_get_reductions() - s_reductions;
+
+  start = end;
+  FILE* outfile = fopen(outpath, "w");
+  if (outfile == NULL)
+    goto done;
+  skt_write(outfile, roots, ast->s_stmts);
+  fclose(outfile);
+  run->t_write += _bench_now() - start;
+
+  run->s_stmts = ast->s_stmts;
+  uint64_t s_reserved = arena_get_size_reserved(arena);
+  if (s_reserved > run->s_reserved)
+    run->s_reserved = s_reserved;
+  ok = true;
+
+done:
+  (void)diagnostics_flush(diagnostics, stderr);
+  if (table != NULL)
+    hashtable_free(table);
+  scanner_close(scanner);
+  scanner = NULL;
+  diagnostics_destroy(diagnostics);
+  arena_destroy(arena);
+  return ok;
+}
+
+static bool _bench_program(const char* path, const char* outpath, uint32_t iterations, BenchRun* run, long* s_rss) {
+  int32_t fds[2];
+  if (pipe(fds) != 0)
+    return false;
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (pid == 0) {
+    close(fds[0]);
+    BenchRun result = { 0 };
+    result.ok = true;
+    for (uint32_t i = 0; i < iterations && result.ok; i++)
+      result.ok = _bench_iteration(path, outpath, &result);
+    ssize_t s_written = write(fds[1], &result, sizeof(BenchRun));
+    _exit(s_written == (ssize_t)sizeof(BenchRun) ? 0 : 1);
+  }
+
+  close(fds[1]);
+  ssize_t s_read = read(fds[0], run, sizeof(BenchRun));
+  close(fds[0]);
+
+  int32_t status = 0;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    return false;
+  *s_rss = usage.ru_maxrss;
+  return s_read == (ssize_t)sizeof(BenchRun) && run->ok;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  if (argc == 3 && (argv[1][0] < '0' || argv[1][0] > '9')) {
+    for (size_t i = 0; i < s_programs; i++) {
+      if (strcmp(argv[1], programs[i].kind) == 0) {
+        programs[i].generate(stdout, (uint32_t)atoi(argv[2]));
+        return 0;
+      }
+    }
+    fprintf(stderr, "[BENCH]: unknown program kind %s (church, chain, wide, huge, nested)\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t iterations = argc > 1 ? (uint32_t)atoi(argv[1]) : 3,
+           scale      = argc > 2 ? (uint32_t)atoi(argv[2]) : 1;
+  if (iterations == 0 || scale == 0) {
+    fprintf(stderr, "usage: phase_bench [iterations] [scale]\n       phase_bench church|chain|wide|huge|nested SIZE\n");
+    return 1;
+  }
+
+  char path[64], outpath[64];
+  snprintf(path, sizeof(path), "/tmp/phase_bench_%d.ld", (int32_t)getpid());
+  snprintf(outpath, sizeof(outpath), "/tmp/phase_bench_%d.sk", (int32_t)getpid());
+  filename = path;
+
+  fprintf(stdout, "{\n  \"revision\": \"%s\",\n  \"iterations\": %u,\n  \"runs\": [", BENCH_REVISION, iterations);
+  bool ok = true, first = true;
+  for (size_t i = 0; i < s_programs; i++) {
+    for (size_t j = 0; j < sizeof(programs[i].sizes) / sizeof(programs[i].sizes[0]); j++) {
+      uint32_t size = programs[i].sizes[j] * scale;
+
+      FILE* file = fopen(path, "w");
+      if (file == NULL) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", path);
+        return 1;
+      }
+      programs[i].generate(file, size);
+      fclose(file);
+
+      struct stat st;
+      stat(path, &st);
+      BenchRun run = { 0 };
+      long s_rss = 0;
+      if (!_bench_program(path, outpath, iterations, &run, &s_rss)) {
+        fprintf(stderr, "[BENCH]: %s %u failed\n", programs[i].kind, size);
+        ok = false;
+        continue;
+      }
+
+      double t_total = run.t_parse + run.t_check + run.t_transform + run.t_convert + run.t_write;
+      fprintf(stdout, "%s\n    {", first ? "" : ",");
+      fprintf(stdout, " \"program\": \"%s\", \"size\": %u, \"bytes\": %zu, \"statements\": %zu,", programs[i].kind, size, (size_t)st.st_size, run.s_stmts);
+      fprintf(stdout, " \"parse_ms\": %.3f, \"check_ms\": %.3f, \"transform_ms\": %.3f,", 1e3 * run.t_parse / iterations, 1e3 * run.t_check / iterations, 1e3 * run.t_transform / iterations);
+      fprintf(stdout, " \"convert_ms\": %.3f, \"write_ms\": %.3f, \"total_ms\": %.3f,", 1e3 * run.t_convert / iterations, 1e3 * run.t_write / iterations, 1e3 * t_total / iterations);
+      fprintf(stdout, " \"reductions\": %lu, \"arena_reserved_bytes\": %lu, \"peak_rss_kb\": %ld }", (unsigned long)run.s_reductions, (unsigned long)run.s_reserved, s_rss);
+      first = false;
+    }
+  }
+  fprintf(stdout, "\n  ]\n}\n");
+
+  remove(path);
+  remove(outpath);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "parser.tab.h"
+#include "ast_priv.h"
+#include "interpreter.h"
+#include "skbin.h"
+#include "skimage.h"
+#include "skread.h"
+
+// Load time of a binary SK program, of a heap image linked into a fresh table and of the .sk text
+// against building the same roots from the .ld source (lexing, parsing, checking, bracket
+// abstraction and reduction).
+
+extern FILE* yyin;
+extern int yylex_destroy(void);
+
+__thread const char* filename;
+__thread Arena arena = NULL;
+__thread AST*  ast   = NULL;
+
+static double _bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static SK_Tree** _bench_front_end(size_t* s_roots, HashTable* table) {
+  yyin = fopen(filename, "r");
+  if (yyin == NULL)
+    return NULL;
+
+  ast = NULL;
+  yyparse();
+  fclose(yyin);
+  yylex_destroy();
+  if (ast == NULL)
+    return NULL;
+
+  Diagnostics* diagnostics = diagnostics_create(filename);
+  *table = ast_check(ast, 1 << 5, diagnostics);
+  if (*table == NULL) {
+    diagnostics_destroy(diagnostics);
+    return NULL;
+  }
+  ast_transform(arena, ast);
+  ast_resolve(ast, *table);
+
+  *s_roots = ast->s_stmts;
+  SK_Tree** roots = ast_convert(arena, ast, *table, diagnostics);
+  (void)diagnostics_flush(diagnostics, stderr);
+  diagnostics_destroy(diagnostics);
+  return roots;
+}
+
+int32_t main(int32_t argc, char* argv[]) {
+  filename = argc > 1 ? argv[1] : "test/test1.ld";
+  uint32_t iterations = argc > 2 ? (uint32_t)atoi(argv[2]) : 100;
+  if (iterations == 0) {
+    fprintf(stderr, "usage: skb_bench [file.ld] [iterations]\n");
+    return 1;
+  }
+
+  const char* binfilename   = "/tmp/skb_bench.skb",
+            * imagefilename = "/tmp/skb_bench.ski",
+            * textfilename  = "/tmp/skb_bench.sk";
+  double t_front = 0, t_load = 0, t_image = 0, t_read = 0;
+  size_t s_nodes = 0;
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+    HashTable table = NULL;
+    size_t s_roots = 0;
+
+    double start = _bench_now();
+    SK_Tree** roots = _bench_front_end(&s_roots, &table);
+    t_front += _bench_now() - start;
+    if (roots == NULL) {
+      fprintf(stderr, "[BENCH]: could not compile %s\n", filename);
+      return 1;
+    }
+
+    if (i == 0) {
+      FILE* file = fopen(binfilename, "wb");
+      if (file == NULL || !skb_write(file, roots, s_roots)) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", binfilename);
+        return 1;
+      }
+      fclose(file);
+
+      file = fopen(imagefilename, "wb");
+      if (file == NULL || !ski_write(file, roots, s_roots)) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", imagefilename);
+        return 1;
+      }
+      fclose(file);
+
+      file = fopen(textfilename, "w");
+      if (file == NULL) {
+        fprintf(stderr, "[BENCH]: could not write %s\n", textfilename);
+        return 1;
+      }
+      skt_write(file, roots, s_roots);
+      fclose(file);
+    }
+    hashtable_free(table);
+    arena_destroy(arena);
+  }
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+
+    double start = _bench_now();
+    SKB_Image* image = skb_load(binfilename);
+    SK_Tree** roots = image != NULL ? skb_get_roots(arena, image) : NULL;
+    t_load += _bench_now() - start;
+    if (roots == NULL) {
+      fprintf(stderr, "[BENCH]: could not load %s\n", binfilename);
+      return 1;
+    }
+
+    s_nodes = skb_get_size_nodes(image);
+    skb_unload(image);
+    arena_destroy(arena);
+  }
+
+  // the image is used where it is mapped, what is left is linking its statements into a table
+  for (uint32_t i = 0; i < iterations; i++) {
+    double start = _bench_now();
+    SKI_Image* image = ski_load(imagefilename);
+    if (image == NULL) {
+      fprintf(stderr, "[BENCH]: could not load %s\n", imagefilename);
+      return 1;
+    }
+    HashTable table = hashtable_create(1 << 5, .75);
+    for (ASTN_Stmt* stmt = ski_get_stmts(image); stmt != NULL; stmt = stmt->next)
+      (void)hashtable_insert(&table, stmt);
+    t_image += _bench_now() - start;
+
+    hashtable_free(table);
+    ski_unload(image);
+  }
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    arena = arena_create_growable(1 << 20, MAX_SIZE, 0, 0);
+
+    size_t s_roots = 0;
+    double start = _bench_now();
+    SK_Tree** roots = skt_read(arena, textfilename, &s_roots);
+    t_read += _bench_now() - start;
+    if (roots == NULL) {
+      fprintf(stderr, "[BENCH]: could not read %s\n", textfilename);
+      return 1;
+    }
+    arena_destroy(arena);
+  }
+
+  struct stat st_source, st_binary, st_image, st_text;
+  stat(filename, &st_source);
+  stat(binfilename, &st_binary);
+  stat(imagefilename, &st_image);
+  stat(textfilename, &st_text);
+  remove(binfilename);
+  remove(imagefilename);
+  remove(textfilename);
+
+  fprintf(stdout, "%-10s %-12s %-12s %-12s\n", "input", "bytes", "ms/run", "MB/s");
+  fprintf(
+    stdout, "%-10s %-12zu %-12.3f %-12.1f\n", ".ld",
+    (size_t)st_source.st_size, 1e3 * t_front / iterations, (double)st_source.st_size * iterations / t_front / 1e6
+  );
+  fprintf(
+    stdout, "%-10s %-12zu %-12.3f %-12.1f\n", ".skb",
+    (size_t)st_binary.st_size, 1e3 * t_load / iterations, (double)st_binary.st_size * iterations / t_load / 1e6
+  );
+  fprintf(
+    stdout, "%-10s %-12zu %-12.3f %-12.1f\n", ".ski",
+    (size_t)st_image.st_size, 1e3 * t_image / iterations, (double)st_image.st_size * iterations / t_image / 1e6
+  );
+  fprintf(
+    stdout, "%-10s %-12zu %-12.3f %-12.1f\n", ".sk",
+    (size_t)st_text.st_size, 1e3 * t_read / iterations, (double)st_text.st_size * iterations / t_read / 1e6
+  );
+  fprintf(
+    stdout, "%zu nodes, binary load is %.1fx, heap image load %.1fx and text load %.1fx faster than compiling\n",
+    s_nodes, t_front / t_load, t_front / t_image, t_front / t_read
+  );
+
+  return 0;
+}
@@ -8,17 +8,48 @@
 
 typedef struct arena *Arena;
 
+// Checkpoint returned by arena_mark, everything allocated after it goes away with arena_release
+typedef struct arena_mark {
+  Arena    node;
+  void*    ptr;
+  uint64_t s_live;
+} ArenaMark;
+
+// Chunk mapping flags for arena_create_growable
+#define ARENA_HUGEPAGES (1u << 0) // MAP_HUGETLB when available, MADV_HUGEPAGE otherwise
+
 Arena    arena_create(uint64_t s_arena, uint64_t max_nodes);
 Arena    arena_create_aligned(uint64_t s_arena, uint64_t s_block, uint64_t max_nodes);
+Arena    arena_create_growable(uint64_t s_arena, uint64_t s_block, uint64_t s_limit, uint32_t flags);
+
+// Shards allocate lock-free from their own chunks and are freed by arena_destroy on the parent.
+// arena_shard returns the calling thread's shard of parent, creating it on first use.
+Arena    arena_shard(Arena parent);
+Arena    arena_shard_create(Arena parent);
+// The arena that owns a shard, or the arena itself: its limit and reserved bytes are the family's
+Arena    arena_get_family(Arena arena);
 
 void*    arena_alloc(Arena arena, uint64_t s_alloc);
+void*    arena_alloc_tagged(Arena arena, uint64_t s_alloc, const char* tag);
 void*    arena_alloc_array(Arena arena, uint64_t s_obj, uint32_t count);
 void*    arena_realloc(Arena arena, void* ptr, uint64_t s_realloc);
 
 char*    arena_strdup(Arena arena, char* str);
 
+ArenaMark arena_mark(Arena arena);
+bool      arena_release(Arena arena, ArenaMark mark);
+bool      arena_contains(Arena arena, void* ptr);
+
 void     arena_print(Arena arena, FILE* file);
 
+// Instrumentation: off by default, when on every allocation is charged to the current tag
+bool        arena_stats_enable(Arena arena);
+const char* arena_tag(Arena arena, const char* tag);
+void        arena_stats_write_json(Arena arena, FILE* file);
+
+void     arena_set_limit(Arena arena, uint64_t s_limit);
+void     arena_set_oom_handler(Arena arena, void oom(Arena arena, uint64_t s_alloc));
+
 bool     arena_is_aligned(Arena arena);
 bool     arena_free(Arena arena, void* ptr);
 bool     arena_reset(Arena arena);
@@ -29,5 +60,8 @@ uint64_t arena_get_size_bitmap(Arena arena);
 uint64_t arena_get_size_nodes_max(Arena arena);
 uint64_t arena_get_size_nodes(Arena arena);
 uint64_t arena_get_size_used(Arena arena);
+uint64_t arena_get_size_reserved(Arena arena);
+uint64_t arena_get_size_peak(Arena arena);
+uint64_t arena_get_limit(Arena arena);
 
 #endif // !ARENA_H
@@ -6,24 +6,87 @@
 #include <stddef.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+// Upper bound for a single geometrically grown chunk (larger requests still get their own chunk)
+#define ARENA_MAX_CHUNK  ((uint64_t)1 << 30)
+#define ARENA_HUGE_PAGE  ((uint64_t)1 << 21)
+#define ARENA_SHARD_SLOTS 8
+// Smallest chunk, that of a new shard and the one a chunk shrinks to under the ceiling
+#define ARENA_MIN_CHUNK   ((uint64_t)1 << 12)
+#define ARENA_MAX_TAGS    32
+#define ARENA_HISTOGRAM   32
+#define ARENA_UNTAGGED    "untagged"
 
 struct arena {
   bool is_aligned;
+  uint32_t flags;
   uint64_t s_arena, s_block, s_bitmap, max_nodes,
-           s_nodes;
+           s_nodes, s_mapped,
+           s_reserved, s_limit;
   void* memory,
       * ptr;
-  struct arena* next;
+  struct arena* next,
+              * tail;
+  void (*oom)(Arena arena, uint64_t s_alloc);
+
+  // shards: a parent owns every shard created from it, s_reserved of the parent counts them too
+  uint64_t serial;
+  struct arena* parent,
+              * shards,
+              * sibling;
+  pthread_mutex_t lock;
+
+  const char* tag;
+  struct arena_stats* stats;
+};
+
+struct arena_tag_stats {
+  const char* tag;
+  uint64_t allocs,
+           s_requested, // bytes asked for
+           s_consumed,  // bytes taken from the chunk: header plus block rounding
+           histogram[ARENA_HISTOGRAM]; // allocations by log2 of the requested size
+};
+
+struct arena_stats {
+  uint32_t s_tags, current;
+  uint64_t allocs, frees,
+           s_requested, s_consumed,
+           s_live, s_peak;
+  struct arena_tag_stats tags[ARENA_MAX_TAGS];
+};
+
+struct arena_shard_slot {
+  Arena parent;
+  uint64_t serial;
+  Arena shard;
 };
 
 const uint64_t s_word = sizeof(uint64_t);
 
+Arena     _arena_create_node(uint64_t s_arena, uint64_t s_block, bool is_aligned, uint32_t flags);
+Arena     _arena_grow(Arena arena, uint64_t s_alloc);
+void*     _arena_map(uint64_t* s_map, uint32_t flags);
+void*     _arena_out_of_memory(Arena arena, uint64_t s_alloc);
+bool      _arena_reserve(Arena arena, uint64_t bytes);
+void      _arena_shard_detach(Arena parent, Arena shard);
+
+uint32_t  _arena_stats_tag_index(struct arena_stats* stats, const char* tag);
+void      _arena_stats_alloc(struct arena_stats* stats, uint64_t s_requested, uint64_t s_consumed);
+void      _arena_stats_write_json(Arena arena, FILE* file);
+void      _arena_utils_write_json_str(FILE* file, const char* str);
+
 bool      _arena_is_full(Arena arena, uint64_t s_alloc);
+void      _arena_rewind(Arena arena, void* ptr);
 bool      _arena_valid_alloc(Arena* arena, void* ptr);
 bool      _arena_set_bitmap(Arena arena, void* ptr, uint64_t blocks, bool full);
 bool      _arena_ptr_in_arena(Arena arena, void* ptr);
 
 uint64_t  _arena_size_memory(Arena arena);
+uint64_t  _arena_size_region(Arena arena);
 uint64_t  _arena_bitmap_size(uint64_t s_arena, uint64_t s_block);
 uint64_t  _arena_get_index(Arena* arena, void *ptr);
 uint64_t  _arena_bytes_to_blocks(Arena arena, uint64_t bytes);
@@ -39,5 +102,6 @@ void*     _arena_get_base_ptr(Arena arena);
 uint64_t  _arena_utils_next_power_2(uint64_t s);
 uint64_t  _arena_utils_bit_count(uint64_t word);
 uint64_t  _arena_utils_ceil(double x);
+uint64_t  _arena_utils_round_up(uint64_t s, uint64_t multiple);
 
 #endif // !ARENA_PRIVATE_H
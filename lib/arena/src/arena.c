@@ -1,71 +1,123 @@
 #include "arena_private.h"
 
+static uint64_t _arena_serial = 0;
+
+static __thread struct arena_shard_slot _arena_shard_slots[ARENA_SHARD_SLOTS];
+static __thread uint32_t _arena_shard_victim = 0;
+
 // ====================================# PUBLIC #======================================
 
 Arena arena_create(uint64_t s_arena, uint64_t max_nodes) {
   if (s_arena == 0)
     return NULL;
 
-  Arena arena = (Arena)malloc(sizeof(struct arena));
+  Arena arena = _arena_create_node(s_arena, 1, false, 0);
   if (arena == NULL)
     return NULL;
-  arena->is_aligned = false; 
+  arena->max_nodes = max_nodes;
 
-  arena->s_arena = _arena_utils_next_power_2(s_arena);
-  arena->s_block = 1;
+  return arena;
+}
 
-  arena->s_bitmap = _arena_bitmap_size(arena->s_arena, arena->s_block);
-  if (arena->s_bitmap == 0) {
-    free(arena);
+Arena arena_create_aligned(uint64_t s_arena, uint64_t s_block, uint64_t max_nodes) {
+  if (s_arena == 0)
     return NULL;
-  } 
-
-  arena->memory = calloc(1, _arena_size_memory(arena));
-  if (arena->memory == NULL) {
-    free(arena);
+  if (s_block < s_word)
     return NULL;
-  }
-  arena->ptr = _arena_ptr_incr(arena->memory, arena->s_bitmap);
 
+  Arena arena = _arena_create_node(s_arena, s_block, true, 0);
+  if (arena == NULL)
+    return NULL;
   arena->max_nodes = max_nodes;
-  arena->s_nodes = 1;
-  arena->next = NULL;
-
+  
   return arena;
 }
 
-Arena arena_create_aligned(uint64_t s_arena, uint64_t s_block, uint64_t max_nodes) {
+Arena arena_create_growable(uint64_t s_arena, uint64_t s_block, uint64_t s_limit, uint32_t flags) {
   if (s_arena == 0)
     return NULL;
   if (s_block < s_word)
     return NULL;
 
-  Arena arena = (Arena)malloc(sizeof(struct arena));
+  Arena arena = _arena_create_node(s_arena, s_block, true, flags);
+  // shrink the first chunk until it takes half the ceiling at most, the rest is left to the
+  // chunks it grows by and to the shards
+  while (arena != NULL && s_limit != 0 &&
+         (arena->s_reserved > s_limit || (2 * arena->s_reserved > s_limit && arena->s_arena > ARENA_MIN_CHUNK))) {
+    uint64_t s_half = arena->s_arena / 2;
+    (void)arena_destroy(arena);
+    arena = _arena_create_node(s_half, s_block, true, flags);
+  }
   if (arena == NULL)
     return NULL;
-  arena->is_aligned = true; 
+  arena->max_nodes = 0;
+  arena->s_limit = s_limit;
 
-  arena->s_arena = _arena_utils_next_power_2(s_arena);
-  arena->s_block = _arena_utils_next_power_2(s_block);
+  return arena;
+}
 
-  arena->s_bitmap = _arena_bitmap_size(arena->s_arena, arena->s_block);
-  if (arena->s_bitmap == 0) {
-    free(arena);
+Arena arena_shard(Arena parent) {
+  if (parent == NULL)
     return NULL;
+  for (; parent->parent != NULL; parent = parent->parent);
+
+  for (uint32_t i = 0; i < ARENA_SHARD_SLOTS; i++) {
+    struct arena_shard_slot* slot = &_arena_shard_slots[i];
+    if (slot->parent == parent && slot->serial == parent->serial)
+      return slot->shard;
   }
 
-  arena->memory = calloc(1, _arena_size_memory(arena));
-  if (arena->memory == NULL) {
-    free(arena);
+  Arena shard = arena_shard_create(parent);
+  if (shard == NULL)
+    return NULL;
+
+  _arena_shard_slots[_arena_shard_victim] = (struct arena_shard_slot){
+    .parent = parent,
+    .serial = parent->serial,
+    .shard  = shard
+  };
+  _arena_shard_victim = (_arena_shard_victim + 1) % ARENA_SHARD_SLOTS;
+
+  return shard;
+}
+
+Arena arena_shard_create(Arena parent) {
+  if (parent == NULL)
+    return NULL;
+  for (; parent->parent != NULL; parent = parent->parent);
+
+  // a shard starts small and grows like any arena, so that it only counts against the limit of
+  // the family what it uses; a bounded number of chunks is kept at the size of the parent's
+  uint64_t s_first = parent->max_nodes != 0 ? parent->s_arena : ARENA_MIN_CHUNK;
+  if (s_first < 8 * parent->s_block)
+    s_first = 8 * parent->s_block;
+  Arena shard = _arena_create_node(s_first, parent->s_block, parent->is_aligned, parent->flags);
+  if (shard == NULL)
+    return NULL;
+  shard->max_nodes = parent->max_nodes;
+  shard->oom = parent->oom;
+  shard->parent = parent;
+  shard->s_reserved = 0;
+  if (parent->stats != NULL && !arena_stats_enable(shard)) {
+    shard->parent = NULL;
+    (void)arena_destroy(shard);
     return NULL;
   }
-  arena->ptr = _arena_ptr_incr(arena->memory, arena->s_bitmap);
 
-  arena->max_nodes = max_nodes;
-  arena->s_nodes = 1;
-  arena->next = NULL;
-  
-  return arena;
+  // over the limit of the family, like an allocation: the handler may not return
+  if (!_arena_reserve(shard, shard->s_mapped)) {
+    uint64_t s_mapped = shard->s_mapped;
+    shard->parent = NULL;
+    (void)arena_destroy(shard);
+    return (Arena)_arena_out_of_memory(parent, s_mapped);
+  }
+
+  pthread_mutex_lock(&parent->lock);
+  shard->sibling = parent->shards;
+  parent->shards = shard;
+  pthread_mutex_unlock(&parent->lock);
+
+  return shard;
 }
 
 void* arena_alloc(Arena arena, uint64_t s_alloc) {
@@ -74,31 +126,37 @@ void* arena_alloc(Arena arena, uint64_t s_alloc) {
   if (s_alloc == 0)
     return NULL;
 
-  Arena node = arena;
-  for (; node->next != NULL; node = node->next);
-
+  Arena node = arena->tail;
   if (_arena_is_full(node, s_alloc)) {
-    if (arena->s_nodes >= arena->max_nodes)
-      return NULL;
-
-    node->next = arena->is_aligned ?
-        arena_create_aligned(arena->s_arena, arena->s_block, arena->max_nodes)
-      : arena_create(arena->s_arena, arena->max_nodes);
-    if (node->next == NULL)
-      return NULL;
-    arena->s_nodes++;
-
-    return arena_alloc(node->next, s_alloc);
+    node = _arena_grow(arena, s_alloc);
+    if (node == NULL)
+      return _arena_out_of_memory(arena, s_alloc);
   }
    
   uint64_t* s_ptr = (uint64_t*)node->ptr;
   void* ptr = _arena_ptr_incr(node->ptr, s_word);
 
   *s_ptr = s_alloc;
-  uint64_t blocks = _arena_bytes_to_blocks(node, s_alloc);
+  uint64_t blocks = _arena_bytes_to_blocks(node, s_alloc),
+           offset = _arena_blocks_to_offset(node, blocks);
   _arena_set_bitmap(node, ptr, blocks, true);
-  node->ptr = _arena_ptr_incr(node->ptr, _arena_blocks_to_offset(node, blocks));
+  node->ptr = _arena_ptr_incr(node->ptr, offset);
+
+  if (arena->stats != NULL)
+    _arena_stats_alloc(arena->stats, s_alloc, offset);
+
+  return ptr;
+}
+
+void* arena_alloc_tagged(Arena arena, uint64_t s_alloc, const char* tag) {
+  if (arena == NULL)
+    return NULL;
+  if (arena->stats == NULL)
+    return arena_alloc(arena, s_alloc);
 
+  const char* previous = arena_tag(arena, tag);
+  void* ptr = arena_alloc(arena, s_alloc);
+  (void)arena_tag(arena, previous);
   return ptr;
 }
 
@@ -112,7 +170,8 @@ void* arena_realloc(Arena arena, void* ptr, uint64_t s_realloc) {
   if (ptr == NULL)
     return NULL;
 
-  if (!_arena_ptr_in_arena(arena, ptr))
+  Arena node = arena;
+  if (!_arena_valid_alloc(&node, ptr))
     return NULL;
   void* new_ptr = arena_alloc(arena, s_realloc);
   if (new_ptr == NULL)
@@ -145,6 +204,41 @@ char* arena_strdup(Arena arena, char* str) {
   return copy;
 }
 
+ArenaMark arena_mark(Arena arena) {
+  assert(arena != NULL);
+  return (ArenaMark){
+    .node   = arena->tail,
+    .ptr    = arena->tail->ptr,
+    .s_live = arena->stats != NULL ? arena->stats->s_live : 0
+  };
+}
+
+bool arena_release(Arena arena, ArenaMark mark) {
+  if (arena == NULL || mark.node == NULL)
+    return false;
+
+  // chunks after the mark stay mapped and are handed out again by _arena_grow
+  _arena_rewind(mark.node, mark.ptr);
+  for (Arena node = mark.node->next; node != NULL && node->ptr != _arena_get_base_ptr(node); node = node->next)
+    _arena_rewind(node, _arena_get_base_ptr(node));
+  arena->tail = mark.node;
+
+  if (arena->stats != NULL)
+    arena->stats->s_live = mark.s_live;
+  return true;
+}
+
+bool arena_contains(Arena arena, void* ptr) {
+  if (arena == NULL || ptr == NULL)
+    return false;
+  for (Arena node = arena; node != NULL; node = node->next) {
+    char* base_ptr = (char*)_arena_get_base_ptr(node);
+    if ((char*)ptr >= base_ptr && (char*)ptr < base_ptr + _arena_size_region(node))
+      return true;
+  }
+  return false;
+}
+
 bool arena_is_aligned(Arena arena) {
   return arena->is_aligned;
 }
@@ -165,19 +259,48 @@ uint64_t arena_get_size_nodes(Arena arena) {
   return arena->s_nodes;
 }
 
+uint64_t arena_get_size_reserved(Arena arena) {
+  return __atomic_load_n(&arena->s_reserved, __ATOMIC_RELAXED);
+}
+
+Arena arena_get_family(Arena arena) {
+  assert(arena != NULL);
+  for (; arena->parent != NULL; arena = arena->parent);
+  return arena;
+}
+
+uint64_t arena_get_limit(Arena arena) {
+  return arena->s_limit;
+}
+
+void arena_set_limit(Arena arena, uint64_t s_limit) {
+  assert(arena != NULL);
+  arena->s_limit = s_limit;
+}
+
+void arena_set_oom_handler(Arena arena, void oom(Arena arena, uint64_t s_alloc)) {
+  assert(arena != NULL);
+  arena->oom = oom;
+}
+
 uint64_t arena_get_size_used(Arena arena) {
   if (arena == NULL)
     return 0;
   if (arena->memory == NULL)
     return 0;
   uint64_t counter = 0;
-  uint64_t l_bitmap = arena->s_bitmap > s_word ? arena->s_bitmap/s_word : arena->s_bitmap;
-  uint64_t* bitmap = (uint64_t*)arena->memory;
-  for (uint64_t i = 0; i < l_bitmap; i++)
-    counter += _arena_utils_bit_count(bitmap[i]);
+  for (Arena node = arena; node != NULL; node = node->next) {
+    uint64_t* bitmap = (uint64_t*)node->memory;
+    for (uint64_t i = 0; i < node->s_bitmap/s_word; i++)
+      counter += _arena_utils_bit_count(bitmap[i]);
+  }
   return counter * arena->s_block;
 }
 
+uint64_t arena_get_size_peak(Arena arena) {
+  return arena->stats != NULL ? arena->stats->s_peak : 0;
+}
+
 bool arena_free(Arena arena, void* ptr) {
   if (arena == NULL)
     return false;
@@ -188,12 +311,18 @@ bool arena_free(Arena arena, void* ptr) {
   if (*s_ptr == 0)
     return false;
 
-  uint64_t s_alloc = _arena_blocks_to_offset(arena, _arena_bytes_to_blocks(arena, *s_ptr));
+  uint64_t blocks = _arena_bytes_to_blocks(arena, *s_ptr);
+  uint64_t s_alloc = _arena_blocks_to_offset(arena, blocks);
 
+  struct arena_stats* stats = arena->stats;
   if (!_arena_valid_alloc(&arena, ptr))
     return false;
+  if (stats != NULL) {
+    stats->frees++;
+    stats->s_live -= s_alloc;
+  }
   memset((void*)s_ptr, 0, s_alloc);
-  return _arena_set_bitmap(arena, ptr, s_alloc, false);
+  return _arena_set_bitmap(arena, ptr, blocks, false);
 }
 
 bool arena_reset(Arena arena) {
@@ -201,19 +330,39 @@ bool arena_reset(Arena arena) {
     return false;
   if (arena->memory == NULL)
     return false;
-  memset(arena->memory, 0, arena->s_bitmap);
-  memset(_arena_ptr_incr(arena->memory, arena->s_bitmap), 0, arena->s_arena);
+  for (Arena node = arena; node != NULL; node = node->next) {
+    memset(node->memory, 0, node->s_bitmap);
+    // hand the pages back to the kernel, they come back zeroed on the next touch
+    (void)madvise(_arena_get_base_ptr(node), _arena_size_region(node), MADV_DONTNEED);
+    node->ptr = _arena_get_base_ptr(node);
+  }
+  // _arena_grow only moves on to tail->next, the chunks before the tail are empty again
+  arena->tail = arena;
+  if (arena->stats != NULL)
+    arena->stats->s_live = 0;
   return true;
 }
 
 bool arena_destroy(Arena arena) {
   if (arena == NULL)
     return false;
+  if (arena->parent != NULL)
+    _arena_shard_detach(arena->parent, arena);
+
+  for (Arena shard = arena->shards; shard != NULL;) {
+    Arena sibling = shard->sibling;
+    shard->parent = NULL;
+    (void)arena_destroy(shard);
+    shard = sibling;
+  }
+
   Arena node = arena;
   while (node != NULL) {
     Arena next = node->next;
     if (node->memory)
-      free(node->memory);
+      (void)munmap(node->memory, node->s_mapped);
+    pthread_mutex_destroy(&node->lock);
+    free(node->stats);
     free(node);
     node = next;
   }
@@ -231,35 +380,330 @@ void arena_print(Arena arena, FILE* file) {
   fprintf(file, "  size block:  %zu bytes;\n", arena->s_block);
   fprintf(file, "  size:        %zu bytes;\n", arena_get_size(arena));
   fprintf(file, "  size used:   %zu bytes;\n", arena_get_size_used(arena));
+  fprintf(file, "  reserved:    %zu bytes;\n", arena_get_size_reserved(arena));
+  if (arena->stats != NULL)
+    fprintf(file, "  peak used:   %zu bytes;\n", arena_get_size_peak(arena));
+  fprintf(file, "  limit:       %zu bytes;\n", arena_get_limit(arena));
   fprintf(file, "  max nodes:   %zu;\n", arena_get_size_nodes_max(arena));
   fprintf(file, "  nº nodes:    %zu;\n", arena_get_size_nodes(arena));
 }
 
+bool arena_stats_enable(Arena arena) {
+  if (arena == NULL)
+    return false;
+  if (arena->stats != NULL)
+    return true;
+
+  arena->stats = (struct arena_stats*)calloc(1, sizeof(struct arena_stats));
+  if (arena->stats == NULL)
+    return false;
+  arena->stats->current = _arena_stats_tag_index(arena->stats, arena->tag);
+
+  return true;
+}
+
+const char* arena_tag(Arena arena, const char* tag) {
+  assert(arena != NULL);
+  const char* previous = arena->tag;
+  if (tag == previous)
+    return previous;
+
+  arena->tag = tag;
+  if (arena->stats != NULL)
+    arena->stats->current = _arena_stats_tag_index(arena->stats, tag);
+  return previous;
+}
+
+void arena_stats_write_json(Arena arena, FILE* file) {
+  if (arena == NULL)
+    return;
+  if (file == NULL)
+    file = stdout;
+
+  fprintf(file, "{\n  \"arena\": ");
+  _arena_stats_write_json(arena, file);
+  fprintf(file, ",\n  \"shards\": [");
+  pthread_mutex_lock(&arena->lock);
+  for (Arena shard = arena->shards; shard != NULL; shard = shard->sibling) {
+    fprintf(file, shard == arena->shards ? "\n    " : ",\n    ");
+    _arena_stats_write_json(shard, file);
+  }
+  pthread_mutex_unlock(&arena->lock);
+  fprintf(file, "%s]\n}\n", arena->shards != NULL ? "\n  " : "");
+}
+
 // ====================================# PRIVATE #======================================
 
+Arena _arena_create_node(uint64_t s_arena, uint64_t s_block, bool is_aligned, uint32_t flags) {
+  Arena arena = (Arena)malloc(sizeof(struct arena));
+  if (arena == NULL)
+    return NULL;
+
+  *arena = (struct arena){
+    .is_aligned = is_aligned,
+    .flags      = flags,
+    .s_arena    = _arena_utils_next_power_2(s_arena),
+    .s_block    = is_aligned ? _arena_utils_next_power_2(s_block) : 1,
+    .s_nodes    = 1,
+    .serial     = __atomic_add_fetch(&_arena_serial, 1, __ATOMIC_RELAXED)
+  };
+  pthread_mutex_init(&arena->lock, NULL);
+
+  arena->s_bitmap = _arena_bitmap_size(arena->s_arena, arena->s_block);
+  if (arena->s_bitmap == 0) {
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+    return NULL;
+  }
+
+  arena->s_mapped = _arena_size_memory(arena);
+  arena->memory = _arena_map(&arena->s_mapped, flags);
+  if (arena->memory == NULL) {
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+    return NULL;
+  }
+  arena->ptr = _arena_ptr_incr(arena->memory, arena->s_bitmap);
+
+  arena->s_reserved = arena->s_mapped;
+  arena->tail = arena;
+
+  return arena;
+}
+
+Arena _arena_grow(Arena arena, uint64_t s_alloc) {
+  assert(arena != NULL);
+  if (arena->max_nodes != 0 && arena->s_nodes >= arena->max_nodes)
+    return NULL;
+
+  // a chunk kept by arena_release comes first
+  Arena spare = arena->tail->next;
+  if (spare != NULL && !_arena_is_full(spare, s_alloc)) {
+    arena->tail = spare;
+    return spare;
+  }
+
+  uint64_t s_fit  = _arena_utils_next_power_2(arena->s_block * _arena_bytes_to_blocks(arena, s_alloc)),
+           s_next = arena->tail->s_arena < ARENA_MAX_CHUNK ? 2 * arena->tail->s_arena : ARENA_MAX_CHUNK;
+  // the chunk that just fits a small request still needs a word of bitmap
+  uint64_t s_min = ARENA_MIN_CHUNK > 8 * arena->s_block ? ARENA_MIN_CHUNK : 8 * arena->s_block;
+  if (s_fit < s_min)
+    s_fit = s_min;
+  if (s_next < s_fit)
+    s_next = s_fit;
+
+  while (true) {
+    Arena node = _arena_create_node(s_next, arena->s_block, arena->is_aligned, arena->flags);
+    if (node == NULL)
+      return NULL;
+
+    if (_arena_reserve(arena, node->s_mapped)) {
+      node->next = arena->tail->next;
+      arena->tail->next = node;
+      arena->tail = node;
+      arena->s_nodes++;
+      return node;
+    }
+
+    (void)arena_destroy(node);
+    // doubling overshot the ceiling, settle for a chunk that just fits the request
+    if (s_next == s_fit)
+      return NULL;
+    s_next = s_fit;
+  }
+}
+
+void* _arena_map(uint64_t* s_map, uint32_t flags) {
+  assert(s_map != NULL);
+
+#ifdef MAP_HUGETLB
+  if (flags & ARENA_HUGEPAGES) {
+    uint64_t s_huge = _arena_utils_round_up(*s_map, ARENA_HUGE_PAGE);
+    void* memory = mmap(NULL, s_huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) {
+      *s_map = s_huge;
+      return memory;
+    }
+  }
+#endif
+
+  *s_map = _arena_utils_round_up(*s_map, (uint64_t)sysconf(_SC_PAGESIZE));
+  void* memory = mmap(NULL, *s_map, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+    return NULL;
+
+#ifdef MADV_HUGEPAGE
+  if ((flags & ARENA_HUGEPAGES) && *s_map >= ARENA_HUGE_PAGE)
+    (void)madvise(memory, *s_map, MADV_HUGEPAGE);
+#endif
+
+  return memory;
+}
+
+void* _arena_out_of_memory(Arena arena, uint64_t s_alloc) {
+  assert(arena != NULL);
+  if (arena->oom != NULL)
+    arena->oom(arena, s_alloc);
+  return NULL;
+}
+
+bool _arena_reserve(Arena arena, uint64_t bytes) {
+  assert(arena != NULL);
+  Arena root = arena->parent != NULL ? arena->parent : arena;
+
+  // the ceiling is shared by the whole family, shards only bump the parent's counter
+  uint64_t s_reserved = __atomic_load_n(&root->s_reserved, __ATOMIC_RELAXED);
+  do {
+    if (root->s_limit != 0 && s_reserved + bytes > root->s_limit)
+      return false;
+  } while (!__atomic_compare_exchange_n(
+    &root->s_reserved, &s_reserved, s_reserved + bytes, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED
+  ));
+
+  if (root != arena)
+    arena->s_reserved += bytes;
+  return true;
+}
+
+void _arena_shard_detach(Arena parent, Arena shard) {
+  assert(parent != NULL && shard != NULL);
+  pthread_mutex_lock(&parent->lock);
+  for (Arena* link = &parent->shards; *link != NULL; link = &((*link)->sibling)) {
+    if (*link != shard)
+      continue;
+    *link = shard->sibling;
+    break;
+  }
+  pthread_mutex_unlock(&parent->lock);
+  (void)__atomic_sub_fetch(&parent->s_reserved, shard->s_reserved, __ATOMIC_RELAXED);
+  shard->parent = NULL;
+}
+
+uint32_t _arena_stats_tag_index(struct arena_stats* stats, const char* tag) {
+  assert(stats != NULL);
+  if (tag == NULL)
+    tag = ARENA_UNTAGGED;
+
+  // tags are usually string literals, the pointer check catches them before strcmp
+  for (uint32_t i = 0; i < stats->s_tags; i++)
+    if (stats->tags[i].tag == tag || strcmp(stats->tags[i].tag, tag) == 0)
+      return i;
+
+  if (stats->s_tags == ARENA_MAX_TAGS)
+    return _arena_stats_tag_index(stats, ARENA_UNTAGGED);
+  stats->tags[stats->s_tags].tag = tag;
+  return stats->s_tags++;
+}
+
+void _arena_stats_alloc(struct arena_stats* stats, uint64_t s_requested, uint64_t s_consumed) {
+  assert(stats != NULL);
+  struct arena_tag_stats* tag = &stats->tags[stats->current];
+
+  uint32_t bucket = 63 - (uint32_t)__builtin_clzll(s_requested);
+  tag->histogram[bucket < ARENA_HISTOGRAM ? bucket : ARENA_HISTOGRAM - 1]++;
+  tag->allocs++;
+  tag->s_requested += s_requested;
+  tag->s_consumed  += s_consumed;
+
+  stats->allocs++;
+  stats->s_requested += s_requested;
+  stats->s_consumed  += s_consumed;
+  stats->s_live      += s_consumed;
+  if (stats->s_live > stats->s_peak)
+    stats->s_peak = stats->s_live;
+}
+
+void _arena_stats_write_json(Arena arena, FILE* file) {
+  assert(arena != NULL && file != NULL);
+
+  uint64_t s_region = 0, s_used = 0, s_tail_waste = 0;
+  for (Arena node = arena; node != NULL; node = node->next) {
+    uint64_t s_node_used = (uint64_t)_arena_ptr_diff(node->ptr, _arena_get_base_ptr(node));
+    s_region += _arena_size_region(node);
+    s_used   += s_node_used;
+    // space left behind in a chunk that could not fit the next allocation
+    if (node->next != NULL)
+      s_tail_waste += _arena_size_region(node) - s_node_used;
+  }
+
+  fprintf(file, "{ \"chunks\": %zu, \"reserved\": %zu, \"limit\": %zu, \"region\": %zu, \"used\": %zu, \"tail_waste\": %zu",
+    arena->s_nodes, arena_get_size_reserved(arena), arena->s_limit, s_region, s_used, s_tail_waste);
+
+  struct arena_stats* stats = arena->stats;
+  if (stats == NULL) {
+    fprintf(file, " }");
+    return;
+  }
+
+  uint64_t s_header = stats->allocs * s_word;
+  fprintf(file, ", \"allocs\": %zu, \"frees\": %zu, \"requested\": %zu, \"consumed\": %zu, \"header\": %zu, \"padding\": %zu, \"live\": %zu, \"peak\": %zu,\n      \"tags\": [",
+    stats->allocs, stats->frees, stats->s_requested, stats->s_consumed,
+    s_header, stats->s_consumed - stats->s_requested - s_header, stats->s_live, stats->s_peak);
+
+  bool first_tag = true;
+  for (uint32_t i = 0; i < stats->s_tags; i++) {
+    struct arena_tag_stats* tag = &stats->tags[i];
+    if (tag->allocs == 0)
+      continue;
+    fprintf(file, "%s\n        { \"tag\": ", first_tag ? "" : ",");
+    first_tag = false;
+    _arena_utils_write_json_str(file, tag->tag);
+    fprintf(file, ", \"allocs\": %zu, \"requested\": %zu, \"consumed\": %zu, \"waste\": %zu, \"histogram\": {",
+      tag->allocs, tag->s_requested, tag->s_consumed, tag->s_consumed - tag->s_requested);
+
+    bool first = true;
+    for (uint32_t b = 0; b < ARENA_HISTOGRAM; b++) {
+      if (tag->histogram[b] == 0)
+        continue;
+      fprintf(file, "%s\"%zu\": %zu", first ? " " : ", ", (uint64_t)1 << b, tag->histogram[b]);
+      first = false;
+    }
+    fprintf(file, "%s} }", first ? "" : " ");
+  }
+  fprintf(file, "%s] }", first_tag ? "" : "\n      ");
+}
+
 bool _arena_is_full(Arena arena, uint64_t s_alloc) {
   assert(arena != NULL);
-  char* stack_ptr = (char*)_arena_ptr_incr(
-    arena->ptr,
-    arena->is_aligned ? s_word * _arena_utils_ceil((s_alloc + 1)/arena->s_block) : (s_alloc + 1)
-  );
-  return (ptrdiff_t)(stack_ptr - (char*)arena->ptr) >= (ptrdiff_t)arena->s_arena;
+  uint64_t s_used = (uint64_t)_arena_ptr_diff(arena->ptr, _arena_get_base_ptr(arena)),
+           s_need = _arena_blocks_to_offset(arena, _arena_bytes_to_blocks(arena, s_alloc));
+  return s_used + s_need > _arena_size_region(arena);
+}
+
+void _arena_rewind(Arena arena, void* ptr) {
+  assert(arena != NULL && ptr != NULL);
+  uint64_t i_from = _arena_ptr_diff(ptr, _arena_get_base_ptr(arena)) / _arena_blocks_to_offset(arena, 1),
+           i_to   = _arena_ptr_diff(arena->ptr, _arena_get_base_ptr(arena)) / _arena_blocks_to_offset(arena, 1);
+  if (i_to > i_from) {
+    // clear the partial bytes bit by bit and the middle with memset, one bit per block
+    uint8_t* bitmap = (uint8_t*)arena->memory;
+    for (; i_from < i_to && i_from % 8 != 0; i_from++)
+      bitmap[i_from / 8] &= (uint8_t)~(1u << (i_from % 8));
+    for (; i_to > i_from && i_to % 8 != 0; i_to--)
+      bitmap[(i_to - 1) / 8] &= (uint8_t)~(1u << ((i_to - 1) % 8));
+    if (i_to > i_from)
+      memset(&bitmap[i_from / 8], 0, (i_to - i_from) / 8);
+  }
+  arena->ptr = ptr;
 }
 
 bool _arena_ptr_in_arena(Arena arena, void* ptr) {
   assert(arena != NULL);
   assert(ptr != NULL);
-  void* base_ptr = _arena_get_base_ptr(arena);
-  void* alloc_start = _arena_ptr_decr(ptr, s_word);
-  void* alloc_end = _arena_ptr_incr(ptr, *(uint64_t*)alloc_start);
-  return (char*)alloc_start >= (char*)(base_ptr) && (char*)alloc_end < ((char*)base_ptr + arena->s_arena);
+  char* base_ptr = (char*)_arena_get_base_ptr(arena),
+      * end_ptr  = base_ptr + _arena_size_region(arena);
+  char* alloc_start = (char*)_arena_ptr_decr(ptr, s_word);
+  if (alloc_start < base_ptr || alloc_start >= end_ptr)
+    return false;
+  char* alloc_end = (char*)_arena_ptr_incr(ptr, *(uint64_t*)alloc_start);
+  return alloc_end <= end_ptr;
 }
 
 bool _arena_valid_alloc(Arena* arena, void* ptr) {
   assert(arena != NULL);
   if (ptr == NULL) return false; 
   for (Arena node = *arena; node != NULL; node = node->next) {
-    if (!_arena_ptr_in_arena(*arena, ptr))
+    if (!_arena_ptr_in_arena(node, ptr))
       continue;
     *arena = node;
     return true;
@@ -296,11 +740,17 @@ bool _arena_set_bitmap(Arena arena, void* ptr, uint64_t blocks, bool full) {
 
 uint64_t _arena_size_memory(Arena arena) {
   assert(arena != NULL);
-  return arena->s_bitmap + arena->s_arena + s_word * arena->s_arena/arena->s_block;
+  return arena->s_bitmap + _arena_size_region(arena);
+}
+
+uint64_t _arena_size_region(Arena arena) {
+  assert(arena != NULL);
+  return (arena->s_arena / arena->s_block) * _arena_blocks_to_offset(arena, 1);
 }
 
 uint64_t _arena_bitmap_size(uint64_t s_arena, uint64_t s_block) {
-  return s_arena / (8 * s_block);
+  // keep the allocation region word aligned behind the bitmap
+  return _arena_utils_round_up(s_arena / (8 * s_block), s_word);
 }
 
 uint64_t _arena_get_index(Arena* arena, void *ptr) {
@@ -369,11 +819,26 @@ uint64_t _arena_utils_next_power_2(uint64_t s) {
 }
 
 uint64_t _arena_utils_bit_count(uint64_t word) {
-  uint64_t count = 0;
-  for (; word > 0; word &= (word-1), count++);
-  return count;
+  return (uint64_t)__builtin_popcountll(word);
 }
 
 uint64_t _arena_utils_ceil(double x) {
   return (uint64_t)x + ((x > (double)((uint64_t)x)) ? 1 : 0);
 }
+
+uint64_t _arena_utils_round_up(uint64_t s, uint64_t multiple) {
+  return multiple == 0 ? s : ((s + multiple - 1) / multiple) * multiple;
+}
+
+void _arena_utils_write_json_str(FILE* file, const char* str) {
+  fputc('"', file);
+  for (; *str != '\0'; str++) {
+    if (*str == '"' || *str == '\\')
+      fputc('\\', file);
+    if ((unsigned char)*str < 0x20)
+      fprintf(file, "\\u%04x", (unsigned char)*str);
+    else
+      fputc(*str, file);
+  }
+  fputc('"', file);
+}
@@ -6,6 +6,7 @@
 
 struct sk_tree {
   enum { S_NODE, K_NODE, APP_NODE, REF_NODE, LD_NODE } type;
+  uint32_t span; // source of the node under sk_profile_enable, fills the padding after type
   struct sk_tree* left, *right;
   ASTN_Ident* ld_ident;
 };
@@ -27,6 +28,7 @@ struct astn_stmt {
 struct astn_expr {
   uint32_t frow, fcol, erow, ecol;
   enum { EXPR_APP, EXPR_ABS, EXPR_IDENT } type;
+  uint32_t index; // EXPR_IDENT after ast_resolve: de Bruijn index of its binder, fills the padding after type
   union {
     struct {
       ASTN_Expr* left, *right;
@@ -35,7 +37,10 @@ struct astn_expr {
       ASTN_Ident* vars;
       ASTN_Expr*  expr;
     } abs;
-    ASTN_Ident* var;
+    struct {
+      ASTN_Ident* var;
+      ASTN_Stmt*  stmt; // the definition it refers to when it is not bound, set by ast_resolve
+    } ident;
   } fields;
 };
 
@@ -51,6 +56,24 @@ struct astn_token {
   const char* str;
 };
 
+// index of an identifier that no enclosing abstraction binds, a definition or a free name
+#define AST_UNBOUND UINT32_MAX
+
+// Arena instrumentation tags
+#define TAG_LEXER         "lexer"
+#define TAG_AST           "ast"
+#define TAG_AST_COPY      "ast_copy"
+#define TAG_SK_CONVERT    "sk_convert"
+#define TAG_SK_REDUCE     "sk_reduce"
+#define TAG_SK_OPTIMIZE   "sk_optimize"
+#define TAG_SKT_COPY      "skt_copy"
+#define TAG_SK_EVACUATE   "sk_evacuate"
+#define TAG_SK_COMPACT    "sk_compact"
+#define TAG_SK_EVAL       "sk_eval"
+#define TAG_ROOTS         "roots"
+#define TAG_SKB_LOAD      "skb_load"
+#define TAG_SK_READ       "sk_read"
+
 #define MAX_STRUCT(a, b) sizeof(a) > sizeof(b) ? sizeof(a) : sizeof(b)
 #define MAX_SIZE MAX_STRUCT( \
   struct astn_expr, \
@@ -9,7 +9,7 @@ AST* ast_create(Arena arena, const char* filename, ASTN_Stmt* stmts) {
   if (stmts == NULL)
     return NULL;
 
-  AST* ast = (AST*)arena_alloc(arena, sizeof(struct ast));
+  AST* ast = (AST*)arena_alloc_tagged(arena, sizeof(struct ast), TAG_AST);
   assert(ast != NULL);
 
   size_t s_stmts = 0;
@@ -38,7 +38,7 @@ ASTN_Stmt* astn_create_stmt(
   if (var == NULL || expr == NULL)
     return NULL;
 
-  ASTN_Stmt* stmt = (ASTN_Stmt*)arena_alloc(arena, sizeof(struct astn_stmt));
+  ASTN_Stmt* stmt = (ASTN_Stmt*)arena_alloc_tagged(arena, sizeof(struct astn_stmt), TAG_AST);
   assert(stmt != NULL);
 
   *stmt = (ASTN_Stmt){
@@ -62,7 +62,7 @@ ASTN_Expr* astn_create_expr_app(
   assert(left != NULL);
   assert(right != NULL);
   
-  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
+  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc_tagged(arena, sizeof(struct astn_expr), TAG_AST);
   assert(expr != NULL);
 
   *expr = (ASTN_Expr){
@@ -85,7 +85,7 @@ ASTN_Expr* astn_create_expr_abs(
   assert(vars != NULL);
   assert(sub_expr != NULL);
 
-  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
+  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc_tagged(arena, sizeof(struct astn_expr), TAG_AST);
   assert(expr != NULL);
 
   *expr = (ASTN_Expr){
@@ -104,16 +104,18 @@ ASTN_Expr* astn_create_expr_ident(Arena arena, ASTN_Ident* var) {
   assert(arena != NULL);
   assert(var != NULL);
 
-  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
+  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc_tagged(arena, sizeof(struct astn_expr), TAG_AST);
   assert(expr != NULL);
 
- *expr = (ASTN_Expr){
-    .frow       = var->frow,
-    .fcol       = var->fcol,
-    .erow       = var->erow,
-    .ecol       = var->ecol,
-    .type       = EXPR_IDENT,
-    .fields.var = var,
+  *expr = (ASTN_Expr){
+    .frow              = var->frow,
+    .fcol              = var->fcol,
+    .erow              = var->erow,
+    .ecol              = var->ecol,
+    .type              = EXPR_IDENT,
+    .index             = AST_UNBOUND,
+    .fields.ident.var  = var,
+    .fields.ident.stmt = NULL
   };
   return expr;
 }
@@ -122,7 +124,7 @@ ASTN_Ident* astn_create_ident(Arena arena, ASTN_Token* token, ASTN_Ident* next)
   assert(arena != NULL);
   assert(token != NULL);
 
-  ASTN_Ident* id = (ASTN_Ident*)arena_alloc(arena, sizeof(struct astn_id));
+  ASTN_Ident* id = (ASTN_Ident*)arena_alloc_tagged(arena, sizeof(struct astn_id), TAG_AST);
   assert(id != NULL);
 
   *id = (ASTN_Ident){
@@ -140,7 +142,7 @@ ASTN_Token* astn_create_token(Arena arena, const char* str, const uint32_t frow,
   assert(arena != NULL);
   assert(str != NULL);
 
-  ASTN_Token* token = (ASTN_Token*)arena_alloc(arena, sizeof(struct astn_token));
+  ASTN_Token* token = (ASTN_Token*)arena_alloc_tagged(arena, sizeof(struct astn_token), TAG_AST);
   assert(token != NULL);
 
   *token = (ASTN_Token){
@@ -156,7 +158,7 @@ ASTN_Expr* astn_copy_expr(Arena arena, ASTN_Expr* expr) {
   if (expr == NULL)
     return NULL;
 
-  ASTN_Expr* copy = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
+  ASTN_Expr* copy = (ASTN_Expr*)arena_alloc_tagged(arena, sizeof(struct astn_expr), TAG_AST_COPY);
   assert(copy != NULL);
 
   switch (expr->type) {
@@ -191,7 +193,9 @@ ASTN_Expr* astn_copy_expr(Arena arena, ASTN_Expr* expr) {
         .erow = expr->erow,
         .ecol = expr->ecol,
         .type = EXPR_IDENT,
-        .fields.var = astn_copy_ident(arena, expr->fields.var),
+        .index = expr->index,
+        .fields.ident.var  = astn_copy_ident(arena, expr->fields.ident.var),
+        .fields.ident.stmt = expr->fields.ident.stmt
       };
       break;
     }
@@ -204,7 +208,7 @@ ASTN_Ident* astn_copy_ident(Arena arena, ASTN_Ident* var) {
   if (var == NULL)
     return NULL;
 
-  ASTN_Ident* copy = (ASTN_Ident*)arena_alloc(arena, sizeof(struct astn_id));
+  ASTN_Ident* copy = (ASTN_Ident*)arena_alloc_tagged(arena, sizeof(struct astn_id), TAG_AST_COPY);
   assert(copy != NULL);
 
   *copy = (ASTN_Ident){
@@ -224,14 +228,17 @@ ASTN_Token* astn_copy_token(Arena arena, ASTN_Token* token) {
   if (token == NULL)
     return NULL;
 
-  ASTN_Token* copy = (ASTN_Token*)arena_alloc(arena, sizeof(struct astn_token));
+  ASTN_Token* copy = (ASTN_Token*)arena_alloc_tagged(arena, sizeof(struct astn_token), TAG_AST_COPY);
   assert(copy != NULL);
+
+  const char* tag = arena_tag(arena, TAG_AST_COPY);
   *copy = (ASTN_Token){
     .frow = token->frow,
     .fcol = token->fcol,
     .ecol = token->ecol,
     .str  = arena_strdup(arena, (char*)token->str)
   };
+  (void)arena_tag(arena, tag);
 
   return copy;
 }
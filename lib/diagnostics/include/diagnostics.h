@@ -0,0 +1,27 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ========================# PUBLIC #========================
+
+// Errors of one source file are collected while a phase runs and printed together by
+// diagnostics_flush, each followed by its source line and an underline. The lines are found
+// through an index of line offsets that is built on the first flush with errors, and extended
+// when a source that is still being read was grown by diagnostics_extend_source.
+typedef struct diagnostics Diagnostics;
+
+Diagnostics* diagnostics_create        (const char*);
+void         diagnostics_set_source    (Diagnostics*, const char*, size_t);
+void         diagnostics_extend_source (Diagnostics*, size_t);
+void         diagnostics_report        (Diagnostics*, uint32_t, uint32_t, uint32_t, const char*, ...)
+                                       __attribute__((format(printf, 5, 6)));
+const char*  diagnostics_get_filename  (Diagnostics*);
+size_t       diagnostics_count         (Diagnostics*);
+size_t       diagnostics_flush         (Diagnostics*, FILE*);
+void         diagnostics_destroy       (Diagnostics*);
+
+#endif // !DIAGNOSTICS_H
@@ -0,0 +1,39 @@
+#ifndef DIAGNOSTICS_PRIV_H
+#define DIAGNOSTICS_PRIV_H
+
+#include "diagnostics.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ========================# PRIVATE #========================
+
+typedef struct dg_entry {
+  char*    message;
+  uint32_t frow, fcol, ecol;
+} DG_Entry;
+
+struct diagnostics {
+  const char* filename;
+  // borrowed from the caller through diagnostics_set_source, otherwise mapped on the first flush
+  const char* source;
+  size_t      s_source;
+  bool        mapped, loaded;
+  size_t*     lines;   // offset of the first byte of every line
+  size_t      s_lines, c_lines,
+              s_indexed; // bytes of the source the lines were taken from, it may have grown since
+  DG_Entry*   entries;
+  size_t      s_entries, c_entries,
+              s_reported;
+};
+
+bool _diagnostics_load  (Diagnostics*);
+void _diagnostics_index (Diagnostics*);
+void _diagnostics_print (Diagnostics*, FILE*, DG_Entry*);
+
+#endif // !DIAGNOSTICS_PRIV_H
@@ -0,0 +1,222 @@
+#include "diagnostics_priv.h"
+
+// ========================# PUBLIC #========================
+
+Diagnostics* diagnostics_create(const char* filename) {
+  assert(filename != NULL);
+
+  Diagnostics* diagnostics = (Diagnostics*)malloc(sizeof(struct diagnostics));
+  assert(diagnostics != NULL);
+
+  *diagnostics = (Diagnostics){
+    .filename   = filename,
+    .source     = NULL,
+    .s_source   = 0,
+    .mapped     = false,
+    .loaded     = false,
+    .lines      = NULL,
+    .s_lines    = 0,
+    .c_lines    = 0,
+    .s_indexed  = 0,
+    .entries    = NULL,
+    .s_entries  = 0,
+    .c_entries  = 0,
+    .s_reported = 0
+  };
+  return diagnostics;
+}
+
+void diagnostics_set_source(Diagnostics* diagnostics, const char* source, size_t s_source) {
+  assert(diagnostics != NULL && source != NULL);
+  assert(!diagnostics->loaded);
+
+  diagnostics->source   = source;
+  diagnostics->s_source = s_source;
+  diagnostics->loaded   = true;
+}
+
+void diagnostics_extend_source(Diagnostics* diagnostics, size_t s_source) {
+  assert(diagnostics != NULL && diagnostics->loaded && !diagnostics->mapped);
+  assert(s_source >= diagnostics->s_source);
+
+  // the source set before is read further in place, the lines already indexed stay where they are
+  diagnostics->s_source = s_source;
+}
+
+void diagnostics_report(
+  Diagnostics* diagnostics, uint32_t frow, uint32_t fcol, uint32_t ecol, const char* format, ...
+) {
+  assert(diagnostics != NULL && format != NULL);
+
+  va_list args;
+  va_start(args, format);
+  int32_t s_message = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  assert(s_message >= 0);
+
+  char* message = (char*)malloc((size_t)s_message + 1);
+  assert(message != NULL);
+  va_start(args, format);
+  (void)vsnprintf(message, (size_t)s_message + 1, format, args);
+  va_end(args);
+
+  if (diagnostics->s_entries == diagnostics->c_entries) {
+    diagnostics->c_entries = diagnostics->c_entries > 0 ? 2 * diagnostics->c_entries : 1 << 4;
+    diagnostics->entries = (DG_Entry*)realloc(diagnostics->entries, diagnostics->c_entries * sizeof(DG_Entry));
+    assert(diagnostics->entries != NULL);
+  }
+  diagnostics->entries[diagnostics->s_entries++] = (DG_Entry){
+    .message = message,
+    .frow    = frow,
+    .fcol    = fcol,
+    .ecol    = ecol
+  };
+  diagnostics->s_reported++;
+}
+
+const char* diagnostics_get_filename(Diagnostics* diagnostics) {
+  assert(diagnostics != NULL);
+  return diagnostics->filename;
+}
+
+size_t diagnostics_count(Diagnostics* diagnostics) {
+  return diagnostics != NULL ? diagnostics->s_reported : 0;
+}
+
+size_t diagnostics_flush(Diagnostics* diagnostics, FILE* file) {
+  assert(diagnostics != NULL && file != NULL);
+
+  size_t s_entries = diagnostics->s_entries;
+  if (s_entries == 0)
+    return 0;
+
+  if (!diagnostics->loaded && !_diagnostics_load(diagnostics))
+    fprintf(file, "Error: Could not access or find the source file: %s\n", diagnostics->filename);
+  if (diagnostics->lines == NULL || diagnostics->s_indexed < diagnostics->s_source)
+    _diagnostics_index(diagnostics);
+
+  for (size_t i = 0; i < s_entries; i++) {
+    _diagnostics_print(diagnostics, file, &diagnostics->entries[i]);
+    free(diagnostics->entries[i].message);
+  }
+  diagnostics->s_entries = 0;
+  fflush(file);
+
+  return s_entries;
+}
+
+void diagnostics_destroy(Diagnostics* diagnostics) {
+  if (diagnostics == NULL)
+    return;
+
+  for (size_t i = 0; i < diagnostics->s_entries; i++)
+    free(diagnostics->entries[i].message);
+  free(diagnostics->entries);
+  free(diagnostics->lines);
+  if (diagnostics->mapped)
+    munmap((void*)diagnostics->source, diagnostics->s_source);
+  free(diagnostics);
+}
+
+// ========================# PRIVATE #========================
+
+bool _diagnostics_load(Diagnostics* diagnostics) {
+  assert(diagnostics != NULL);
+
+  // only the first flush gets here, a failed load leaves an empty source behind
+  diagnostics->loaded = true;
+
+  int32_t fd = open(diagnostics->filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  // an empty file cannot be mapped and has no line to show anyway
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void* source = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (source == MAP_FAILED)
+    return false;
+
+  diagnostics->source   = (const char*)source;
+  diagnostics->s_source = (size_t)st.st_size;
+  diagnostics->mapped   = true;
+  return true;
+}
+
+void _diagnostics_index(Diagnostics* diagnostics) {
+  assert(diagnostics != NULL);
+
+  if (diagnostics->lines == NULL) {
+    diagnostics->c_lines = 1 << 6;
+    diagnostics->lines = (size_t*)malloc(diagnostics->c_lines * sizeof(size_t));
+    assert(diagnostics->lines != NULL);
+    diagnostics->lines[0]  = 0;
+    diagnostics->s_lines   = 1;
+    diagnostics->s_indexed = 0;
+  }
+
+  const char* source = diagnostics->source,
+            * end    = source + diagnostics->s_source;
+  for (const char* c = source + diagnostics->s_indexed; c < end; c++) {
+    c = (const char*)memchr(c, '\n', (size_t)(end - c));
+    if (c == NULL)
+      break;
+
+    if (diagnostics->s_lines == diagnostics->c_lines) {
+      diagnostics->c_lines *= 2;
+      diagnostics->lines = (size_t*)realloc(diagnostics->lines, diagnostics->c_lines * sizeof(size_t));
+      assert(diagnostics->lines != NULL);
+    }
+    diagnostics->lines[diagnostics->s_lines++] = (size_t)(c - source) + 1;
+  }
+  diagnostics->s_indexed = diagnostics->s_source;
+}
+
+void _diagnostics_print(Diagnostics* diagnostics, FILE* file, DG_Entry* entry) {
+  assert(diagnostics != NULL && file != NULL && entry != NULL);
+
+  fprintf(file, "%s\n", entry->message);
+  if (diagnostics->source == NULL || entry->frow == 0 || entry->frow > diagnostics->s_lines)
+    return;
+
+  const char* line = diagnostics->source + diagnostics->lines[entry->frow - 1],
+            * end  = entry->frow < diagnostics->s_lines
+                   ? diagnostics->source + diagnostics->lines[entry->frow] - 1
+                   : diagnostics->source + diagnostics->s_source;
+  if (end > line && end[-1] == '\r')
+    end--;
+  size_t s_line = (size_t)(end - line);
+
+  // stderr is unbuffered, so the line and its underline are put together and written at once
+  uint32_t s_offset = entry->fcol > 0 ? entry->fcol - 1 : 0,
+           s_tilde  = entry->ecol > entry->fcol ? entry->ecol - entry->fcol : 0;
+  size_t s_buffer = s_line + s_offset + s_tilde + 16;
+  char* buffer = (char*)malloc(s_buffer);
+  assert(buffer != NULL);
+
+  char* c = buffer;
+  memcpy(c, line, s_line);
+  c += s_line;
+  *c++ = '\n';
+  // tabs are kept so that the underline lines up with the source however wide they are shown
+  for (uint32_t i = 0; i < s_offset; i++)
+    *c++ = i < s_line && line[i] == '\t' ? '\t' : ' ';
+  memcpy(c, "\033[31m^", 6);
+  c += 6;
+  memset(c, '~', s_tilde);
+  c += s_tilde;
+  memcpy(c, "\033[0m\n", 5);
+  c += 5;
+
+  fwrite(buffer, 1, (size_t)(c - buffer), file);
+  free(buffer);
+}
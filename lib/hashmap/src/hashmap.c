@@ -75,9 +75,9 @@ bool hashmap_insert(HashMap *hashmap, char *key, void *value, void free_value(vo
   for (; *current != NULL; current = &((*current)->next)) {
     if (strcmp((*current)->key, key) != 0)
       continue;
-    if (free_value) {
+    if (free_value && to_free) {
       free_value((*current)->value);
-    } else {
+    } else if (to_free) {
       free((*current)->value);
     }
     (*current)->value = value;
@@ -101,8 +101,9 @@ bool hashmap_insert(HashMap *hashmap, char *key, void *value, void free_value(vo
   assert(new_s_buckets > old_s_buckets);
   HashMap temp = (HashMap)calloc(1, sizeof(struct hashmap) + new_s_buckets * sizeof(struct hashmap_node));
   assert(temp != NULL);
-  temp->s_buckets  = new_s_buckets;
-  temp->s_elements = (*hashmap)->s_elements;
+  temp->s_buckets             = new_s_buckets;
+  temp->s_elements            = (*hashmap)->s_elements;
+  temp->load_threshold_factor = (*hashmap)->load_threshold_factor;
 
   for (uint64_t i = 0; i < old_s_buckets; i++) {
     head = &((*hashmap)->buckets[i]);
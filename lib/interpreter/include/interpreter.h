@@ -8,18 +8,46 @@
 #include <assert.h>
 
 #include "hashtable.h"
+#include "diagnostics.h"
 
 // ========================# PUBLIC #========================
 
 typedef struct sk_tree SK_Tree;
 
-HashTable ast_check     (AST*, size_t);
-void      ast_print     (AST*);
-void      ast_transform (Arena, AST*);
-SK_Tree** ast_convert   (Arena, AST*, HashTable);
-SK_Tree*  skt_beta_redu (Arena, SK_Tree*);
-SK_Tree*  skt_copy      (Arena, SK_Tree*);
-void      skt_print     (SK_Tree**, size_t);
-void      skt_write     (FILE*, SK_Tree**, size_t);
+HashTable ast_check          (AST*, size_t, Diagnostics*);
+void      ast_print          (AST*);
+void      ast_transform      (Arena, AST*);
+void      ast_resolve        (AST*, HashTable);
+SK_Tree** ast_convert        (Arena, AST*, HashTable, Diagnostics*);
+SK_Tree*  skt_beta_redu      (Arena, SK_Tree*);
+SK_Tree*  skt_copy           (Arena, SK_Tree*);
+uint64_t  skt_get_reductions (void);
+void      skt_print          (SK_Tree**, size_t);
+void      skt_write          (FILE*, SK_Tree**, size_t);
+
+// Conversion, skt_copy and the S rule interleave unrelated subtrees in the scratch arena. Compaction
+// copies the live graph of a statement into a second region in depth-first, spine-first order and
+// releases the first: never (the default), after conversion, or also after reduction, before the
+// peephole pass that follows it. The reduced tree is evacuated into the arena in that order anyway.
+typedef enum sk_compact { SK_COMPACT_OFF, SK_COMPACT_CONVERT, SK_COMPACT_PHASES } SK_Compact;
+void      skt_set_compact    (SK_Compact);
+
+// Checker and converter errors are collected in the Diagnostics until the caller flushes them.
+// One statement at a time, in source order, for drivers that do not build the whole AST.
+// ast_resolve binds every identifier to its abstraction or its definition, after ast_transform and
+// before conversion, which reads nothing else. ast_convert_stmt reduces in the scratch arena and leaves only the result in the arena.
+bool      ast_check_stmt     (HashTable*, ASTN_Stmt*, Diagnostics*);
+void      ast_transform_stmt (Arena, ASTN_Stmt*);
+void      ast_resolve_stmt   (ASTN_Stmt*, HashTable);
+SK_Tree*  ast_convert_stmt   (Arena, Arena, ASTN_Stmt*, HashTable, Diagnostics*);
+
+// Definitions compiled elsewhere (an imported module) are linked into the table as statements that
+// are already converted, ast_check_linked then checks an AST against that table.
+bool      ast_link_root      (Arena, HashTable*, SK_Tree*);
+HashTable ast_check_linked   (AST*, HashTable, Diagnostics*);
+
+// Keeps only the statements of the AST that the entries reach through the definitions their
+// identifiers refer to, in source order, after ast_resolve. The others are never converted.
+void      ast_select         (AST*, ASTN_Stmt**, size_t);
 
 #endif // !INTERPRETER_H
@@ -3,11 +3,22 @@
 
 #include "interpreter.h"
 #include "ast_priv.h"
+#include "skstats_priv.h"
+#include "sktrace_priv.h"
+#include "skprof_priv.h"
+#include "skopt_priv.h"
 
 // ========================# PRIVATE #========================
 
 #define MAX_BETA_REDUCTIONS 500
 
+// rewrite steps taken by skt_beta_redu since the start of the process
+extern __thread uint64_t _skt_reductions;
+// bytes of nodes allocated by _skt_copy on this thread, reduction steps are charged the difference
+extern __thread uint64_t _skt_copied;
+// set by skt_set_compact, ast_convert_stmt reads it before every statement
+extern SK_Compact _skt_compact_mode;
+
 typedef struct ident_list {
   bool value;
   struct ident_list* next;
@@ -17,19 +28,48 @@ IdentList* _ident_list_append       (IdentList*, bool);
 bool       _ident_list_remove       (IdentList**);
 void       _ident_list_free         (IdentList*);
 
-bool        _ast_expr_check         (ASTN_Expr*, HashTable*, Stack**, const char*);
+// abstractions enclosing an expression, innermost first, each one on the C stack of the walk
+typedef struct ast_scope {
+  ASTN_Ident*       var;
+  struct ast_scope* up;
+} ASTScope;
+
+// statements of the AST reached from the entries of ast_select, walked once each from a worklist
+typedef struct ast_reach {
+  HashMap     reached;
+  ASTN_Stmt** work;
+  size_t      s_work, c_work;
+} ASTReach;
+
+// the two regions a statement is converted and reduced in, the current one and the one its live
+// graph is compacted into, each released to its mark when the statement is done
+typedef struct skt_spaces {
+  Arena     arenas[2];
+  ArenaMark marks[2];
+  uint32_t  current;
+} SKT_Spaces;
+
+bool        _ast_expr_check         (ASTN_Expr*, HashTable*, Stack**, Diagnostics*);
 void        _ast_expr_print         (ASTN_Expr*, size_t, IdentList*);
 void        _ast_expr_transform     (Arena, ASTN_Expr*);
-SK_Tree*    _ast_expr_convert       (Arena, ASTN_Expr*, HashTable, const char*);
-SK_Tree*    _ast_expr_convert_sk    (Arena, SK_Tree*, ASTN_Ident*);
+void        _ast_expr_resolve       (ASTN_Expr*, HashTable, ASTScope*);
+SK_Tree*    _ast_expr_convert       (Arena, ASTN_Expr*, ASTScope*, Diagnostics*);
+SK_Tree*    _ast_expr_convert_node  (Arena, ASTN_Expr*, ASTScope*, Diagnostics*);
+SK_Tree*    _ast_expr_abstract      (Arena, ASTN_Expr*, ASTN_Expr*, ASTScope*, Diagnostics*, bool*);
+SK_Tree*    _ast_expr_abstract_node (Arena, ASTN_Expr*, ASTN_Expr*, ASTScope*, Diagnostics*, bool*);
+SK_Tree*    _skt_abstract           (Arena, SK_Tree*, ASTN_Ident*);
+SK_Tree*    _ast_stmt_define        (Arena, Arena, ASTN_Stmt*, SK_Tree*);
+void        _ast_expr_report_later  (ASTN_Expr*, Diagnostics*);
+void        _ast_stmt_reach         (ASTReach*, ASTN_Stmt*);
+void        _ast_expr_reach         (ASTReach*, ASTN_Expr*);
+SK_Tree*    _skt_node               (Arena, uint32_t, SK_Tree*, SK_Tree*, ASTN_Ident*);
 
+SK_Tree*    _skt_copy               (Arena, SK_Tree*);
+SK_Tree*    _skt_evacuate           (Arena, Arena, SK_Tree*);
+SK_Tree*    _skt_compact            (SKT_Spaces*, SK_Tree*);
 void        _sk_print_expr          (SK_Tree*, size_t, IdentList*);
+SK_Tree*    _skt_optimize_counted   (Arena, SK_Tree*);
+bool        _skt_is_redex           (SK_Tree*);
 SK_Tree*    _skt_get_leftmost       (SK_Tree*, size_t*);
-void        _sk_write_expr          (FILE*, SK_Tree*);
-
-bool        _ast_in_free_var_set    (ASTN_Expr*, ASTN_Ident*);
-bool        _ast_in_free_var_set_sk (SK_Tree*, ASTN_Ident*);
-
-void        _error_underline        (const char*, const uint32_t, const uint32_t, const uint32_t);
 
 #endif // !INTERPRETER_PRIV_H
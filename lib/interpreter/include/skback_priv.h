@@ -0,0 +1,23 @@
+#ifndef SKBACK_PRIV_H
+#define SKBACK_PRIV_H
+
+#include "interpreter_priv.h"
+
+// ========================# PRIVATE #========================
+
+// The backends that evaluate the lambda terms read their normal form back into an SK tree: a
+// name applied to arguments is written as it is, and a function is applied to a variable of its
+// own, its result read back and abstracted again. Each read back of the same function gets
+// another variable, so that nested ones are not mixed up. A definition they cannot read back
+// within their limits is converted and reduced as SK instead.
+
+// steps and read back nodes one definition may take on the Krivine machine and the graph reducer,
+// and how deep its normal form may nest (the read back recurses on it), before it falls back
+#define SK_BACK_MAX_STEPS (1u << 22)
+#define SK_BACK_MAX_DEPTH (1u << 12)
+
+ASTN_Ident* _sk_back_var      (Arena);
+SK_Tree*    _sk_back_abstract (Arena, SK_Tree*, ASTN_Ident*);
+SK_Tree*    _sk_back_convert  (Arena, Arena, ASTN_Stmt*, HashTable, Diagnostics*, const char*, const char*);
+
+#endif // !SKBACK_PRIV_H
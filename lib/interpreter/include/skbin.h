@@ -0,0 +1,31 @@
+#ifndef SKBIN_H
+#define SKBIN_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Binary SK program (.skb): a flat node array with self-relative child references,
+// a root table and a symbol table. The file is mmaped as is, see skbin_priv.h for the layout.
+typedef struct skb_image SKB_Image;
+
+// A module cache also records the hash of the source it was compiled from and the hash of every
+// module it imported, so a stale cache is told apart without compiling anything.
+typedef struct skb_module_dep {
+  const char* name;
+  uint64_t    hash;
+} SKB_Dep;
+
+bool       skb_write           (FILE*, SK_Tree**, size_t);
+bool       skb_write_module    (FILE*, SK_Tree**, size_t, uint64_t, const SKB_Dep*, size_t);
+
+SKB_Image* skb_load            (const char*);
+SK_Tree**  skb_get_roots       (Arena, SKB_Image*);
+size_t     skb_get_size_roots  (SKB_Image*);
+size_t     skb_get_size_nodes  (SKB_Image*);
+uint64_t   skb_get_source_hash (SKB_Image*);
+size_t     skb_get_size_deps   (SKB_Image*);
+SKB_Dep    skb_get_dep         (SKB_Image*, size_t);
+void       skb_unload          (SKB_Image*);
+
+#endif // !SKBIN_H
@@ -0,0 +1,79 @@
+#ifndef SKBIN_PRIV_H
+#define SKBIN_PRIV_H
+
+#include "skbin.h"
+#include "ast_priv.h"
+#include "skindex_priv.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ========================# PRIVATE #========================
+
+// Layout (host byte order, the magic tells a foreign file apart):
+//   header | nodes[s_nodes] | roots[s_roots] | deps[s_deps] | symbols[s_symbols]
+// Children always come before their parent in the node array, so every reference is a negative
+// offset from the referencing node and a loaded image is a DAG by construction.
+// source_hash and deps are only set when the image is the cache of an imported module.
+#define SKB_MAGIC   0x31424b53u // "SKB1"
+#define SKB_VERSION 2u
+#define SKB_ALIGN   8u
+
+struct skb_header {
+  uint32_t magic, version;
+  uint32_t s_nodes, s_roots, s_symbols, s_deps;
+  uint64_t nodes_offset, roots_offset, deps_offset, symbols_offset;
+  uint64_t source_hash;
+};
+
+// type is the SK_Tree node type. APP: left and right are relative node offsets,
+// REF: left is the relative offset of the shared node and right the symbol of the definition
+// it names (-1 for a share made by reduction), LD: left is a symbol offset
+struct skb_node {
+  uint32_t type;
+  int32_t  left, right;
+};
+
+struct skb_root {
+  uint32_t node;   // index into the node array
+  uint32_t symbol; // offset of the definition name in the symbol table
+};
+
+struct skb_dep {
+  uint64_t hash;   // what the imported module hashed to when this image was written
+  uint32_t symbol; // offset of the module name in the symbol table
+  uint32_t reserved;
+};
+
+struct skb_image {
+  void*  memory;
+  size_t s_memory;
+  const struct skb_header* header;
+  struct skb_node*         nodes;
+  const struct skb_root*   roots;
+  const struct skb_dep*    deps;
+  const char*              symbols;
+};
+
+typedef struct skb_writer {
+  SK_Index         index;  // node index of every subtree written, so a share stays shared
+  HashMap          names;
+  struct skb_node* nodes;
+  size_t           s_nodes, c_nodes;
+  char*            symbols;
+  size_t           s_symbols, c_symbols;
+} SKB_Writer;
+
+uint32_t _skb_emit           (SKB_Writer*, const SK_Tree*);
+uint32_t _skb_emit_symbol    (SKB_Writer*, const char*);
+uint32_t _skb_push_node      (SKB_Writer*, struct skb_node);
+bool     _skb_write_padding  (FILE*, uint64_t);
+
+bool     _skb_valid_header   (const struct skb_header*, size_t);
+bool     _skb_valid_child    (uint32_t, int32_t);
+
+#endif // !SKBIN_PRIV_H
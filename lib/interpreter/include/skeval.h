@@ -0,0 +1,17 @@
+#ifndef SKEVAL_H
+#define SKEVAL_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// A second backend: every definition of the checked and resolved AST is evaluated to its normal
+// form by a lazy Krivine machine, on environments of shared thunks instead of S and K, and only the
+// normal form goes through bracket abstraction. The roots are SK trees like those of ast_convert.
+// Definitions linked from compiled modules are run as S and K on the same machine. A definition
+// that does not reach a normal form within SK_BACK_MAX_STEPS, or whose normal form nests deeper
+// than SK_BACK_MAX_DEPTH, is converted and reduced as SK instead.
+SK_Tree** ast_evaluate  (Arena, AST*, HashTable, Diagnostics*);
+uint64_t  ske_get_steps (void);
+
+#endif // !SKEVAL_H
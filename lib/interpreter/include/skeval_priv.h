@@ -0,0 +1,92 @@
+#ifndef SKEVAL_PRIV_H
+#define SKEVAL_PRIV_H
+
+#include "skeval.h"
+#include "interpreter_priv.h"
+#include "skindex_priv.h"
+#include "skback_priv.h"
+
+// ========================# PRIVATE #========================
+
+typedef struct ske_value SKE_Value;
+typedef struct ske_thunk SKE_Thunk;
+
+// the environment of a closure, de Bruijn index i is i links up, and the arguments applied to a
+// neutral term or a combinator, the last one first
+typedef struct ske_env {
+  SKE_Thunk*      thunk;
+  struct ske_env* up;
+} SKE_Env;
+
+// weak head normal forms: an abstraction with its environment, a variable (free in the program or
+// made up by the read back) applied to arguments, or S and K waiting for their arguments
+struct ske_value {
+  enum { SKE_CLOSURE, SKE_NEUTRAL, SKE_COMBINATOR } type;
+  uint32_t s_args;
+  union {
+    struct {
+      ASTN_Expr* abs;
+      SKE_Env*   env;
+    } closure;
+    struct {
+      ASTN_Ident* head;
+      SKE_Env*    args;
+    } neutral;
+    struct {
+      uint32_t type; // S_NODE or K_NODE
+      SKE_Env* args;
+    } combinator;
+  } fields;
+};
+
+// a thunk is overwritten with its value the first time it is forced, every later use shares it
+struct ske_thunk {
+  enum { SKE_EXPR, SKE_APPLY, SKE_TREE, SKE_VALUE, SKE_BLACKHOLE } state;
+  union {
+    struct {
+      ASTN_Expr* expr;
+      SKE_Env*   env;
+    } expr;
+    struct {
+      SKE_Thunk* fun, *arg;
+    } apply;
+    SK_Tree*   tree;
+    SKE_Value* value;
+  } fields;
+};
+
+// an argument waiting for the function being evaluated, or a thunk to overwrite with the value
+typedef struct ske_frame {
+  enum { SKE_ARG, SKE_UPDATE } type;
+  uint32_t   state; // of the thunk before it was blackholed, restored when the machine gives up
+  SKE_Thunk* thunk;
+} SKE_Frame;
+
+typedef struct ske_machine {
+  Arena        arena;
+  Diagnostics* diagnostics;
+  SKE_Frame*   stack;
+  size_t       s_stack, capacity;
+  SK_Index     globals;  // definition to the thunk of its value
+  uint64_t     s_steps, s_budget;
+  uint32_t     s_depth;
+  bool         looped;
+} SKE_Machine;
+
+// steps taken by the machine on this thread, read back nodes included
+extern __thread uint64_t _ske_steps;
+
+SK_Tree*    _ske_evaluate_stmt (SKE_Machine*, Arena, ASTN_Stmt*, HashTable);
+SKE_Value*  _ske_force         (SKE_Machine*, SKE_Thunk*);
+SK_Tree*    _ske_read_back     (SKE_Machine*, SKE_Value*);
+SK_Tree*    _ske_read_back_app (SKE_Machine*, SK_Tree*, SKE_Env*);
+SKE_Thunk*  _ske_global        (SKE_Machine*, ASTN_Stmt*);
+void        _ske_unwind        (SKE_Machine*, size_t);
+void        _ske_push          (SKE_Machine*, uint32_t, SKE_Thunk*);
+
+SKE_Thunk*  _ske_thunk         (SKE_Machine*, uint32_t);
+SKE_Value*  _ske_value         (SKE_Machine*, uint32_t, uint32_t);
+SKE_Thunk*  _ske_neutral       (SKE_Machine*, ASTN_Ident*);
+SKE_Env*    _ske_env           (SKE_Machine*, SKE_Thunk*, SKE_Env*);
+
+#endif // !SKEVAL_PRIV_H
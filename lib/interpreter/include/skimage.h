@@ -0,0 +1,25 @@
+#ifndef SKIMAGE_H
+#define SKIMAGE_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Heap image (.ski): reduced roots, the statements naming them and the interned names, written in
+// the layout they have in memory for a fixed address. ski_load maps the file read only at that
+// address and uses it as is, so a run starting from a large prelude only pays the page faults of
+// the definitions it reaches, and every run mapping the same image shares its pages. When the
+// address is taken the image is mapped privately and relocated instead, see skimage_priv.h.
+typedef struct ski_image SKI_Image;
+
+bool        ski_write          (FILE*, SK_Tree**, size_t);
+
+SKI_Image*  ski_load           (const char*);
+ASTN_Stmt*  ski_get_stmts      (SKI_Image*); // linked through next, in the order they were written
+size_t      ski_get_size_stmts (SKI_Image*);
+size_t      ski_get_size_nodes (SKI_Image*);
+bool        ski_is_relocated   (SKI_Image*);
+bool        ski_contains       (SKI_Image*, const void*);
+void        ski_unload         (SKI_Image*);
+
+#endif // !SKIMAGE_H
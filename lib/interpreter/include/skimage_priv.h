@@ -0,0 +1,76 @@
+#ifndef SKIMAGE_PRIV_H
+#define SKIMAGE_PRIV_H
+
+#include "skimage.h"
+#include "ast_priv.h"
+#include "skindex_priv.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ========================# PRIVATE #========================
+
+// Layout (host byte order and struct layout, the header records both):
+//   header | nodes[s_nodes] | stmts[s_stmts] | idents[s_idents] | tokens[s_idents] | symbols[s_symbols]
+// Every pointer in the file is absolute, for the image mapped at base. There is one identifier
+// and one token per distinct name, the nth identifier points to the nth token. Only the header
+// and the statements are checked on load, the graph is trusted like the program that wrote it,
+// reading all of it would fault in every page.
+#define SKI_MAGIC   0x31494b53u // "SKI1"
+#define SKI_VERSION 1u
+#define SKI_BASE    ((uintptr_t)0x200000000000ull)
+#define SKI_ALIGN   8u
+
+// where the node at index lands in an image mapped at SKI_BASE, the nodes come right after the header
+#define SKI_NODE(index) ((SK_Tree*)(SKI_BASE + sizeof(struct ski_header) + (index) * sizeof(struct sk_tree)))
+// moves a pointer of an image mapped elsewhere by delta, NULL stays NULL
+#define SKI_MOVE(ptr, delta) ((ptr) = (ptr) != NULL ? (void*)((uintptr_t)(ptr) + (delta)) : NULL)
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+struct ski_header {
+  uint32_t magic, version;
+  uint32_t s_tree, s_stmt, s_ident, s_token; // sizeof of each struct for the writer
+  uint64_t base, s_image;
+  uint64_t s_nodes, s_stmts, s_idents, s_symbols;
+  uint64_t nodes_offset, stmts_offset, idents_offset, tokens_offset, symbols_offset;
+};
+
+struct ski_image {
+  void*  memory;
+  size_t s_memory;
+  const struct ski_header* header;
+  ASTN_Stmt* stmts;
+  bool       relocated;
+};
+
+// nodes are staged with their children already pointing into the image, ld_ident holds the
+// identifier index plus one and str of a token its symbol offset until the offsets are known
+typedef struct ski_writer {
+  SK_Index           index;  // image offset of every subtree staged, so a share stays shared
+  HashMap            names;
+  struct sk_tree*    nodes;
+  size_t             s_nodes, c_nodes;
+  struct astn_id*    idents;
+  struct astn_token* tokens;
+  size_t             s_idents, c_idents;
+  char*              symbols;
+  size_t             s_symbols, c_symbols;
+} SKI_Writer;
+
+uint64_t _ski_emit           (SKI_Writer*, const SK_Tree*);
+uint64_t _ski_emit_ident     (SKI_Writer*, const char*);
+void     _ski_fix            (SKI_Writer*, const struct ski_header*, struct astn_stmt*);
+void     _ski_relocate       (SKI_Image*, uintptr_t);
+
+bool     _ski_valid_header   (const struct ski_header*, size_t);
+bool     _ski_valid_stmts    (SKI_Image*);
+bool     _ski_within         (const struct ski_header*, const void*, uint64_t, uint64_t, size_t);
+
+#endif // !SKIMAGE_PRIV_H
@@ -0,0 +1,30 @@
+#ifndef SKINDEX_PRIV_H
+#define SKINDEX_PRIV_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+
+// ========================# PRIVATE #========================
+
+// Map keyed by address, from a node or a definition to what a pass keeps about it: an offset, a
+// hash or a pointer of its own. Open addressing with linear probing on a Fibonacci hash of the
+// address, kept at most half full, with NULL as the empty key.
+typedef struct sk_index {
+  const void** keys;
+  uint64_t*    values;
+  size_t       s_index, capacity;
+} SK_Index;
+
+#define SK_INDEX_EMPTY ((SK_Index){ .keys = NULL, .values = NULL, .s_index = 0, .capacity = 0 })
+
+bool        _sk_index_get       (SK_Index*, const void*, uint64_t*);
+void        _sk_index_put       (SK_Index*, const void*, uint64_t);
+void*       _sk_index_get_ptr   (SK_Index*, const void*);
+void        _sk_index_put_ptr   (SK_Index*, const void*, void*);
+void        _sk_index_clear     (SK_Index*);
+void        _sk_index_free      (SK_Index*);
+
+#endif // !SKINDEX_PRIV_H
@@ -0,0 +1,21 @@
+#ifndef SKNET_H
+#define SKNET_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// An experimental fourth backend: every definition is compiled, together with the definitions it
+// refers to, into a net of interaction combinators (a lambda and an application are both a
+// constructor, a variable or a definition used more than once goes through duplicators), the net
+// is reduced by its local rewrites on skn_set_threads threads at once, and its normal form is read
+// back and converted with bracket abstraction, like the Krivine one. Nodes are labelled with
+// their level and every use of a variable goes through the croissant and brackets of Lamping's
+// algorithm, so a duplicator meeting a copy of itself passes through it. A definition that does
+// not reach a normal form within SKN_MAX_STEPS interactions, or whose net cannot be read back, is
+// converted and reduced as SK instead.
+SK_Tree** ast_interact    (Arena, AST*, HashTable, Diagnostics*);
+void      skn_set_threads (uint32_t);
+uint64_t  skn_get_steps   (void);
+
+#endif // !SKNET_H
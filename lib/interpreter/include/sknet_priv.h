@@ -0,0 +1,207 @@
+#ifndef SKNET_PRIV_H
+#define SKNET_PRIV_H
+
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "sknet.h"
+#include "interpreter_priv.h"
+#include "skindex_priv.h"
+#include "skback_priv.h"
+
+// ========================# PRIVATE #========================
+
+// interactions one definition may take, nodes its net may grow to (mapped up front, only touched
+// as they are used) and how deep its normal form may nest before it falls back to the SK path
+#define SKN_MAX_STEPS   (1u << 22)
+#define SKN_MAX_NODES   (1u << 23)
+#define SKN_MAX_DEPTH   (1u << 14)
+#define SKN_MAX_THREADS 1024
+
+// nodes and wires a thread takes at once, interactions the calling thread makes alone before the
+// others are started, redexes a thread keeps to itself while another one is idle, and how often a
+// thread adds its interactions to the shared count
+#define SKN_CHUNK    (1u << 10)
+#define SKN_PARALLEL (1u << 12)
+#define SKN_SHARE    (1u << 5)
+#define SKN_FLUSH    (1u << 10)
+
+// A port is the tag of what it points to and its index. A CON, DUP or NAM port is the principal
+// port of that node, an ERA port an eraser, a VAR port one end of a wire. The aux ports of a node
+// are written once, when it is made, so that a wire whose end is moved by an interaction is
+// redirected through its cell in vars instead: the first end to be linked leaves what it now
+// points to there, the second one takes it and links the two, see _skn_link.
+typedef uint64_t SKN_Port;
+enum { SKN_NONE, SKN_VAR, SKN_ERA, SKN_CON, SKN_DUP, SKN_NAM, SKN_FREED, SKN_ROOT };
+
+#define SKN_PORT(tag, index) ((SKN_Port)(index) << 3 | (tag))
+#define SKN_TAG(port)        ((uint32_t)(port) & 7)
+#define SKN_INDEX(port)      ((uint32_t)((port) >> 3))
+
+// the other control nodes of Lamping's algorithm, behind a DUP port like the duplicator: a
+// croissant opens the argument a variable is bound to where it is used, a bracket takes it
+// through the argument that use is inside of. Both have one aux port.
+enum { SKN_CROISSANT = 8, SKN_BRACKET };
+
+// A lambda is a CON whose principal port is its value, aux 0 its variable and aux 1 its body. An
+// application is a CON whose principal port takes the function, aux 0 the argument and aux 1 its
+// value, so β is the annihilation of the two. A DUP takes a value at its principal port and gives
+// a copy at each aux port. The label of a CON or a control node is its level, the number of
+// arguments it is inside of: two control nodes of one kind and level pair up, otherwise the one
+// of the higher level passes through the other, one level down through a croissant and one up
+// through a bracket, see _skn_interact. A NAM is a free name, its label is the name and aux 0
+// keeps the application it is stuck in. The ROOT takes the definition in aux 0.
+typedef struct skn_node {
+  SKN_Port ports[2];
+  uint32_t kind, label;
+} SKN_Node;
+
+typedef struct skn_redex {
+  SKN_Port a, b;
+} SKN_Redex;
+
+typedef struct skn_indices {
+  uint32_t* items;
+  size_t    s_items, capacity;
+} SKN_Indices;
+
+// the redexes of a thread are its own, the shared ones are those it handed out to idle threads
+typedef struct skn_worker {
+  struct skn_machine* machine;
+  SKN_Redex*      redexes;
+  size_t          s_redexes, c_redexes;
+  SKN_Redex*      shared;
+  size_t          s_shared, c_shared;
+  pthread_mutex_t lock;
+  SKN_Indices     free_nodes, free_vars;
+  uint32_t        next_node, end_node, next_var, end_var;
+  uint64_t        s_steps; // not yet added to the machine
+  pthread_t       thread;
+} SKN_Worker;
+
+// the ports standing for the uses of a binder or a definition, handed out in source order, and
+// the level of the binder, 0 for a definition
+typedef struct skn_uses {
+  SKN_Port* ports;
+  uint32_t  s_ports, next, level;
+} SKN_Uses;
+
+// The read back follows a path through the net with a context, one stack per level: going
+// through a duplicator from one of its copies pushes which one on the stack of its level, a
+// croissant inserts a level holding a star and a bracket pairs its level with the next one. The
+// other way round the same node pops, removes or splits. Contexts are never changed in place.
+enum { SKN_COPY0, SKN_COPY1, SKN_STAR, SKN_PAIR };
+
+typedef struct skn_stack {
+  uint32_t                item;
+  const struct skn_stack* pair[2];
+  const struct skn_stack* next;
+} SKN_Stack;
+
+// level 0 first, the levels past the end are empty
+typedef struct skn_context {
+  const SKN_Stack*          level;
+  const struct skn_context* next;
+} SKN_Context;
+
+// the names a lambda is read with, innermost first, and the context it was reached in
+typedef struct skn_binding {
+  ASTN_Ident*               var;
+  const SKN_Context*        context;
+  const struct skn_binding* next;
+} SKN_Binding;
+
+// where a port is written, an aux port of a node or the cell of a wire
+typedef uint64_t SKN_Loc;
+
+#define SKN_SLOT(node, slot) ((SKN_Loc)(node) << 2 | (slot))
+#define SKN_CELL(var)        ((SKN_Loc)(var) << 2 | 2)
+#define SKN_NOWHERE          ((SKN_Loc)3)
+
+typedef struct skn_machine {
+  Arena        arena;
+  Diagnostics* diagnostics;
+  SKN_Node*    nodes;
+  SKN_Port*    vars;
+  size_t       s_map;
+  uint32_t     s_nodes, s_vars; // taken so far, in chunks
+  uint64_t     s_steps;
+  uint32_t     s_active, s_started;
+  bool         aborted;
+  SKN_Worker*  workers;
+  uint32_t     s_workers;
+  uint32_t     root;
+  ASTN_Ident** names;
+  uint32_t     s_names, c_names;
+  ASTN_Expr*   combinators[2]; // S and K as lambda terms, for definitions linked as SK trees
+  SK_Index     globals, fallen; // definition to its uses, and those that fell back to SK
+  ASTN_Stmt**  order;
+  size_t       s_order, c_order;
+  uint32_t*    counts, *open;  // uses of every binder of the expression being compiled, in preorder
+  size_t       s_counts, c_counts, s_open, c_open, next_count;
+  SKN_Uses*    binders;
+  size_t       s_binders, c_binders;
+  SKN_Loc*     owners, *holders; // read back: both ends of every wire, who points to every node
+  SKN_Binding** bound;
+  uint64_t     s_read;
+  uint32_t     s_depth;
+} SKN_Machine;
+
+// interactions made on this thread's definitions, by all the threads reducing them
+extern __thread uint64_t _skn_steps;
+
+bool        _skn_create        (SKN_Machine*, Arena, Diagnostics*);
+void        _skn_destroy       (SKN_Machine*);
+void        _skn_reset         (SKN_Machine*);
+SK_Tree*    _skn_evaluate_stmt (SKN_Machine*, Arena, ASTN_Stmt*, HashTable);
+
+void        _skn_build         (SKN_Machine*, ASTN_Stmt*);
+void        _skn_reach         (SKN_Machine*, ASTN_Expr*);
+SKN_Port    _skn_definition    (SKN_Machine*, ASTN_Stmt*);
+SKN_Port    _skn_term          (SKN_Machine*, ASTN_Expr*, uint32_t);
+void        _skn_count         (SKN_Machine*, ASTN_Expr*);
+SKN_Port    _skn_compile       (SKN_Machine*, ASTN_Expr*, uint32_t);
+SKN_Port    _skn_tree          (SKN_Machine*, SK_Tree*, uint32_t);
+SKN_Port    _skn_share         (SKN_Machine*, SKN_Uses*);
+SKN_Port    _skn_use           (SKN_Machine*, SKN_Port, uint32_t, uint32_t);
+SKN_Port    _skn_name          (SKN_Machine*, ASTN_Ident*);
+ASTN_Expr*  _skn_ast           (Arena, uint32_t, ASTN_Expr*, ASTN_Expr*, uint32_t);
+
+bool        _skn_reduce        (SKN_Machine*);
+void*       _skn_run           (void*);
+void        _skn_interact      (SKN_Worker*, SKN_Port, SKN_Port);
+void        _skn_commute       (SKN_Worker*, SKN_Port, SKN_Port);
+uint32_t    _skn_arity         (uint32_t);
+void        _skn_link          (SKN_Worker*, SKN_Port, SKN_Port);
+void        _skn_push          (SKN_Worker*, SKN_Port, SKN_Port);
+void        _skn_give          (SKN_Worker*);
+bool        _skn_steal         (SKN_Worker*);
+bool        _skn_wait          (SKN_Worker*);
+bool        _skn_any_shared    (SKN_Machine*);
+void        _skn_start         (SKN_Machine*);
+uint32_t    _skn_node          (SKN_Worker*, uint32_t, uint32_t);
+uint32_t    _skn_var           (SKN_Worker*);
+void        _skn_free_node     (SKN_Worker*, uint32_t);
+void        _skn_free_var      (SKN_Worker*, uint32_t);
+
+SK_Tree*    _skn_read_back     (SKN_Machine*);
+SK_Tree*    _skn_read_port     (SKN_Machine*, SKN_Port, SKN_Loc, const SKN_Context*);
+SK_Tree*    _skn_read_loc      (SKN_Machine*, SKN_Loc, const SKN_Context*);
+SK_Tree*    _skn_read_holder   (SKN_Machine*, uint32_t, const SKN_Context*);
+SK_Tree*    _skn_read_var      (SKN_Machine*, uint32_t, const SKN_Context*);
+SKN_Loc     _skn_other_end     (SKN_Machine*, uint32_t, SKN_Loc);
+void        _skn_register      (SKN_Machine*, SKN_Port, SKN_Loc);
+
+const SKN_Stack*   _skn_stack_push      (SKN_Machine*, uint32_t, const SKN_Stack*, const SKN_Stack*, const SKN_Stack*);
+bool               _skn_stack_equal     (const SKN_Stack*, const SKN_Stack*);
+const SKN_Stack*   _skn_context_get     (const SKN_Context*, uint32_t);
+const SKN_Context* _skn_context_set     (SKN_Machine*, const SKN_Context*, uint32_t, const SKN_Stack*);
+const SKN_Context* _skn_context_insert  (SKN_Machine*, const SKN_Context*, uint32_t, const SKN_Stack*);
+const SKN_Context* _skn_context_remove  (SKN_Machine*, const SKN_Context*, uint32_t);
+bool               _skn_context_agrees  (const SKN_Context*, const SKN_Context*, uint32_t);
+
+void        _skn_indices_push  (SKN_Indices*, uint32_t);
+
+#endif // !SKNET_PRIV_H
@@ -0,0 +1,30 @@
+#ifndef SKOPT_H
+#define SKOPT_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Peephole rewrites of an SK term into a smaller one that behaves the same when applied, run to
+// a fixpoint. ast_convert_stmt runs them on the converted term before skt_beta_redu, and again on
+// what it returns, since reduction only rewrites the head and leaves redexes in the arguments.
+// Only nodes allocated in the arena are rewritten, the graphs of earlier definitions a term shares
+// are left as they are. The pass is on unless sk_opt_disable is called, and counts how often each
+// rule fired.
+typedef enum sk_opt_rule {
+  SK_OPT_K_REDEX, // K x y           -> x
+  SK_OPT_I_REDEX, // S K a x         -> x
+  SK_OPT_ETA,     // S (K x) (S K a) -> x
+  SK_OPT_K_APP,   // S (K x) (K y)   -> K (x y)
+  SK_OPT_I,       // S K a           -> S K K, for a larger than one combinator
+  SK_OPT_SHARE,   // &(x)            -> x, for a share of a combinator, a free variable or a REF
+  SK_OPT_RULES
+} SK_OptRule;
+
+SK_Tree*    skt_optimize      (Arena, SK_Tree*);
+uint64_t    skt_get_rewrites  (SK_OptRule);
+const char* sk_opt_rule_name  (SK_OptRule);
+void        sk_opt_enable     (void);
+void        sk_opt_disable    (void);
+
+#endif // !SKOPT_H
@@ -0,0 +1,37 @@
+#ifndef SKOPT_PRIV_H
+#define SKOPT_PRIV_H
+
+#include "skopt.h"
+#include "ast_priv.h"
+#include "skstats_priv.h"
+#include "skindex_priv.h"
+
+// ========================# PRIVATE #========================
+
+// A rule returns what replaces the application it is given, or NULL when it does not match.
+// It may only change that application itself, into an equal term: after reduction a node can be
+// reached both directly and through a REF, and whatever sees it through the other path has to
+// keep seeing the same term. New applications are allocated in the arena.
+typedef SK_Tree* (*SK_OptRewrite)(Arena, SK_Tree*);
+
+typedef struct sko_pass {
+  Arena     arena;
+  SK_Index  shares;  // shares already rewritten in the pass to their rewrite, a share is rewritten once
+  bool      changed;
+} SKO_Pass;
+
+// false once sk_opt_disable is called, ast_convert_stmt tests it before every statement
+extern bool _sk_opt_enabled;
+// rewrites per rule made by skt_optimize on this thread
+extern __thread uint64_t _skt_rewrites[SK_OPT_RULES];
+
+SK_Tree*    _skt_opt_expr     (SKO_Pass*, SK_Tree*);
+SK_Tree*    _skt_opt_k_redex  (Arena, SK_Tree*);
+SK_Tree*    _skt_opt_i_redex  (Arena, SK_Tree*);
+SK_Tree*    _skt_opt_eta      (Arena, SK_Tree*);
+SK_Tree*    _skt_opt_k_app    (Arena, SK_Tree*);
+SK_Tree*    _skt_opt_i        (Arena, SK_Tree*);
+SK_Tree*    _skt_opt_share    (Arena, SK_Tree*);
+bool        _skt_opt_is       (SK_Tree*, uint32_t, uint32_t);
+
+#endif // !SKOPT_PRIV_H
@@ -0,0 +1,18 @@
+#ifndef SKPROF_H
+#define SKPROF_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Source level profile of reduction. While it is enabled, every SK node made by the converter
+// carries the index of the .ld expression it came from (kept through reductions and copies), and
+// every reduction step and the bytes it allocates are charged to the expression of the combinator
+// or REF that fired, per definition being reduced. sk_profile_write prints the totals as folded
+// stacks, "reduced definition;source definition;expression count" lines that flamegraph.pl,
+// inferno or speedscope read as they are.
+bool sk_profile_enable  (void);
+bool sk_profile_write   (FILE*, bool);
+void sk_profile_disable (void);
+
+#endif // !SKPROF_H
@@ -0,0 +1,44 @@
+#ifndef SKPROF_PRIV_H
+#define SKPROF_PRIV_H
+
+#include "skprof.h"
+#include "ast_priv.h"
+
+#include <string.h>
+
+// ========================# PRIVATE #========================
+
+// span 0 and definition 0 stand for nodes that do not come from the converter (.sk, .skb)
+typedef struct sk_span {
+  uint32_t frow, fcol, erow, ecol;
+  uint32_t def;
+  char*    label; // "\x", "app" or the identifier
+} SK_Span;
+
+// (reduced definition, span) -> totals, open addressing with linear probing
+typedef struct sk_cost {
+  uint64_t key;
+  uint64_t s_steps, s_alloc;
+} SK_Cost;
+
+typedef struct sk_profile {
+  SK_Span* spans;
+  size_t   s_spans, c_spans;
+  char**   defs;
+  size_t   s_defs, c_defs;
+  uint32_t def; // definition being converted and reduced
+  SK_Cost* costs;
+  size_t   s_costs, c_costs;
+} SK_Profile;
+
+// NULL unless sk_profile_enable was called, the converter and the reducer go through it
+extern SK_Profile* _sk_profile;
+
+void     _sk_profile_enter_def (ASTN_Ident*);
+uint32_t _sk_profile_span      (ASTN_Expr*);
+void     _sk_profile_stamp     (SK_Tree*, uint32_t);
+void     _sk_profile_charge    (SK_Tree*, uint64_t);
+SK_Cost* _sk_profile_cost      (uint64_t);
+void     _sk_profile_write_def (FILE*, uint32_t);
+
+#endif // !SKPROF_PRIV_H
@@ -0,0 +1,13 @@
+#ifndef SKREAD_H
+#define SKREAD_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Reads the text format written by skt_write back into SK_Tree roots,
+// &name references resolve to the roots defined before them
+SK_Tree** skt_read        (Arena, const char*, size_t*);
+SK_Tree** skt_read_buffer (Arena, const char*, size_t, const char*, size_t*);
+
+#endif // !SKREAD_H
@@ -0,0 +1,62 @@
+#ifndef SKREAD_PRIV_H
+#define SKREAD_PRIV_H
+
+#include "skread.h"
+#include "ast_priv.h"
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ========================# PRIVATE #========================
+
+// An identifier made only of S and K is a run of combinators ("SKK"), anything else is a name.
+// skt_write parenthesises a bare S or K that follows a name, so the two never touch.
+// &name is a definition when one of that name came before, otherwise a shared free variable.
+// "$N = term;" is a share written once by skt_write, &$N a reference to the latest $N before it.
+// Shares are not roots and keep no name, they read back as the unnamed REF targets they were.
+
+// nodes are carved out of slabs of this many, without a per-node arena header
+#define SKR_SLAB (1 << 12)
+
+// one open parenthesis, is_ref when it was opened by "&("
+typedef struct skr_frame {
+  SK_Tree* term;
+  bool     is_ref;
+} SKR_Frame;
+
+typedef struct skr_reader {
+  Arena       arena;
+  const char* filename;
+  const char* cursor,
+            * end,
+            * line;
+  uint32_t    row;
+  HashMap     defs;
+  SK_Tree**   shares;
+  size_t      s_shares, c_shares;
+  SKR_Frame*  frames;
+  size_t      s_frames, c_frames;
+  char*       key;
+  size_t      c_key;
+  SK_Tree*    slab;
+  size_t      s_slab;
+  SK_Tree*    s_node,  // every S and K leaf inside a term is one of these two, nothing writes to leaves
+         *    k_node;
+} SKR_Reader;
+
+SK_Tree*    _skr_read_term    (SKR_Reader*);
+const char* _skr_read_name    (SKR_Reader*, size_t*);
+bool        _skr_read_share   (SKR_Reader*, uint32_t*);
+SK_Tree*    _skr_node         (SKR_Reader*, uint32_t, SK_Tree*, SK_Tree*, ASTN_Ident*);
+ASTN_Ident* _skr_ident        (SKR_Reader*, const char*, size_t);
+const char* _skr_key          (SKR_Reader*, const char*, size_t);
+void        _skr_push         (SKR_Reader*, bool);
+void        _skr_apply        (SKR_Reader*, SK_Tree*);
+void        _skr_skip_space   (SKR_Reader*);
+bool        _skr_error        (SKR_Reader*, const char*);
+
+#endif // !SKREAD_PRIV_H
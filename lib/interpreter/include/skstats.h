@@ -0,0 +1,29 @@
+#ifndef SKSTATS_H
+#define SKSTATS_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Cost of one run of the pipeline: wall time per phase, node counts before and after conversion,
+// reduction steps per rule and bytes copied by skt_copy. Until sk_stats_enable is called every
+// function here returns at once and the interpreter only tests a NULL pointer.
+typedef enum sk_phase {
+  SK_PHASE_PARSE,
+  SK_PHASE_CHECK,
+  SK_PHASE_TRANSFORM,
+  SK_PHASE_CONVERT,
+  SK_PHASE_WRITE,
+  SK_PHASES
+} SK_Phase;
+
+void sk_stats_enable     (void);
+void sk_stats_begin      (SK_Phase);
+void sk_stats_end        (SK_Phase);
+void sk_stats_count_stmt (ASTN_Stmt*);
+void sk_stats_count_root (SK_Tree*);
+void sk_stats_print      (FILE*, Arena);
+void sk_stats_write_json (FILE*, Arena);
+void sk_stats_disable    (void);
+
+#endif // !SKSTATS_H
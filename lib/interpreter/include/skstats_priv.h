@@ -0,0 +1,30 @@
+#ifndef SKSTATS_PRIV_H
+#define SKSTATS_PRIV_H
+
+#include "skstats.h"
+#include "skopt.h"
+#include "ast_priv.h"
+
+#include <time.h>
+
+// ========================# PRIVATE #========================
+
+typedef struct sk_stats {
+  double   t_phases[SK_PHASES], t_starts[SK_PHASES];
+  uint64_t s_stmts, s_ast_nodes, s_sk_nodes;
+  uint64_t s_k_steps, s_s_steps, s_ref_steps;
+  uint64_t s_eval_steps; // Krivine machine steps and read back nodes of --backend=krivine
+  uint64_t s_super_steps; // supercombinator instantiations of --backend=super
+  uint64_t s_net_steps; // interactions of --backend=net, on all its threads
+  uint64_t s_copied; // bytes of SK nodes allocated by skt_copy
+  uint64_t s_rewrites[SK_OPT_RULES], s_opt_nodes; // peephole rewrites per rule, nodes they removed
+} SK_Stats;
+
+// NULL unless sk_stats_enable was called, the interpreter counts through it
+extern SK_Stats* _sk_stats;
+
+double   _sk_stats_now        (void);
+uint64_t _sk_stats_count_expr (ASTN_Expr*);
+uint64_t _sk_stats_count_sk   (SK_Tree*);
+
+#endif // !SKSTATS_PRIV_H
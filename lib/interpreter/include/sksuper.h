@@ -0,0 +1,19 @@
+#ifndef SKSUPER_H
+#define SKSUPER_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// A third backend: every abstraction of a definition is lambda lifted into a supercombinator, a
+// function of known arity taking the variables it uses from the abstractions around it and then
+// its own, and the definitions are reduced by graph reduction, which instantiates a whole body in
+// one step once as many arguments as the arity are on the spine. The normal form is read back and
+// converted with bracket abstraction, so the roots are SK trees like those of ast_convert.
+// Definitions linked from compiled modules are reduced as S and K on the same graph. A definition
+// that does not reach a normal form within SK_BACK_MAX_STEPS instantiations, or whose normal form
+// nests deeper than SK_BACK_MAX_DEPTH, is converted and reduced as SK instead.
+SK_Tree** ast_supercombine (Arena, AST*, HashTable, Diagnostics*);
+uint64_t  sks_get_steps    (void);
+
+#endif // !SKSUPER_H
@@ -0,0 +1,78 @@
+#ifndef SKSUPER_PRIV_H
+#define SKSUPER_PRIV_H
+
+#include "sksuper.h"
+#include "interpreter_priv.h"
+#include "skindex_priv.h"
+#include "skback_priv.h"
+
+// ========================# PRIVATE #========================
+
+// binders no argument of the supercombinator being built stands for, its body does not use them
+#define SKS_UNUSED UINT32_MAX
+
+typedef struct sks_node SKS_Node;
+
+// the variables of the enclosing abstractions its body uses come first, then its own binders
+typedef struct sks_comb {
+  uint32_t  arity;
+  SKS_Node* body;
+} SKS_Comb;
+
+// A body is a template of APP, ARG and leaves, instantiating it copies the APP nodes and shares the
+// leaves. On the graph a redex, always an APP node, is overwritten with the root of its instance,
+// or with an IND to it when that is not a new node, so everything sharing the redex shares the
+// result. S and K come from the SK trees of linked definitions, a NAME is a free variable or one
+// made up by the read back, a GLOBAL is another definition, looked up when the spine reaches it.
+struct sks_node {
+  enum { SKS_APP, SKS_IND, SKS_COMB, SKS_S, SKS_K, SKS_NAME, SKS_GLOBAL, SKS_ARG } type;
+  union {
+    struct {
+      SKS_Node* fun, *arg;
+    } app;
+    SKS_Node*   ind;
+    SKS_Comb*   comb;
+    ASTN_Ident* name;
+    ASTN_Stmt*  global;
+    uint32_t    arg;
+  } fields;
+};
+
+// the argument of the supercombinator being built standing for each binder in scope, by de Bruijn
+// index, SKS_UNUSED for those it does not take
+typedef struct sks_scope {
+  uint32_t* params;
+  uint32_t  s_params;
+} SKS_Scope;
+
+typedef struct sks_machine {
+  Arena        arena;
+  Diagnostics* diagnostics;
+  SKS_Node**   stack; // the spine, APP nodes with the innermost on top
+  size_t       s_stack, capacity;
+  SKS_Node**   args;  // arguments of the redex being instantiated
+  size_t       c_args;
+  SK_Index     globals, trees;  // definition to its graph, linked SK tree to its copy
+  uint64_t     s_steps, s_nodes, s_budget; // instantiations and read back nodes share the budget
+  uint32_t     s_depth;
+} SKS_Machine;
+
+// instantiations made on this thread, the S and K steps of linked definitions included
+extern __thread uint64_t _sks_steps;
+
+SK_Tree*    _sks_evaluate_stmt (SKS_Machine*, Arena, ASTN_Stmt*, HashTable);
+SKS_Node*   _sks_compile       (SKS_Machine*, ASTN_Expr*, SKS_Scope*);
+SKS_Node*   _sks_lift          (SKS_Machine*, ASTN_Expr*, SKS_Scope*);
+void        _sks_used          (ASTN_Expr*, uint32_t, bool*, uint32_t);
+SKS_Node*   _sks_instantiate   (SKS_Machine*, SKS_Node*);
+SKS_Node*   _sks_whnf          (SKS_Machine*, SKS_Node*);
+SKS_Node*   _sks_deref         (SKS_Machine*, SKS_Node*);
+SK_Tree*    _sks_read_back     (SKS_Machine*, SKS_Node*);
+SKS_Node*   _sks_global        (SKS_Machine*, ASTN_Stmt*);
+SKS_Node*   _sks_tree          (SKS_Machine*, SK_Tree*);
+void        _sks_push          (SKS_Machine*, SKS_Node*);
+
+SKS_Node*   _sks_node          (SKS_Machine*, uint32_t);
+SKS_Node*   _sks_app           (SKS_Machine*, SKS_Node*, SKS_Node*);
+
+#endif // !SKSUPER_PRIV_H
@@ -0,0 +1,35 @@
+#ifndef SKTRACE_H
+#define SKTRACE_H
+
+#include "interpreter.h"
+
+// ========================# PUBLIC #========================
+
+// Binary trace of skt_beta_redu: every rewrite step is one fixed size event in a ring buffer that
+// threads append to with a single atomic increment, the oldest events are overwritten once it is
+// full. sk_trace_dump writes the buffer to a .sktrace file, sk_trace_convert turns such a file
+// into a Chrome trace (chrome://tracing, Perfetto) or a step by step listing.
+typedef enum sk_rule {
+  SK_RULE_K,
+  SK_RULE_S,
+  SK_RULE_REF,   // a REF node unfolded into a copy of what it shares
+  SK_RULE_BEGIN, // skt_beta_redu entered, node is the root
+  SK_RULE_END    // skt_beta_redu left, step is the number of steps taken
+} SK_Rule;
+
+typedef struct sk_trace_event {
+  uint64_t time;    // nanoseconds since sk_trace_enable
+  uint64_t node;    // address of the application node the redex hangs from
+  uint32_t step;    // step within the reduction of one root
+  uint32_t depth;   // spine depth of the leftmost combinator
+  int32_t  s_alloc; // bytes allocated in the arena by the step
+  uint16_t rule;
+  uint16_t thread;
+} SK_TraceEvent;
+
+bool sk_trace_enable  (uint32_t);
+bool sk_trace_dump    (const char*);
+bool sk_trace_convert (const char*, FILE*, bool);
+void sk_trace_disable (void);
+
+#endif // !SKTRACE_H
@@ -0,0 +1,37 @@
+#ifndef SKTRACE_PRIV_H
+#define SKTRACE_PRIV_H
+
+#include "sktrace.h"
+
+#include <string.h>
+#include <time.h>
+
+// ========================# PRIVATE #========================
+
+// Layout: header | events[s_events], oldest event first, in host byte order
+#define SKTRACE_MAGIC   0x52544b53u // "SKTR"
+#define SKTRACE_VERSION 1u
+
+struct sk_trace_header {
+  uint32_t magic, version;
+  uint32_t s_event, s_events;
+  uint64_t s_dropped; // events overwritten before the dump
+};
+
+typedef struct sk_trace {
+  SK_TraceEvent* events;
+  uint64_t       mask;
+  uint64_t       head; // total events recorded, only ever incremented atomically
+  uint64_t       t_start;
+} SK_Trace;
+
+// NULL unless sk_trace_enable was called, skt_beta_redu records through it
+extern SK_Trace* _sk_trace;
+
+void     _sk_trace_record       (SK_Rule, SK_Tree*, uint32_t, uint32_t, int32_t);
+uint64_t _sk_trace_now          (void);
+void     _sk_trace_write_chrome (FILE*, const SK_TraceEvent*, uint32_t);
+void     _sk_trace_write_step   (FILE*, const SK_TraceEvent*, uint64_t, bool);
+void     _sk_trace_write_replay (FILE*, const SK_TraceEvent*, uint32_t);
+
+#endif // !SKTRACE_PRIV_H
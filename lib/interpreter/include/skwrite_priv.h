@@ -0,0 +1,44 @@
+#ifndef SKWRITE_PRIV_H
+#define SKWRITE_PRIV_H
+
+#include "interpreter.h"
+#include "ast_priv.h"
+#include "skindex_priv.h"
+
+#include <string.h>
+
+// ========================# PRIVATE #========================
+
+// A share made by reduction (a REF to a node without a name) is written inline as &(term).
+// One that is written more than once in the same skt_write call, by pointer or because another
+// share has the same structure, is written once as "$N = term;" before the first definition
+// using it and referred to as &$N. Numbers start at 1 in every call, skt_read takes the latest.
+
+// shares of equal structure, counted by how many times they would be written inline
+typedef struct skw_share {
+  const SK_Tree* node;
+  uint64_t       hash;
+  uint32_t       s_uses;
+  uint32_t       name;   // 0 until its $N definition is written
+} SKW_Share;
+
+typedef struct skw_writer {
+  FILE*      file;
+  SK_Index   index;   // structural hash of every subtree, one reached through many parents is hashed once
+  SKW_Share* shares;
+  size_t     s_shares, capacity;
+  size_t     s_repeated;  // shares written more than once, without any there is nothing to define
+  uint32_t   s_names;
+} SKW_Writer;
+
+void        _skw_count          (SKW_Writer*, const SK_Tree*);
+void        _skw_define         (SKW_Writer*, const SK_Tree*);
+void        _skw_write_expr     (SKW_Writer*, const SK_Tree*);
+SKW_Share*  _skw_share          (SKW_Writer*, const SK_Tree*);
+
+uint64_t    _skw_hash           (SKW_Writer*, const SK_Tree*);
+uint64_t    _skw_hash_str       (const char*);
+uint64_t    _skw_mix            (uint64_t, uint64_t);
+bool        _skw_equal          (SKW_Writer*, const SK_Tree*, const SK_Tree*);
+
+#endif // !SKWRITE_PRIV_H
@@ -1,30 +1,97 @@
 #include "interpreter_priv.h"
 
+__thread uint64_t _skt_reductions = 0;
+__thread uint64_t _skt_copied = 0;
+SK_Compact _skt_compact_mode = SK_COMPACT_OFF;
+
 // ========================# PUBLIC #========================
 
-HashTable ast_check(AST* ast, size_t s_hashtable) {
+HashTable ast_check(AST* ast, size_t s_hashtable, Diagnostics* diagnostics) {
   if (ast == NULL)
     return NULL;
+  assert(diagnostics != NULL);
 
-  HashTable table = hashtable_create(s_hashtable, .75);
-  Stack* stack = stack_create();
+  return ast_check_linked(ast, hashtable_create(s_hashtable, .75), diagnostics);
+}
+
+HashTable ast_check_linked(AST* ast, HashTable table, Diagnostics* diagnostics) {
+  if (ast == NULL)
+    return NULL;
+  assert(table != NULL && diagnostics != NULL);
+
+  for (ASTN_Stmt* stmt = ast->stmts; stmt != NULL; stmt = stmt->next)
+    (void)ast_check_stmt(&table, stmt, diagnostics);
+
+  return table;
+}
+
+bool ast_link_root(Arena arena, HashTable* table, SK_Tree* root) {
+  assert(arena != NULL && table != NULL && root != NULL && root->ld_ident != NULL);
+
+  if (hashtable_exists(*table, root->ld_ident->token))
+    return false;
+
+  // there is no expression to check or convert, references go straight to the reduced root
+  ASTN_Stmt* stmt = (ASTN_Stmt*)arena_alloc_tagged(arena, sizeof(struct astn_stmt), TAG_AST);
+  assert(stmt != NULL);
+  *stmt = (ASTN_Stmt){
+    .frow    = 0,
+    .fcol    = 0,
+    .erow    = 0,
+    .ecol    = 0,
+    .var     = root->ld_ident,
+    .expr    = NULL,
+    .next    = NULL,
+    .sk_expr = root
+  };
+  return hashtable_insert(table, stmt);
+}
+
+void ast_select(AST* ast, ASTN_Stmt** entries, size_t s_entries) {
+  assert(ast != NULL && (entries != NULL || s_entries == 0));
+
+  // definitions have unique names once checked, so the reached set is keyed by them
+  ASTReach reach = { .reached = hashmap_create(1 << 5, .75), .work = NULL, .s_work = 0, .c_work = 0 };
+  assert(reach.reached != NULL);
+  for (size_t i = 0; i < s_entries; i++)
+    _ast_stmt_reach(&reach, entries[i]);
+  while (reach.s_work > 0)
+    _ast_expr_reach(&reach, reach.work[--reach.s_work]->expr);
+
+  ASTN_Stmt** link = &ast->stmts;
+  size_t s_stmts = 0;
   for (ASTN_Stmt* stmt = ast->stmts; stmt != NULL; stmt = stmt->next) {
-    if (hashtable_exists(table, stmt->var->token)) {
-      fprintf(
-        stderr,
-        "[CHECKER]: reassigning expression to const variable %s in file %s at %u\n",
-        stmt->var->token->str, ast->filename, stmt->frow
-      );
-      _error_underline(ast->filename, stmt->frow, stmt->var->fcol, stmt->var->ecol);
-    }
+    if (!hashmap_exists(reach.reached, (char*)stmt->var->token->str))
+      continue;
+    *link = stmt;
+    link  = &stmt->next;
+    s_stmts++;
+  }
+  *link = NULL;
+  ast->s_stmts = s_stmts;
 
-    hashtable_insert(&table, stmt);
-    _ast_expr_check(stmt->expr, &table, &stack, ast->filename);
-    stack_clear(stack);
+  free(reach.work);
+  hashmap_free(reach.reached, NULL, false);
+}
+
+bool ast_check_stmt(HashTable* table, ASTN_Stmt* stmt, Diagnostics* diagnostics) {
+  assert(table != NULL && stmt != NULL && diagnostics != NULL);
+
+  bool check = true;
+  if (hashtable_exists(*table, stmt->var->token)) {
+    diagnostics_report(
+      diagnostics, stmt->frow, stmt->var->fcol, stmt->var->ecol,
+      "[CHECKER]: reassigning expression to const variable %s in file %s at %u",
+      stmt->var->token->str, diagnostics_get_filename(diagnostics), stmt->frow
+    );
+    check = false;
   }
 
+  hashtable_insert(table, stmt);
+  Stack* stack = stack_create();
+  check = _ast_expr_check(stmt->expr, table, &stack, diagnostics) && check;
   stack_free(stack);
-  return table;
+  return check;
 }
 
 void ast_print(AST* ast) {
@@ -44,38 +111,94 @@ void ast_print(AST* ast) {
 void ast_transform(Arena arena, AST* ast) {
   assert(arena != NULL && ast != NULL);
   for (ASTN_Stmt* stmt = ast->stmts; stmt != NULL; stmt = stmt->next)
-    _ast_expr_transform(arena, stmt->expr);
+    ast_transform_stmt(arena, stmt);
 }
 
-SK_Tree** ast_convert(Arena arena, AST* ast, HashTable table) {
-  assert(arena != NULL && ast != NULL && table != NULL);
+void ast_transform_stmt(Arena arena, ASTN_Stmt* stmt) {
+  assert(arena != NULL && stmt != NULL);
+  _ast_expr_transform(arena, stmt->expr);
+}
+
+void ast_resolve(AST* ast, HashTable table) {
+  assert(ast != NULL && table != NULL);
+  for (ASTN_Stmt* stmt = ast->stmts; stmt != NULL; stmt = stmt->next)
+    ast_resolve_stmt(stmt, table);
+}
+
+void ast_resolve_stmt(ASTN_Stmt* stmt, HashTable table) {
+  assert(stmt != NULL && table != NULL);
+  _ast_expr_resolve(stmt->expr, table, NULL);
+}
+
+SK_Tree** ast_convert(Arena arena, AST* ast, HashTable table, Diagnostics* diagnostics) {
+  assert(arena != NULL && ast != NULL && table != NULL && diagnostics != NULL);
 
   size_t s_stmts = ast->s_stmts;
-  SK_Tree** roots = (SK_Tree**)arena_alloc(arena, s_stmts * sizeof(SK_Tree*));
+  SK_Tree** roots = (SK_Tree**)arena_alloc_tagged(arena, s_stmts * sizeof(SK_Tree*), TAG_ROOTS);
   assert(roots != NULL);
 
+  Arena scratch = arena_shard_create(arena);
+  assert(scratch != NULL);
+
   ASTN_Stmt* stmt = ast->stmts;
-  for (size_t i = 0; i < s_stmts; i++, stmt = stmt->next) {
-    roots[i] = skt_beta_redu(
-      arena,
-      _ast_expr_convert(arena, stmt->expr, table, ast->filename)
-    );
-    roots[i]->ld_ident = stmt->var;
-    stmt->sk_expr = roots[i];
-  }
+  for (size_t i = 0; i < s_stmts; i++, stmt = stmt->next)
+    roots[i] = ast_convert_stmt(arena, scratch, stmt, table, diagnostics);
+  (void)arena_reset(scratch);
 
   return roots;
 }
 
+SK_Tree* ast_convert_stmt(Arena arena, Arena scratch, ASTN_Stmt* stmt, HashTable table, Diagnostics* diagnostics) {
+  assert(arena != NULL && scratch != NULL && stmt != NULL && table != NULL && diagnostics != NULL);
+
+  // conversion and reduction garbage lives in the scratch arena and is released before returning,
+  // only the reduced tree is evacuated into the arena. With compaction on, the second space is
+  // this thread's shard of the arena, which no caller hands in as its scratch.
+  SKT_Spaces spaces = { .arenas = { scratch, NULL }, .current = 0 };
+  if (_skt_compact_mode != SK_COMPACT_OFF) {
+    spaces.arenas[1] = arena_shard(scratch);
+    assert(spaces.arenas[1] != NULL && spaces.arenas[1] != scratch);
+    spaces.marks[1] = arena_mark(spaces.arenas[1]);
+  }
+  spaces.marks[0] = arena_mark(scratch);
+  const char* scratch_tag = arena_tag(scratch, TAG_SK_CONVERT);
+  if (_sk_profile != NULL)
+    _sk_profile_enter_def(stmt->var);
+
+  // a statement the converter reported on is defined as converted, its errors are only printed
+  // once the caller flushes them, which a reduction that runs out of memory would never reach
+  size_t s_errors = diagnostics_count(diagnostics);
+  SK_Tree* root = _ast_expr_convert(scratch, stmt->expr, NULL, diagnostics);
+  if (diagnostics_count(diagnostics) == s_errors) {
+    if (_skt_compact_mode != SK_COMPACT_OFF)
+      root = _skt_compact(&spaces, root);
+    if (_sk_opt_enabled)
+      root = _skt_optimize_counted(spaces.arenas[spaces.current], root);
+    root = skt_beta_redu(spaces.arenas[spaces.current], root);
+    if (_skt_compact_mode == SK_COMPACT_PHASES)
+      root = _skt_compact(&spaces, root);
+  }
+  root = _ast_stmt_define(arena, spaces.arenas[spaces.current], stmt, root);
+
+  (void)arena_tag(scratch, scratch_tag);
+  (void)arena_release(scratch, spaces.marks[0]);
+  if (spaces.arenas[1] != NULL)
+    (void)arena_release(spaces.arenas[1], spaces.marks[1]);
+  return root;
+}
+
 SK_Tree* skt_beta_redu(Arena arena, SK_Tree* root) {
   if (root == NULL)
     return NULL;
 
+  const char* tag = arena_tag(arena, TAG_SK_REDUCE);
   SK_Tree* expr = root;
-  size_t i = 0;
-  for (; i < MAX_BETA_REDUCTIONS; i++) {
-    // skt_print(&root, 1);
+  size_t i = 0, s_k_steps = 0, s_s_steps = 0;
+  uint64_t s_copied = _skt_copied;
+  if (_sk_trace != NULL)
+    _sk_trace_record(SK_RULE_BEGIN, root, 0, 0, 0);
 
+  for (; i < MAX_BETA_REDUCTIONS; i++) {
     size_t depth = 0;
     SK_Tree* leftmost = _skt_get_leftmost(expr, &depth);
     assert(leftmost != NULL);
@@ -83,43 +206,78 @@ SK_Tree* skt_beta_redu(Arena arena, SK_Tree* root) {
     if (leftmost->type == K_NODE && depth >= 2) {
       SK_Tree** sub_expr = &expr;
       for (size_t j = 0; j + 2 < depth; sub_expr = &((*sub_expr)->left), j++);
+      if (_sk_trace != NULL)
+        _sk_trace_record(SK_RULE_K, *sub_expr, (uint32_t)i, (uint32_t)depth, 0);
+      if (_sk_profile != NULL)
+        _sk_profile_charge(leftmost, 0);
       *sub_expr = (*sub_expr)->left->right;
+      s_k_steps++;
       continue;
 
     } else if (leftmost->type == S_NODE && depth >= 3) {
       SK_Tree* sub_expr = expr;
       for (size_t j = 0; j + 3 < depth; sub_expr = sub_expr->left, j++);
 
-      sub_expr->left->left->left = sub_expr->left->left->right;
-
-      SK_Tree* ref = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(ref != NULL);
-      *ref = (SK_Tree){ .type = REF_NODE, .left = sub_expr->right, .right = NULL, .ld_ident = NULL };
-
-      sub_expr->left->left->right = sub_expr->right;
-
-      SK_Tree* temp = sub_expr->left;
-      sub_expr->left = sub_expr->left->left;
-      temp->left = temp->right;
-      temp->right = ref;
-      sub_expr->right = temp;
+      // only the redex is overwritten, S x and S x y may be shared through a REF made by an earlier
+      // step and must keep their meaning, so x z and y z are new nodes
+      SK_Tree* sx  = sub_expr->left->left,
+             * sxy = sub_expr->left,
+             * z   = sub_expr->right,
+             * ref = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree)),
+             * xz  = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree)),
+             * yz  = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
+      assert(ref != NULL && xz != NULL && yz != NULL);
+
+      *ref = (SK_Tree){ .type = REF_NODE, .span = z->span,   .left = z,           .right = NULL, .ld_ident = NULL };
+      *xz  = (SK_Tree){ .type = APP_NODE, .span = sx->span,  .left = sx->right,  .right = z,    .ld_ident = NULL };
+      *yz  = (SK_Tree){ .type = APP_NODE, .span = sxy->span, .left = sxy->right, .right = ref,  .ld_ident = NULL };
+
+      sub_expr->left  = xz;
+      sub_expr->right = yz;
+      if (_sk_trace != NULL)
+        _sk_trace_record(SK_RULE_S, sub_expr, (uint32_t)i, (uint32_t)depth, (int32_t)(3 * sizeof(struct sk_tree)));
+      if (_sk_profile != NULL)
+        _sk_profile_charge(leftmost, 3 * sizeof(struct sk_tree));
+      s_s_steps++;
       continue;
 
     } else if (leftmost->type == REF_NODE) {
       SK_Tree** sub_expr = &expr;
       for (size_t j = 0; j < depth; sub_expr = &((*sub_expr)->left), j++);
+      uint64_t s_copy = _skt_copied;
       *sub_expr = skt_copy(arena, leftmost->left);
       assert(*sub_expr != NULL);
+      if (_sk_trace != NULL)
+        _sk_trace_record(SK_RULE_REF, leftmost, (uint32_t)i, (uint32_t)depth, (int32_t)(_skt_copied - s_copy));
+      if (_sk_profile != NULL)
+        _sk_profile_charge(leftmost, _skt_copied - s_copy);
       continue;
     }
 
     break;
   }
 
-  // skt_print(&root, 1);
+  _skt_reductions += i;
+  if (_sk_stats != NULL) {
+    _sk_stats->s_k_steps   += s_k_steps;
+    _sk_stats->s_s_steps   += s_s_steps;
+    _sk_stats->s_ref_steps += i - s_k_steps - s_s_steps;
+    _sk_stats->s_copied    += _skt_copied - s_copied;
+  }
+  if (_sk_trace != NULL)
+    _sk_trace_record(SK_RULE_END, expr, (uint32_t)i, 0, 0);
+  (void)arena_tag(arena, tag);
   return expr;
 }
 
+uint64_t skt_get_reductions(void) {
+  return _skt_reductions;
+}
+
+void skt_set_compact(SK_Compact mode) {
+  _skt_compact_mode = mode;
+}
+
 void skt_print(SK_Tree** roots, size_t s_roots) {
   assert(roots != NULL);
 
@@ -137,6 +295,19 @@ SK_Tree* skt_copy(Arena arena, SK_Tree* expr) {
   if (arena == NULL || expr == NULL)
     return NULL;
 
+  const char* tag = arena_tag(arena, TAG_SKT_COPY);
+  SK_Tree* copy = _skt_copy(arena, expr);
+  (void)arena_tag(arena, tag);
+  return copy;
+}
+
+// ========================# PRIVATE #========================
+
+SK_Tree* _skt_copy(Arena arena, SK_Tree* expr) {
+  if (expr == NULL)
+    return NULL;
+  _skt_copied += sizeof(struct sk_tree);
+
   switch (expr->type) {
     case APP_NODE: {
       SK_Tree* app = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
@@ -144,8 +315,9 @@ SK_Tree* skt_copy(Arena arena, SK_Tree* expr) {
 
       *app = (SK_Tree){
         .type  = APP_NODE,
-        .left  = skt_copy(arena, expr->left),
-        .right = skt_copy(arena, expr->right),
+        .span  = expr->span,
+        .left  = _skt_copy(arena, expr->left),
+        .right = _skt_copy(arena, expr->right),
         .ld_ident = NULL
       };
       return app;
@@ -156,6 +328,7 @@ SK_Tree* skt_copy(Arena arena, SK_Tree* expr) {
 
       *ref = (SK_Tree){
         .type  = REF_NODE,
+        .span  = expr->span,
         .left  = expr->left,
         .right = NULL,
         .ld_ident = NULL
@@ -168,6 +341,7 @@ SK_Tree* skt_copy(Arena arena, SK_Tree* expr) {
 
       *ld_node = (SK_Tree){
         .type  = LD_NODE,
+        .span  = expr->span,
         .left  = NULL,
         .right = NULL,
         .ld_ident = astn_copy_ident(arena, expr->ld_ident)
@@ -177,13 +351,13 @@ SK_Tree* skt_copy(Arena arena, SK_Tree* expr) {
     case S_NODE: {
       SK_Tree* s = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
       assert(s != NULL);
-      *s = (SK_Tree){ .type = S_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
+      *s = (SK_Tree){ .type = S_NODE, .span = expr->span, .left = NULL, .right = NULL, .ld_ident = NULL };
       return s;
     }
     case K_NODE: {
       SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
       assert(k != NULL);
-      *k = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
+      *k = (SK_Tree){ .type = K_NODE, .span = expr->span, .left = NULL, .right = NULL, .ld_ident = NULL };
       return k;
     }
   }
@@ -191,40 +365,167 @@ SK_Tree* skt_copy(Arena arena, SK_Tree* expr) {
   return NULL;
 }
 
-void skt_write(FILE* file, SK_Tree** roots, size_t s_roots) {
-  assert(file != NULL && roots != NULL);
+SK_Tree* _ast_stmt_define(Arena arena, Arena scratch, ASTN_Stmt* stmt, SK_Tree* root) {
+  assert(arena != NULL && scratch != NULL && stmt != NULL && root != NULL);
 
-  for (size_t i = 0; i < s_roots; i++) {
-    fprintf(file, "%s = ", roots[i]->ld_ident->token->str);
-    _sk_write_expr(file, roots[i]);
-    fprintf(file, ";\n");
+  // reduction stops at the head, the redexes it leaves in the arguments are rewritten after it,
+  // and a rewrite at the head (eta) can bring up a redex that was inside an argument
+  if (_sk_opt_enabled) {
+    root = _skt_optimize_counted(scratch, root);
+    if (_skt_is_redex(root))
+      root = skt_beta_redu(scratch, root);
   }
+
+  const char* tag = arena_tag(arena, TAG_SK_EVACUATE);
+  root = _skt_evacuate(arena, scratch, root);
+  (void)arena_tag(arena, tag);
+
+  root->ld_ident = stmt->var;
+  stmt->sk_expr = root;
+  return root;
 }
 
-// ========================# PRIVATE #========================
+void _ast_expr_report_later(ASTN_Expr* expr, Diagnostics* diagnostics) {
+  assert(expr != NULL && diagnostics != NULL);
+
+  switch (expr->type) {
+    case EXPR_APP: {
+      _ast_expr_report_later(expr->fields.app.left, diagnostics);
+      _ast_expr_report_later(expr->fields.app.right, diagnostics);
+      break;
+    }
+    case EXPR_ABS: {
+      _ast_expr_report_later(expr->fields.abs.expr, diagnostics);
+      break;
+    }
+    case EXPR_IDENT: {
+      ASTN_Stmt* stmt = expr->fields.ident.stmt;
+      if (expr->index != AST_UNBOUND || stmt == NULL || stmt->sk_expr != NULL)
+        break;
+      ASTN_Ident* var = expr->fields.ident.var;
+      diagnostics_report(
+        diagnostics, var->frow, var->fcol, var->ecol,
+        "[SK CONVERTER]: sub expression was not defined previously to the current statement %s at line %d in file %s. Maybe you declared it later?",
+        var->token->str, var->frow, diagnostics_get_filename(diagnostics)
+      );
+      break;
+    }
+  }
+}
+
+void _ast_stmt_reach(ASTReach* reach, ASTN_Stmt* stmt) {
+  assert(reach != NULL && stmt != NULL);
+
+  // a linked definition is already reduced and refers to nothing of this AST
+  if (stmt->expr == NULL || hashmap_exists(reach->reached, (char*)stmt->var->token->str))
+    return;
+  (void)hashmap_insert(&reach->reached, (char*)stmt->var->token->str, stmt, NULL, false);
+
+  if (reach->s_work == reach->c_work) {
+    reach->c_work = reach->c_work > 0 ? 2 * reach->c_work : 1 << 5;
+    reach->work = (ASTN_Stmt**)realloc(reach->work, reach->c_work * sizeof(ASTN_Stmt*));
+    assert(reach->work != NULL);
+  }
+  reach->work[reach->s_work++] = stmt;
+}
+
+void _ast_expr_reach(ASTReach* reach, ASTN_Expr* expr) {
+  assert(reach != NULL && expr != NULL);
+
+  switch (expr->type) {
+    case EXPR_APP: {
+      _ast_expr_reach(reach, expr->fields.app.left);
+      _ast_expr_reach(reach, expr->fields.app.right);
+      break;
+    }
+    case EXPR_ABS: {
+      _ast_expr_reach(reach, expr->fields.abs.expr);
+      break;
+    }
+    case EXPR_IDENT: {
+      if (expr->index == AST_UNBOUND && expr->fields.ident.stmt != NULL)
+        _ast_stmt_reach(reach, expr->fields.ident.stmt);
+      break;
+    }
+  }
+}
+
+SK_Tree* _skt_evacuate(Arena arena, Arena scratch, SK_Tree* expr) {
+  if (expr == NULL || !arena_contains(scratch, expr))
+    return expr;
+  // an evacuated node is left behind as a forwarding pointer: right points to itself, left to the copy
+  if (expr->right == expr)
+    return expr->left;
+
+  SK_Tree* copy = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
+  assert(copy != NULL);
+  *copy = *expr;
+
+  expr->left  = copy;
+  expr->right = expr;
+
+  switch (copy->type) {
+    case APP_NODE: {
+      copy->left  = _skt_evacuate(arena, scratch, copy->left);
+      copy->right = _skt_evacuate(arena, scratch, copy->right);
+      break;
+    }
+    case REF_NODE: {
+      copy->left  = _skt_evacuate(arena, scratch, copy->left);
+      break;
+    }
+    case LD_NODE: {
+      // the name may live in the scratch arena or in an AST that is dropped after the statement
+      if (!arena_contains(arena, copy->ld_ident))
+        copy->ld_ident = astn_copy_ident(arena, copy->ld_ident);
+      break;
+    }
+    case S_NODE:
+    case K_NODE: {
+      break;
+    }
+  }
+
+  return copy;
+}
+
+SK_Tree* _skt_compact(SKT_Spaces* spaces, SK_Tree* root) {
+  assert(spaces != NULL);
+
+  // the evacuation visits the left child first, so the spine of every application lands next to
+  // it and a walk to the leftmost combinator reads consecutive nodes
+  Arena from = spaces->arenas[spaces->current],
+        to   = spaces->arenas[1 - spaces->current];
+  const char* tag = arena_tag(to, TAG_SK_COMPACT);
+  root = _skt_evacuate(to, from, root);
+  (void)arena_tag(to, tag);
+
+  (void)arena_release(from, spaces->marks[spaces->current]);
+  spaces->current = 1 - spaces->current;
+  return root;
+}
 
-bool _ast_expr_check(ASTN_Expr* expr, HashTable* table, Stack** stack, const char* filename) {
+bool _ast_expr_check(ASTN_Expr* expr, HashTable* table, Stack** stack, Diagnostics* diagnostics) {
   if (expr == NULL || table == NULL || stack == NULL)
     return false;
 
   switch (expr->type) {
     case EXPR_IDENT: {
-      ASTN_Token* token = expr->fields.var->token;
+      ASTN_Token* token = expr->fields.ident.var->token;
       const bool check = stack_exists(*stack, token) || hashtable_exists(*table, token);
       if (!check) {
-         fprintf(
-          stderr,
-          "[CHECKER]: non declared identifier used %s in file %s at %u\n",
-          token->str, filename, token->frow
+        diagnostics_report(
+          diagnostics, token->frow, token->fcol, token->ecol,
+          "[CHECKER]: non declared identifier used %s in file %s at %u",
+          token->str, diagnostics_get_filename(diagnostics), token->frow
         );
-        _error_underline(filename, token->frow, token->fcol, token->ecol);
       }
       return check;
     }
     case EXPR_ABS: {
       for (ASTN_Ident* var = expr->fields.abs.vars; var != NULL; var = var->next)
         (void)stack_push(stack, var->token);
-      const bool check = _ast_expr_check(expr->fields.abs.expr, table, stack, filename);
+      const bool check = _ast_expr_check(expr->fields.abs.expr, table, stack, diagnostics);
       for (ASTN_Ident* var = expr->fields.abs.vars; var != NULL; var = var->next)
         (void)stack_pop(stack);
       return check;
@@ -234,12 +535,12 @@ bool _ast_expr_check(ASTN_Expr* expr, HashTable* table, Stack** stack, const cha
       if (sub_expr->type == EXPR_ABS)
         (void)stack_push(stack, NULL);
 
-      const bool check_left = _ast_expr_check(sub_expr, table, stack, filename);
+      const bool check_left = _ast_expr_check(sub_expr, table, stack, diagnostics);
       if (sub_expr->type == EXPR_ABS && expr->fields.app.right->type != EXPR_ABS)
         (void)stack_pop(stack);
 
       sub_expr = expr->fields.app.right;
-      const bool check_right = _ast_expr_check(sub_expr, table, stack, filename);
+      const bool check_right = _ast_expr_check(sub_expr, table, stack, diagnostics);
       if (sub_expr->type == EXPR_ABS)
         (void)stack_pop(stack);
 
@@ -292,7 +593,7 @@ void _ast_expr_print(ASTN_Expr* expr, size_t depth, IdentList* list) {
       break;
     }
     case EXPR_IDENT: {
-      printf("%s\n", expr->fields.var->token->str);
+      printf("%s\n", expr->fields.ident.var->token->str);
       break;
     }
   }
@@ -331,428 +632,193 @@ void _ast_expr_transform(Arena arena, ASTN_Expr* expr) {
   }
 }
 
-SK_Tree* _ast_expr_convert(Arena arena, ASTN_Expr* expr, HashTable table, const char* filename) {
-  assert(arena != NULL && expr != NULL && table != NULL);
+void _ast_expr_resolve(ASTN_Expr* expr, HashTable table, ASTScope* scope) {
+  assert(expr != NULL && table != NULL);
 
   switch (expr->type) {
     case EXPR_APP: {
-      SK_Tree* app = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(app != NULL);
-
-      *app = (SK_Tree){
-        .type  = APP_NODE,
-        .left  = _ast_expr_convert(arena, expr->fields.app.left, table, filename),
-        .right = _ast_expr_convert(arena, expr->fields.app.right, table, filename)
-      };
-
-      return app;
+      _ast_expr_resolve(expr->fields.app.left, table, scope);
+      _ast_expr_resolve(expr->fields.app.right, table, scope);
+      break;
     }
     case EXPR_ABS: {
-      ASTN_Ident* var = expr->fields.abs.vars;
-
-      if (expr->fields.abs.expr->type != EXPR_APP) {
-        if (expr->fields.abs.expr->type == EXPR_IDENT) {
-          if (strcmp(expr->fields.abs.expr->fields.var->token->str, var->token->str) == 0) {
-            SK_Tree* app1, *app2, *s, *k1, *k2;
-            app1 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            app2 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            s    = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            k1   = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            k2   = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            assert(app1 != NULL && app2 != NULL && s != NULL && k1 != NULL && k2 != NULL);
-
-            *s  = (SK_Tree){ .type = S_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-            *k2 = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-            *k1 = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-
-            *app2 = (SK_Tree){ .type = APP_NODE, .left = s, .right = k2, .ld_ident = NULL };
-            *app1 = (SK_Tree){ .type = APP_NODE, .left = app2, .right = k1, .ld_ident = NULL };
-
-            return app1;
-          }
-
-          SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-          assert(k != NULL);
-
-          ASTN_Stmt* stmt = hashtable_lookup(table, var->token);
-          if (stmt != NULL) {
-            if (stmt->sk_expr == NULL) {
-              fprintf(
-                stderr,
-                "[SK CONVERTER]: sub expression was not defined previously to the current statement %s at line %d in file %s. Maybe you declared it later?\n",
-                expr->fields.var->token->str,
-                expr->fields.var->frow,
-                filename
-              );
-              _error_underline(filename, expr->fields.var->frow, expr->fields.var->fcol, expr->fields.var->ecol);
-            }
-
-            SK_Tree* app = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            assert(app != NULL);
-
-            SK_Tree* ref = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-            assert(ref != NULL);
-            *ref = (SK_Tree){ .type = REF_NODE, .left = stmt->sk_expr, .right = NULL, .ld_ident = stmt->var };
-
-            *app = (SK_Tree){ .type = APP_NODE, .left = k, .right = ref, .ld_ident = NULL };
-
-            return app;
-          }
-
-          *k = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-          return k;
-        }
-
-        SK_Tree* sub_expr = _ast_expr_convert(arena, expr->fields.abs.expr, table, filename);
-        if (!_ast_in_free_var_set(expr->fields.abs.expr, var)) {
-          SK_Tree* app = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-          assert(app != NULL);
-
-          SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-          assert(k != NULL);
-
-          *k = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-
-          *app = (SK_Tree){
-            .type  = APP_NODE,
-            .left  = k,
-            .right = sub_expr,
-            .ld_ident = NULL
-          };
-
-          return app;
-        }
-
-        return _ast_expr_convert_sk(arena, sub_expr, expr->fields.abs.vars);
-      }
-
-      bool var_free_left  = _ast_in_free_var_set(expr->fields.abs.expr->fields.app.left, var);
-      bool var_free_right = _ast_in_free_var_set(expr->fields.abs.expr->fields.app.right, var);
-
-      if (!var_free_left && !var_free_right) {
-        SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(k != NULL);
-        *k = (SK_Tree){
-          .type  = K_NODE,
-          .left  = NULL,
-          .right = NULL,
-          .ld_ident = NULL
-        };
-
-        SK_Tree* app = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(app != NULL);
-        *app = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = k,
-          .right = _ast_expr_convert(arena, expr->fields.abs.expr, table, filename),
-          .ld_ident = NULL
-        };
-
-        return app;
+      // ast_transform left one variable per abstraction
+      assert(expr->fields.abs.vars->next == NULL);
+      ASTScope inner = { .var = expr->fields.abs.vars, .up = scope };
+      _ast_expr_resolve(expr->fields.abs.expr, table, &inner);
+      break;
+    }
+    case EXPR_IDENT: {
+      // names are interned by the scanner, the string compare is for ASTs built some other way
+      const char* name = expr->fields.ident.var->token->str;
+      uint32_t index = 0;
+      for (; scope != NULL; scope = scope->up, index++) {
+        const char* bound = scope->var->token->str;
+        if (bound == name || strcmp(bound, name) == 0)
+          break;
       }
 
-      if (!var_free_left && var_free_right && expr->fields.abs.expr->fields.app.right->type == EXPR_IDENT)
-        return _ast_expr_convert(arena, expr->fields.abs.expr->fields.app.left, table, filename);
-
-      SK_Tree* app1 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(app1 != NULL);
-
-      SK_Tree* app2 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(app2 != NULL);
-
-      SK_Tree* s = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(s != NULL);
+      expr->index = scope != NULL ? index : AST_UNBOUND;
+      expr->fields.ident.stmt = scope != NULL ? NULL : hashtable_lookup(table, expr->fields.ident.var->token);
+      break;
+    }
+  }
+}
 
-      if (!var_free_left) {
-        SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(k != NULL);
-        *k = (SK_Tree){
-          .type  = K_NODE,
-          .left  = NULL,
-          .right = NULL,
-          .ld_ident = NULL
-        };
-
-        SK_Tree* app3 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(app3 != NULL);
-        *app3 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = k,
-          .right = _ast_expr_convert(arena, expr->fields.abs.expr->fields.app.left, table, filename),
-          .ld_ident = NULL
-        };
-
-        *app2 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = s,
-          .right = app3,
-          .ld_ident = NULL
-        };
-      } else {
-        ASTN_Expr* sub_expr = astn_copy_expr(arena, expr->fields.abs.expr->fields.app.left);
-        assert(sub_expr != NULL);
-
-        ASTN_Expr* left = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
-        assert(left != NULL);
-        *left = (ASTN_Expr){
-          .frow = expr->frow,
-          .fcol = expr->fcol,
-          .erow = expr->erow,
-          .ecol = expr->ecol,
-          .type = EXPR_ABS,
-          .fields.abs.vars = astn_copy_ident(arena, expr->fields.abs.vars),
-          .fields.abs.expr = sub_expr
-        };
-
-        *app2 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = s,
-          .right = _ast_expr_convert(arena, left, table, filename),
-          .ld_ident = NULL
-        };
-      }
+SK_Tree* _ast_expr_convert(Arena arena, ASTN_Expr* expr, ASTScope* scope, Diagnostics* diagnostics) {
+  SK_Tree* tree = _ast_expr_convert_node(arena, expr, scope, diagnostics);
+  if (_sk_profile != NULL)
+    _sk_profile_stamp(tree, _sk_profile_span(expr));
+  return tree;
+}
 
-      if (!var_free_right) {
-        SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(k != NULL);
-        *k = (SK_Tree){
-          .type  = K_NODE,
-          .left  = NULL,
-          .right = NULL,
-          .ld_ident = NULL
-        };
-
-        SK_Tree* app3 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(app3 != NULL);
-        *app3 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = k,
-          .right = _ast_expr_convert(arena, expr->fields.abs.expr->fields.app.right, table, filename),
-          .ld_ident = NULL
-        };
-
-        *app1 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = app2,
-          .right = app3,
-          .ld_ident = NULL
-        };
-      } else {
-        ASTN_Expr* sub_expr = astn_copy_expr(arena, expr->fields.abs.expr->fields.app.right);
-        assert(sub_expr != NULL);
-
-        ASTN_Expr* right = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
-        assert(right != NULL);
-        *right = (ASTN_Expr){
-          .frow = expr->frow,
-          .fcol = expr->fcol,
-          .erow = expr->erow,
-          .ecol = expr->ecol,
-          .type = EXPR_ABS,
-          .fields.abs.vars = astn_copy_ident(arena, expr->fields.abs.vars),
-          .fields.abs.expr = sub_expr
-        };
-
-        *app1 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = app2,
-          .right = _ast_expr_convert(arena, right, table, filename),
-          .ld_ident = NULL
-        };
-      }
+SK_Tree* _ast_expr_convert_node(Arena arena, ASTN_Expr* expr, ASTScope* scope, Diagnostics* diagnostics) {
+  assert(arena != NULL && expr != NULL);
 
-      return app1;
+  switch (expr->type) {
+    case EXPR_APP: {
+      SK_Tree* left  = _ast_expr_convert(arena, expr->fields.app.left, scope, diagnostics),
+             * right = _ast_expr_convert(arena, expr->fields.app.right, scope, diagnostics);
+      return _skt_node(arena, APP_NODE, left, right, NULL);
+    }
+    case EXPR_ABS: {
+      ASTScope inner = { .var = expr->fields.abs.vars, .up = scope };
+      bool bound = false;
+      SK_Tree* body = _ast_expr_abstract(arena, expr->fields.abs.expr, expr, &inner, diagnostics, &bound);
+      if (bound)
+        return body;
+      return _skt_node(arena, APP_NODE, _skt_node(arena, K_NODE, NULL, NULL, NULL), body, NULL);
     }
     case EXPR_IDENT: {
-      ASTN_Stmt* stmt = hashtable_lookup(table, expr->fields.var->token);
-
-      if (stmt != NULL) {
-        if (stmt->sk_expr == NULL) {
-          fprintf(
-            stderr,
-            "[SK CONVERTER]: sub expression was not defined previously to the current statement %s at line %d in file %s. Maybe you declared it later?\n",
-            expr->fields.var->token->str,
-            expr->fields.var->frow,
-            filename
-          );
-          _error_underline(filename, expr->fields.var->frow, expr->fields.var->fcol, expr->fields.var->ecol);
-        }
-
-        SK_Tree* ref = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(ref != NULL);
-        *ref = (SK_Tree){ .type = REF_NODE, .left = stmt->sk_expr, .right = NULL, .ld_ident = stmt->var };
-
-        return ref;
+      // a bound variable stays a name until its abstraction is done, the binder is its identity
+      if (expr->index != AST_UNBOUND) {
+        for (uint32_t i = 0; i < expr->index; i++)
+          scope = scope->up;
+        return _skt_node(arena, LD_NODE, NULL, NULL, scope->var);
       }
 
-      SK_Tree* wrapper = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(wrapper != NULL);
-
-      *wrapper = (SK_Tree){ .type = LD_NODE, .ld_ident = expr->fields.var, .left = NULL, .right = NULL };
-
-      return wrapper;
+      ASTN_Stmt* stmt = expr->fields.ident.stmt;
+      if (stmt == NULL)
+        return _skt_node(arena, LD_NODE, NULL, NULL, expr->fields.ident.var);
+
+      // a definition that comes later has no tree yet, the reported name is left free
+      if (stmt->sk_expr == NULL) {
+        ASTN_Ident* var = expr->fields.ident.var;
+        diagnostics_report(
+          diagnostics, var->frow, var->fcol, var->ecol,
+          "[SK CONVERTER]: sub expression was not defined previously to the current statement %s at line %d in file %s. Maybe you declared it later?",
+          var->token->str, var->frow, diagnostics_get_filename(diagnostics)
+        );
+        return _skt_node(arena, LD_NODE, NULL, NULL, var);
+      }
+      return _skt_node(arena, REF_NODE, stmt->sk_expr, NULL, stmt->var);
     }
-}
+  }
 
   fprintf(stderr, "[SK CONVERTER]: converter function reached its end. Something went wrong!\n");
   exit(1);
   return NULL;
 }
 
-SK_Tree* _ast_expr_convert_sk(Arena arena, SK_Tree* expr, ASTN_Ident* var) {
-  assert(arena != NULL && expr != NULL && var != NULL);
-
-  switch (expr->type) {
-    case APP_NODE: {
-      bool 
-        var_free_left  = _ast_in_free_var_set_sk(expr->left, var),
-        var_free_right = _ast_in_free_var_set_sk(expr->right, var)
-      ;
-
-      if (!var_free_left && var_free_right && expr->right->type == LD_NODE)
-        return expr->left;
-
-      SK_Tree* s = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(s != NULL);
-
-      SK_Tree* app2 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(app2 != NULL);
-
-      SK_Tree* app1 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-      assert(app1 != NULL);
-
-      if (!var_free_left) {
-        SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(k != NULL);
-
-        SK_Tree* app3 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(app3 != NULL);
-
-        *k = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-
-        *app3 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = k,
-          .right = expr->left,
-          .ld_ident = NULL
-        };
-
-        *app2 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = s,
-          .right = app3,
-          .ld_ident = NULL
-        };
-      } else {
-        *app2 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = s,
-          .right = _ast_expr_convert_sk(arena, expr->left, var),
-          .ld_ident = NULL
-        };
-      }
+SK_Tree* _ast_expr_abstract(Arena arena, ASTN_Expr* expr, ASTN_Expr* abs, ASTScope* scope, Diagnostics* diagnostics, bool* bound) {
+  SK_Tree* tree = _ast_expr_abstract_node(arena, expr, abs, scope, diagnostics, bound);
+  if (_sk_profile != NULL)
+    _sk_profile_stamp(tree, _sk_profile_span(*bound ? abs : expr));
+  return tree;
+}
 
-      if (!var_free_right) {
-        SK_Tree* k = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(k != NULL);
-
-        SK_Tree* app3 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(app3 != NULL);
-
-        *k = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-
-        *app3 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = k,
-          .right = expr->right,
-          .ld_ident = NULL
-        };
-
-        *app1 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = app2,
-          .right = app3,
-          .ld_ident = NULL
-        };
-      } else {
-        *app1 = (SK_Tree){
-          .type  = APP_NODE,
-          .left  = app2,
-          .right = _ast_expr_convert_sk(arena, expr->right, var),
-          .ld_ident = NULL
-        };
-      }
+SK_Tree* _ast_expr_abstract_node(Arena arena, ASTN_Expr* expr, ASTN_Expr* abs, ASTScope* scope, Diagnostics* diagnostics, bool* bound) {
+  assert(arena != NULL && expr != NULL && abs != NULL && scope != NULL && bound != NULL);
 
-      return app1;
-    }
-    case LD_NODE: {
-      if (strcmp(expr->ld_ident->token->str, var->token->str) == 0) {
-        SK_Tree* app2, *s, *k1, *k2;
-        app2 = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        s    = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        k1   = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        k2   = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
-        assert(app2 != NULL && s != NULL && k1 != NULL && k2 != NULL);
-
-        *s  = (SK_Tree){ .type = S_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-        *k2 = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-        *k1 = (SK_Tree){ .type = K_NODE, .left = NULL, .right = NULL, .ld_ident = NULL };
-
-        *app2 = (SK_Tree){ .type = APP_NODE, .left = s, .right = k2, .ld_ident = NULL };
-        *expr = (SK_Tree){ .type = APP_NODE, .left = app2, .right = k1, .ld_ident = NULL };
+  // the abstraction of scope->var over expr, or expr converted as it is with *bound false when the
+  // variable is not used in it, so that the caller chooses K expr without converting expr again
+  switch (expr->type) {
+    case EXPR_APP: {
+      ASTN_Expr* right_expr = expr->fields.app.right;
+      bool bound_left = false, bound_right = false;
+      SK_Tree* left = _ast_expr_abstract(arena, expr->fields.app.left, abs, scope, diagnostics, &bound_left);
+
+      // \x -> f x is f when f does not use x
+      if (!bound_left && right_expr->type == EXPR_IDENT && right_expr->index == 0) {
+        *bound = true;
+        return left;
       }
-      return expr;
-    }
-    default: {
-      return expr;
-    }
-  }
-}
 
-bool _ast_in_free_var_set(ASTN_Expr* expr, ASTN_Ident* var) {
-  if (expr == NULL || var == NULL)
-    return false;
+      SK_Tree* right = _ast_expr_abstract(arena, right_expr, abs, scope, diagnostics, &bound_right);
+      *bound = bound_left || bound_right;
+      if (!*bound)
+        return _skt_node(arena, APP_NODE, left, right, NULL);
 
-  switch (expr->type) {
-    case EXPR_APP: { 
-      return (
-           _ast_in_free_var_set(expr->fields.app.left, var)
-        || _ast_in_free_var_set(expr->fields.app.right, var)
-      );
+      if (!bound_left)
+        left = _skt_node(arena, APP_NODE, _skt_node(arena, K_NODE, NULL, NULL, NULL), left, NULL);
+      if (!bound_right)
+        right = _skt_node(arena, APP_NODE, _skt_node(arena, K_NODE, NULL, NULL, NULL), right, NULL);
+      return _skt_node(arena, APP_NODE, _skt_node(arena, APP_NODE, _skt_node(arena, S_NODE, NULL, NULL, NULL), left, NULL), right, NULL);
     }
     case EXPR_ABS: {
-      return _ast_in_free_var_set(expr->fields.abs.expr, var);
+      // the inner abstraction goes first, what it leaves of this variable are LD nodes of its binder
+      SK_Tree* sub  = _ast_expr_convert(arena, expr, scope, diagnostics),
+             * tree = _skt_abstract(arena, sub, scope->var);
+      *bound = tree != NULL;
+      return *bound ? tree : sub;
     }
     case EXPR_IDENT: {
-      return strcmp(expr->fields.var->token->str, var->token->str) == 0;
+      *bound = expr->index == 0;
+      if (!*bound)
+        return _ast_expr_convert_node(arena, expr, scope, diagnostics);
+
+      SK_Tree* sk = _skt_node(arena, APP_NODE, _skt_node(arena, S_NODE, NULL, NULL, NULL), _skt_node(arena, K_NODE, NULL, NULL, NULL), NULL);
+      return _skt_node(arena, APP_NODE, sk, _skt_node(arena, K_NODE, NULL, NULL, NULL), NULL);
     }
   }
 
-  fprintf(stderr, "[SK CONVERTER]: free var set function reached its end. Something went wrong!\n");
+  fprintf(stderr, "[SK CONVERTER]: converter function reached its end. Something went wrong!\n");
   exit(1);
-  return false;
+  return NULL;
 }
 
-bool _ast_in_free_var_set_sk(SK_Tree* expr, ASTN_Ident* var) {
-  if (expr == NULL || var == NULL)
-    return false;
+SK_Tree* _skt_abstract(Arena arena, SK_Tree* expr, ASTN_Ident* var) {
+  assert(arena != NULL && expr != NULL && var != NULL);
 
+  // NULL when var is not used in expr, every node is visited once
   switch (expr->type) {
-    case APP_NODE: { 
-      return (
-           _ast_in_free_var_set_sk(expr->left, var)
-        || _ast_in_free_var_set_sk(expr->right, var)
-      );
+    case APP_NODE: {
+      SK_Tree* left = _skt_abstract(arena, expr->left, var);
+      if (left == NULL && expr->right->type == LD_NODE && expr->right->ld_ident == var)
+        return expr->left;
+
+      SK_Tree* right = _skt_abstract(arena, expr->right, var);
+      if (left == NULL && right == NULL)
+        return NULL;
+
+      if (left == NULL)
+        left = _skt_node(arena, APP_NODE, _skt_node(arena, K_NODE, NULL, NULL, NULL), expr->left, NULL);
+      if (right == NULL)
+        right = _skt_node(arena, APP_NODE, _skt_node(arena, K_NODE, NULL, NULL, NULL), expr->right, NULL);
+      return _skt_node(arena, APP_NODE, _skt_node(arena, APP_NODE, _skt_node(arena, S_NODE, NULL, NULL, NULL), left, NULL), right, NULL);
     }
     case LD_NODE: {
-      return strcmp(expr->ld_ident->token->str, var->token->str) == 0;
+      if (expr->ld_ident != var)
+        return NULL;
+
+      // the node belongs to this occurrence alone, it becomes S K K in place
+      SK_Tree* sk = _skt_node(arena, APP_NODE, _skt_node(arena, S_NODE, NULL, NULL, NULL), _skt_node(arena, K_NODE, NULL, NULL, NULL), NULL);
+      *expr = (SK_Tree){ .type = APP_NODE, .span = expr->span, .left = sk, .right = _skt_node(arena, K_NODE, NULL, NULL, NULL), .ld_ident = NULL };
+      return expr;
     }
     default: {
-      return false;
+      return NULL;
     }
   }
 }
 
+SK_Tree* _skt_node(Arena arena, uint32_t type, SK_Tree* left, SK_Tree* right, ASTN_Ident* ld_ident) {
+  SK_Tree* node = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
+  assert(node != NULL);
+  *node = (SK_Tree){ .type = type, .left = left, .right = right, .ld_ident = ld_ident };
+  return node;
+}
+
 void _sk_print_expr(SK_Tree* expr, size_t depth, IdentList* list) {
   assert(expr != NULL && list != NULL);
   
@@ -800,6 +866,27 @@ void _sk_print_expr(SK_Tree* expr, size_t depth, IdentList* list) {
   }
 }
 
+SK_Tree* _skt_optimize_counted(Arena arena, SK_Tree* expr) {
+  if (_sk_stats == NULL)
+    return skt_optimize(arena, expr);
+
+  // shares are counted where they are reached, like _sk_stats_count_sk counts them
+  uint64_t s_nodes = _sk_stats_count_sk(expr);
+  expr = skt_optimize(arena, expr);
+  _sk_stats->s_opt_nodes += s_nodes - _sk_stats_count_sk(expr);
+  return expr;
+}
+
+bool _skt_is_redex(SK_Tree* expr) {
+  size_t depth = 0;
+  SK_Tree* leftmost = _skt_get_leftmost(expr, &depth);
+  return leftmost != NULL && (
+       (leftmost->type == K_NODE && depth >= 2)
+    || (leftmost->type == S_NODE && depth >= 3)
+    || leftmost->type == REF_NODE
+  );
+}
+
 SK_Tree* _skt_get_leftmost(SK_Tree* expr, size_t* depth) {
   if (expr == NULL || depth == NULL)
     return NULL;
@@ -811,40 +898,6 @@ SK_Tree* _skt_get_leftmost(SK_Tree* expr, size_t* depth) {
   return expr;
 }
 
-void _sk_write_expr(FILE* file, SK_Tree* expr) {
-  assert(file != NULL && expr != NULL);
-  
-  switch (expr->type) {
-    case APP_NODE: {
-      _sk_write_expr(file, expr->left);
-      fprintf(file, expr->right->type != S_NODE && expr->right->type != K_NODE ? "(" : "");
-      _sk_write_expr(file, expr->right);
-      fprintf(file, expr->right->type != S_NODE && expr->right->type != K_NODE ? ")" : "");
-      break;
-    }
-    case REF_NODE: {
-      fprintf(file, "&%s", expr->left->ld_ident != NULL ? expr->left->ld_ident->token->str : "(");
-      if (expr->left->ld_ident == NULL) {
-        _sk_write_expr(file, expr->left);
-        fprintf(file, ")");
-      }
-      break;
-    }
-    case LD_NODE: {
-      fprintf(file, "%s", expr->ld_ident->token->str);
-      break;
-    }
-    case K_NODE: {
-      fprintf(file, "K");
-      break;
-    }
-    case S_NODE: {
-      fprintf(file, "S");
-      break;
-    }
-  }
-}
-
 IdentList* _ident_list_append(IdentList* list, bool value) {
   IdentList* node = (IdentList*)malloc(sizeof(struct ident_list));
   assert(node != NULL);
@@ -883,37 +936,3 @@ void _ident_list_free(IdentList* list) {
     free(delete);
   }
 }
-
-void _error_underline(const char* filename, const uint32_t frow, const uint32_t fcol, const uint32_t ecol) {
-  assert(filename != NULL);
-
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Error: Could not access or find the source file: %s\n", filename);
-    return;
-  }
-
-  char line[1024];
-  for (
-    uint32_t current_line = 1;
-    fgets(line, sizeof(line), file) && current_line != frow;
-    current_line++
-  );
-  fclose(file);
-
-  fprintf(stderr, "%s", line);
-
-  uint32_t s_word = ecol - fcol + 1;
-  char offset[fcol], underline[s_word + 1];
-
-  for (uint32_t i = 0; i < fcol - 1; i++)
-    offset[i] = ' ';
-  offset[fcol - 1] = '\0';
-  fprintf(stderr, "%s%s", offset, "\033[31m");
-
-  underline[0] = '^';
-  for (uint32_t i = 1; i <= s_word; i++)
-    underline[i] = '~';
-  underline[s_word] = '\0';
-  fprintf(stderr, "%s%s\n", underline, "\033[0m");
-}
@@ -0,0 +1,38 @@
+#include "skback_priv.h"
+
+// ========================# PRIVATE #========================
+
+ASTN_Ident* _sk_back_var(Arena arena) {
+  assert(arena != NULL);
+
+  // the variable is always abstracted again, its name never reaches a written tree
+  static struct astn_token token = { .frow = 0, .fcol = 0, .ecol = 0, .str = "_" };
+  ASTN_Ident* var = (ASTN_Ident*)arena_alloc(arena, sizeof(struct astn_id));
+  assert(var != NULL);
+  *var = (ASTN_Ident){ .frow = 0, .fcol = 0, .erow = 0, .ecol = 0, .s_id = 1, .token = &token, .next = NULL };
+  return var;
+}
+
+SK_Tree* _sk_back_abstract(Arena arena, SK_Tree* body, ASTN_Ident* var) {
+  assert(arena != NULL && body != NULL && var != NULL);
+
+  // a body that does not use the variable ignores its argument
+  SK_Tree* tree = _skt_abstract(arena, body, var);
+  if (tree == NULL)
+    tree = _skt_node(arena, APP_NODE, _skt_node(arena, K_NODE, NULL, NULL, NULL), body, NULL);
+  return tree;
+}
+
+SK_Tree* _sk_back_convert(
+  Arena arena, Arena scratch, ASTN_Stmt* stmt, HashTable table, Diagnostics* diagnostics,
+  const char* backend, const char* reason
+) {
+  assert(arena != NULL && scratch != NULL && stmt != NULL && table != NULL && diagnostics != NULL);
+  assert(backend != NULL && reason != NULL);
+
+  fprintf(
+    stderr, "[%s]: %s %s in file %s, it is converted and reduced as SK instead\n",
+    backend, stmt->var->token->str, reason, diagnostics_get_filename(diagnostics)
+  );
+  return ast_convert_stmt(arena, scratch, stmt, table, diagnostics);
+}
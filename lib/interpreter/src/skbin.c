@@ -0,0 +1,332 @@
+#include "skbin_priv.h"
+
+// ========================# PUBLIC #========================
+
+bool skb_write(FILE* file, SK_Tree** roots, size_t s_roots) {
+  return skb_write_module(file, roots, s_roots, 0, NULL, 0);
+}
+
+bool skb_write_module(FILE* file, SK_Tree** roots, size_t s_roots, uint64_t source_hash, const SKB_Dep* deps, size_t s_deps) {
+  assert(file != NULL && roots != NULL && (deps != NULL || s_deps == 0));
+
+  SKB_Writer writer = {
+    .index = SK_INDEX_EMPTY,
+    .names = hashmap_create(1 << 5, .75),
+    .nodes = NULL, .s_nodes = 0, .c_nodes = 0,
+    .symbols = NULL, .s_symbols = 0, .c_symbols = 0
+  };
+  assert(writer.names != NULL);
+
+  struct skb_root* table = (struct skb_root*)malloc((s_roots > 0 ? s_roots : 1) * sizeof(struct skb_root));
+  assert(table != NULL);
+
+  for (size_t i = 0; i < s_roots; i++) {
+    assert(roots[i] != NULL);
+    table[i] = (struct skb_root){
+      .node   = _skb_emit(&writer, roots[i]),
+      .symbol = _skb_emit_symbol(&writer, roots[i]->ld_ident != NULL ? roots[i]->ld_ident->token->str : "root")
+    };
+  }
+
+  struct skb_dep* dep_table = (struct skb_dep*)malloc((s_deps > 0 ? s_deps : 1) * sizeof(struct skb_dep));
+  assert(dep_table != NULL);
+  for (size_t i = 0; i < s_deps; i++) {
+    assert(deps[i].name != NULL);
+    dep_table[i] = (struct skb_dep){ .hash = deps[i].hash, .symbol = _skb_emit_symbol(&writer, deps[i].name), .reserved = 0 };
+  }
+
+  struct skb_header header = {
+    .magic       = SKB_MAGIC,
+    .version     = SKB_VERSION,
+    .s_nodes     = (uint32_t)writer.s_nodes,
+    .s_roots     = (uint32_t)s_roots,
+    .s_symbols   = (uint32_t)writer.s_symbols,
+    .s_deps      = (uint32_t)s_deps,
+    .source_hash = source_hash
+  };
+  // roots are eight bytes each, so the dependencies after them stay aligned for their hashes
+  header.nodes_offset   = sizeof(struct skb_header);
+  header.roots_offset   = header.nodes_offset + writer.s_nodes * sizeof(struct skb_node);
+  header.roots_offset  += (SKB_ALIGN - header.roots_offset % SKB_ALIGN) % SKB_ALIGN;
+  header.deps_offset    = header.roots_offset + s_roots * sizeof(struct skb_root);
+  header.symbols_offset = header.deps_offset + s_deps * sizeof(struct skb_dep);
+
+  bool written = (
+       fwrite(&header, sizeof(struct skb_header), 1, file) == 1
+    && fwrite(writer.nodes, sizeof(struct skb_node), writer.s_nodes, file) == writer.s_nodes
+    && _skb_write_padding(file, header.roots_offset - header.nodes_offset - writer.s_nodes * sizeof(struct skb_node))
+    && fwrite(table, sizeof(struct skb_root), s_roots, file) == s_roots
+    && fwrite(dep_table, sizeof(struct skb_dep), s_deps, file) == s_deps
+    && fwrite(writer.symbols, 1, writer.s_symbols, file) == writer.s_symbols
+  );
+
+  free(table);
+  free(dep_table);
+  free(writer.nodes);
+  free(writer.symbols);
+  _sk_index_free(&writer.index);
+  hashmap_free(writer.names, NULL, false);
+  return written;
+}
+
+SKB_Image* skb_load(const char* filename) {
+  assert(filename != NULL);
+
+  int32_t fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[SKB LOADER]: could not open %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct skb_header)) {
+    fprintf(stderr, "[SKB LOADER]: %s is too small to be a binary SK program\n", filename);
+    close(fd);
+    return NULL;
+  }
+
+  // a private mapping lets the nodes be rewritten in place without touching the file
+  size_t s_memory = (size_t)st.st_size;
+  void* memory = mmap(NULL, s_memory, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    fprintf(stderr, "[SKB LOADER]: could not map %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  const struct skb_header* header = (const struct skb_header*)memory;
+  if (!_skb_valid_header(header, s_memory)) {
+    fprintf(stderr, "[SKB LOADER]: %s is not a valid binary SK program (version %u)\n", filename, SKB_VERSION);
+    munmap(memory, s_memory);
+    return NULL;
+  }
+
+  SKB_Image* image = (SKB_Image*)malloc(sizeof(struct skb_image));
+  assert(image != NULL);
+
+  *image = (SKB_Image){
+    .memory   = memory,
+    .s_memory = s_memory,
+    .header   = header,
+    .nodes    = (struct skb_node*)((char*)memory + header->nodes_offset),
+    .roots    = (const struct skb_root*)((char*)memory + header->roots_offset),
+    .deps     = (const struct skb_dep*)((char*)memory + header->deps_offset),
+    .symbols  = (const char*)memory + header->symbols_offset
+  };
+  return image;
+}
+
+SK_Tree** skb_get_roots(Arena arena, SKB_Image* image) {
+  assert(arena != NULL && image != NULL);
+
+  const struct skb_header* header = image->header;
+  if (header->s_roots == 0 || header->s_nodes == 0)
+    return NULL;
+
+  // one block for the whole graph, each node is rebuilt from its predecessors in a single pass
+  const char* tag = arena_tag(arena, TAG_SKB_LOAD);
+  SK_Tree* trees = (SK_Tree*)arena_alloc_array(arena, sizeof(struct sk_tree), header->s_nodes);
+  SK_Tree** roots = (SK_Tree**)arena_alloc_array(arena, sizeof(SK_Tree*), header->s_roots);
+  assert(trees != NULL && roots != NULL);
+
+  for (uint32_t i = 0; i < header->s_nodes; i++) {
+    const struct skb_node* node = &image->nodes[i];
+    switch (node->type) {
+      case APP_NODE: {
+        if (!_skb_valid_child(i, node->left) || !_skb_valid_child(i, node->right))
+          break;
+        trees[i] = (SK_Tree){ .type = APP_NODE, .left = &trees[i + node->left], .right = &trees[i + node->right], .ld_ident = NULL };
+        continue;
+      }
+      case REF_NODE: {
+        if (!_skb_valid_child(i, node->left) || node->right < -1 || node->right >= (int64_t)header->s_symbols)
+          break;
+        ASTN_Ident* ident = NULL;
+        if (node->right >= 0)
+          ident = astn_create_ident(arena, astn_create_token(arena, image->symbols + node->right, 0, 0, 0), NULL);
+        trees[i] = (SK_Tree){ .type = REF_NODE, .left = &trees[i + node->left], .right = NULL, .ld_ident = ident };
+        continue;
+      }
+      case LD_NODE: {
+        if (node->left < 0 || (uint32_t)node->left >= header->s_symbols)
+          break;
+        ASTN_Token* token = astn_create_token(arena, image->symbols + node->left, 0, 0, 0);
+        trees[i] = (SK_Tree){ .type = LD_NODE, .left = NULL, .right = NULL, .ld_ident = astn_create_ident(arena, token, NULL) };
+        continue;
+      }
+      case S_NODE:
+      case K_NODE: {
+        trees[i] = (SK_Tree){ .type = node->type, .left = NULL, .right = NULL, .ld_ident = NULL };
+        continue;
+      }
+    }
+
+    fprintf(stderr, "[SKB LOADER]: node %u of type %u has an invalid reference\n", i, node->type);
+    (void)arena_tag(arena, tag);
+    return NULL;
+  }
+
+  for (uint32_t i = 0; i < header->s_roots; i++) {
+    const struct skb_root* root = &image->roots[i];
+    if (root->node >= header->s_nodes || root->symbol >= header->s_symbols) {
+      fprintf(stderr, "[SKB LOADER]: root %u is out of bounds\n", i);
+      (void)arena_tag(arena, tag);
+      return NULL;
+    }
+    ASTN_Token* token = astn_create_token(arena, image->symbols + root->symbol, 0, 0, 0);
+    roots[i] = &trees[root->node];
+    roots[i]->ld_ident = astn_create_ident(arena, token, NULL);
+  }
+
+  (void)arena_tag(arena, tag);
+  return roots;
+}
+
+size_t skb_get_size_roots(SKB_Image* image) {
+  assert(image != NULL);
+  return image->header->s_roots;
+}
+
+size_t skb_get_size_nodes(SKB_Image* image) {
+  assert(image != NULL);
+  return image->header->s_nodes;
+}
+
+uint64_t skb_get_source_hash(SKB_Image* image) {
+  assert(image != NULL);
+  return image->header->source_hash;
+}
+
+size_t skb_get_size_deps(SKB_Image* image) {
+  assert(image != NULL);
+  return image->header->s_deps;
+}
+
+SKB_Dep skb_get_dep(SKB_Image* image, size_t i) {
+  assert(image != NULL && i < image->header->s_deps);
+  return (SKB_Dep){ .name = image->symbols + image->deps[i].symbol, .hash = image->deps[i].hash };
+}
+
+void skb_unload(SKB_Image* image) {
+  if (image == NULL)
+    return;
+  munmap(image->memory, image->s_memory);
+  free(image);
+}
+
+// ========================# PRIVATE #========================
+
+uint32_t _skb_emit(SKB_Writer* writer, const SK_Tree* expr) {
+  assert(writer != NULL && expr != NULL);
+
+  uint64_t index;
+  if (_sk_index_get(&writer->index, expr, &index))
+    return (uint32_t)index;
+
+  // children are emitted first, the node then lands at s_nodes and refers back to them
+  struct skb_node node = { .type = expr->type, .left = 0, .right = 0 };
+  switch (expr->type) {
+    case APP_NODE: {
+      uint32_t left  = _skb_emit(writer, expr->left),
+               right = _skb_emit(writer, expr->right);
+      node.left  = (int32_t)((int64_t)left - (int64_t)writer->s_nodes);
+      node.right = (int32_t)((int64_t)right - (int64_t)writer->s_nodes);
+      break;
+    }
+    case REF_NODE: {
+      uint32_t left = _skb_emit(writer, expr->left);
+      node.left  = (int32_t)((int64_t)left - (int64_t)writer->s_nodes);
+      node.right = expr->ld_ident != NULL ? (int32_t)_skb_emit_symbol(writer, expr->ld_ident->token->str) : -1;
+      break;
+    }
+    case LD_NODE: {
+      node.left = (int32_t)_skb_emit_symbol(writer, expr->ld_ident->token->str);
+      break;
+    }
+    case S_NODE:
+    case K_NODE: {
+      break;
+    }
+  }
+
+  index = _skb_push_node(writer, node);
+  _sk_index_put(&writer->index, expr, index);
+  return index;
+}
+
+uint32_t _skb_emit_symbol(SKB_Writer* writer, const char* str) {
+  assert(writer != NULL && str != NULL);
+
+  // offsets are stored plus one so that the first symbol is not mistaken for a missing key
+  void* found = hashmap_get(writer->names, (char*)str);
+  if (found != NULL)
+    return (uint32_t)((uintptr_t)found - 1);
+
+  size_t s_str = strlen(str) + 1;
+  if (writer->s_symbols + s_str > writer->c_symbols) {
+    writer->c_symbols = 2 * (writer->c_symbols + s_str);
+    writer->symbols = (char*)realloc(writer->symbols, writer->c_symbols);
+    assert(writer->symbols != NULL);
+  }
+
+  uint32_t offset = (uint32_t)writer->s_symbols;
+  memcpy(writer->symbols + offset, str, s_str);
+  writer->s_symbols += s_str;
+
+  (void)hashmap_insert(&writer->names, (char*)str, (void*)((uintptr_t)offset + 1), NULL, false);
+  return offset;
+}
+
+uint32_t _skb_push_node(SKB_Writer* writer, struct skb_node node) {
+  assert(writer != NULL);
+
+  if (writer->s_nodes == writer->c_nodes) {
+    writer->c_nodes = writer->c_nodes > 0 ? 2 * writer->c_nodes : 1 << 10;
+    writer->nodes = (struct skb_node*)realloc(writer->nodes, writer->c_nodes * sizeof(struct skb_node));
+    assert(writer->nodes != NULL);
+  }
+  writer->nodes[writer->s_nodes] = node;
+  return (uint32_t)writer->s_nodes++;
+}
+
+bool _skb_write_padding(FILE* file, uint64_t s_padding) {
+  assert(file != NULL);
+  const char zeros[SKB_ALIGN] = { 0 };
+  return s_padding == 0 || fwrite(zeros, 1, s_padding, file) == s_padding;
+}
+
+bool _skb_valid_header(const struct skb_header* header, size_t s_memory) {
+  assert(header != NULL);
+
+  if (header->magic != SKB_MAGIC || header->version != SKB_VERSION)
+    return false;
+
+  uint64_t e_nodes   = header->nodes_offset + (uint64_t)header->s_nodes * sizeof(struct skb_node),
+           e_roots   = header->roots_offset + (uint64_t)header->s_roots * sizeof(struct skb_root),
+           e_deps    = header->deps_offset + (uint64_t)header->s_deps * sizeof(struct skb_dep),
+           e_symbols = header->symbols_offset + (uint64_t)header->s_symbols;
+  if (
+       header->nodes_offset < sizeof(struct skb_header) || header->nodes_offset % sizeof(uint32_t) != 0
+    || header->roots_offset < e_nodes || header->roots_offset % sizeof(uint32_t) != 0
+    || header->deps_offset < e_roots || header->deps_offset % sizeof(uint64_t) != 0
+    || header->symbols_offset < e_deps || e_symbols > s_memory
+  )
+    return false;
+
+  // every symbol is NUL terminated, so the table has to end with one
+  const char* symbols = (const char*)header + header->symbols_offset;
+  if (header->s_symbols == 0)
+    return header->s_roots == 0 && header->s_deps == 0;
+  if (symbols[header->s_symbols - 1] != '\0')
+    return false;
+
+  const struct skb_dep* deps = (const struct skb_dep*)((const char*)header + header->deps_offset);
+  for (uint32_t i = 0; i < header->s_deps; i++)
+    if (deps[i].symbol >= header->s_symbols)
+      return false;
+  return true;
+}
+
+bool _skb_valid_child(uint32_t i, int32_t offset) {
+  return offset < 0 && (int64_t)i + offset >= 0;
+}
@@ -0,0 +1,386 @@
+#include "skeval_priv.h"
+
+__thread uint64_t _ske_steps = 0;
+
+// ========================# PUBLIC #========================
+
+SK_Tree** ast_evaluate(Arena arena, AST* ast, HashTable table, Diagnostics* diagnostics) {
+  assert(arena != NULL && ast != NULL && table != NULL && diagnostics != NULL);
+
+  size_t s_stmts = ast->s_stmts;
+  SK_Tree** roots = (SK_Tree**)arena_alloc_tagged(arena, s_stmts * sizeof(SK_Tree*), TAG_ROOTS);
+  assert(roots != NULL);
+
+  // a thunk forced by one definition is shared with every later one, so nothing the machine
+  // allocates is released before the last root is read back and evacuated
+  SKE_Machine machine = {
+    .arena       = arena_shard_create(arena),
+    .diagnostics = diagnostics,
+    .stack       = NULL, .s_stack = 0, .capacity = 0,
+    .globals     = SK_INDEX_EMPTY,
+    .s_steps     = 0, .s_budget = 0, .s_depth = 0,
+    .looped      = false
+  };
+  assert(machine.arena != NULL);
+
+  ASTN_Stmt* stmt = ast->stmts;
+  for (size_t i = 0; i < s_stmts; i++, stmt = stmt->next)
+    roots[i] = _ske_evaluate_stmt(&machine, arena, stmt, table);
+
+  free(machine.stack);
+  _sk_index_free(&machine.globals);
+  (void)arena_reset(machine.arena);
+  return roots;
+}
+
+uint64_t ske_get_steps(void) {
+  return _ske_steps;
+}
+
+// ========================# PRIVATE #========================
+
+SK_Tree* _ske_evaluate_stmt(SKE_Machine* machine, Arena arena, ASTN_Stmt* stmt, HashTable table) {
+  assert(machine != NULL && arena != NULL && stmt != NULL && table != NULL);
+
+  // the machine is lazy, a name it never reaches would go unreported
+  _ast_expr_report_later(stmt->expr, machine->diagnostics);
+
+  const char* tag = arena_tag(machine->arena, TAG_SK_EVAL);
+  machine->s_steps  = 0;
+  machine->s_budget = SK_BACK_MAX_STEPS;
+  machine->s_depth  = 0;
+  machine->looped   = false;
+
+  SKE_Thunk* thunk = _ske_global(machine, stmt);
+  SK_Tree*   root  = _ske_read_back(machine, _ske_force(machine, thunk));
+
+  _ske_steps += machine->s_steps;
+  if (_sk_stats != NULL)
+    _sk_stats->s_eval_steps += machine->s_steps;
+
+  if (root == NULL) {
+    (void)arena_tag(machine->arena, tag);
+    root = _sk_back_convert(
+      arena, machine->arena, stmt, table, machine->diagnostics, "KRIVINE",
+      machine->looped ? "needs its own value" : "has no normal form within the limits of the machine"
+    );
+
+    // later definitions use the SK tree instead of running into the same wall
+    thunk->state = SKE_TREE;
+    thunk->fields.tree = root;
+    return root;
+  }
+
+  // the normal form has no redex, but a rewrite of the peephole pass can make one at the head
+  root = _ast_stmt_define(arena, machine->arena, stmt, root);
+  (void)arena_tag(machine->arena, tag);
+  return root;
+}
+
+SKE_Value* _ske_force(SKE_Machine* machine, SKE_Thunk* thunk) {
+  assert(machine != NULL);
+  if (thunk == NULL)
+    return NULL;
+  if (thunk->state == SKE_VALUE)
+    return thunk->fields.value;
+
+  // the control is a thunk to enter, an expression in its environment, an SK tree, or a value for
+  // the frame on top; a value with no frame left above base is the weak head normal form
+  size_t     base  = machine->s_stack;
+  SKE_Thunk* enter = thunk;
+  ASTN_Expr* expr  = NULL;
+  SKE_Env*   env   = NULL;
+  SK_Tree*   tree  = NULL;
+  SKE_Value* value = NULL;
+
+  for (;;) {
+    if (++machine->s_steps > machine->s_budget) {
+      _ske_unwind(machine, base);
+      return NULL;
+    }
+
+    if (enter != NULL) {
+      SKE_Thunk* current = enter;
+      enter = NULL;
+      if (current->state == SKE_VALUE) {
+        value = current->fields.value;
+      } else if (current->state == SKE_BLACKHOLE) {
+        machine->looped = true;
+        _ske_unwind(machine, base);
+        return NULL;
+      } else {
+        // a thunk being evaluated is blackholed, entering it again could only loop
+        _ske_push(machine, SKE_UPDATE, current);
+        current->state = SKE_BLACKHOLE;
+        switch (machine->stack[machine->s_stack - 1].state) {
+          case SKE_EXPR: {
+            expr = current->fields.expr.expr;
+            env  = current->fields.expr.env;
+            break;
+          }
+          case SKE_APPLY: {
+            _ske_push(machine, SKE_ARG, current->fields.apply.arg);
+            enter = current->fields.apply.fun;
+            continue;
+          }
+          case SKE_TREE: {
+            tree = current->fields.tree;
+            break;
+          }
+        }
+      }
+    }
+
+    if (expr != NULL) {
+      switch (expr->type) {
+        case EXPR_APP: {
+          SKE_Thunk* arg = _ske_thunk(machine, SKE_EXPR);
+          arg->fields.expr.expr = expr->fields.app.right;
+          arg->fields.expr.env  = env;
+          _ske_push(machine, SKE_ARG, arg);
+          expr = expr->fields.app.left;
+          continue;
+        }
+        case EXPR_ABS: {
+          // an argument already on the stack is bound at once, a closure is only made without one
+          if (machine->s_stack > base && machine->stack[machine->s_stack - 1].type == SKE_ARG) {
+            env  = _ske_env(machine, machine->stack[--machine->s_stack].thunk, env);
+            expr = expr->fields.abs.expr;
+            continue;
+          }
+          value = _ske_value(machine, SKE_CLOSURE, 0);
+          value->fields.closure.abs = expr;
+          value->fields.closure.env = env;
+          expr = NULL;
+          break;
+        }
+        case EXPR_IDENT: {
+          if (expr->index != AST_UNBOUND) {
+            SKE_Env* link = env;
+            for (uint32_t i = 0; i < expr->index; i++)
+              link = link->up;
+            enter = link->thunk;
+            expr  = NULL;
+            continue;
+          }
+
+          ASTN_Stmt* stmt = expr->fields.ident.stmt;
+          if (stmt != NULL && stmt->sk_expr != NULL) {
+            enter = _ske_global(machine, stmt);
+            expr  = NULL;
+            continue;
+          }
+          // a definition that comes later was reported before, it stays a name like a free one
+          value = _ske_value(machine, SKE_NEUTRAL, 0);
+          value->fields.neutral.head = expr->fields.ident.var;
+          value->fields.neutral.args = NULL;
+          expr = NULL;
+          break;
+        }
+      }
+    } else if (tree != NULL) {
+      switch (tree->type) {
+        case APP_NODE: {
+          SKE_Thunk* arg = _ske_thunk(machine, SKE_TREE);
+          arg->fields.tree = tree->right;
+          _ske_push(machine, SKE_ARG, arg);
+          tree = tree->left;
+          continue;
+        }
+        case REF_NODE: {
+          tree = tree->left;
+          assert(tree != NULL);
+          continue;
+        }
+        case LD_NODE: {
+          value = _ske_value(machine, SKE_NEUTRAL, 0);
+          value->fields.neutral.head = tree->ld_ident;
+          value->fields.neutral.args = NULL;
+          break;
+        }
+        case S_NODE:
+        case K_NODE: {
+          value = _ske_value(machine, SKE_COMBINATOR, 0);
+          value->fields.combinator.type = tree->type;
+          value->fields.combinator.args = NULL;
+          break;
+        }
+      }
+      tree = NULL;
+    }
+
+    assert(value != NULL);
+    if (machine->s_stack == base)
+      return value;
+
+    SKE_Frame frame = machine->stack[--machine->s_stack];
+    if (frame.type == SKE_UPDATE) {
+      frame.thunk->state = SKE_VALUE;
+      frame.thunk->fields.value = value;
+      continue;
+    }
+
+    switch (value->type) {
+      case SKE_CLOSURE: {
+        env   = _ske_env(machine, frame.thunk, value->fields.closure.env);
+        expr  = value->fields.closure.abs->fields.abs.expr;
+        value = NULL;
+        break;
+      }
+      case SKE_NEUTRAL: {
+        SKE_Value* applied = _ske_value(machine, SKE_NEUTRAL, value->s_args + 1);
+        applied->fields.neutral.head = value->fields.neutral.head;
+        applied->fields.neutral.args = _ske_env(machine, frame.thunk, value->fields.neutral.args);
+        value = applied;
+        break;
+      }
+      case SKE_COMBINATOR: {
+        SKE_Env* args = value->fields.combinator.args;
+        if (value->fields.combinator.type == K_NODE && value->s_args == 1) {
+          // K x y is x
+          enter = args->thunk;
+          value = NULL;
+          break;
+        }
+        if (value->fields.combinator.type == S_NODE && value->s_args == 2) {
+          // S x y z is x z (y z), with z shared by both sides
+          SKE_Thunk* yz = _ske_thunk(machine, SKE_APPLY);
+          yz->fields.apply.fun = args->thunk;
+          yz->fields.apply.arg = frame.thunk;
+          _ske_push(machine, SKE_ARG, yz);
+          _ske_push(machine, SKE_ARG, frame.thunk);
+          enter = args->up->thunk;
+          value = NULL;
+          break;
+        }
+        SKE_Value* applied = _ske_value(machine, SKE_COMBINATOR, value->s_args + 1);
+        applied->fields.combinator.type = value->fields.combinator.type;
+        applied->fields.combinator.args = _ske_env(machine, frame.thunk, args);
+        value = applied;
+        break;
+      }
+    }
+  }
+}
+
+SK_Tree* _ske_read_back(SKE_Machine* machine, SKE_Value* value) {
+  assert(machine != NULL);
+  if (value == NULL || ++machine->s_steps > machine->s_budget || machine->s_depth == SK_BACK_MAX_DEPTH)
+    return NULL;
+
+  SK_Tree* tree = NULL;
+  machine->s_depth++;
+  switch (value->type) {
+    case SKE_CLOSURE:
+    case SKE_COMBINATOR: {
+      // a closure, or S or K still missing arguments, whose spine is not a normal form either
+      ASTN_Ident* var = _sk_back_var(machine->arena);
+      SKE_Thunk* fun = _ske_thunk(machine, SKE_VALUE),
+               * app = _ske_thunk(machine, SKE_APPLY);
+      fun->fields.value = value;
+      app->fields.apply.fun = fun;
+      app->fields.apply.arg = _ske_neutral(machine, var);
+
+      SK_Tree* body = _ske_read_back(machine, _ske_force(machine, app));
+      if (body != NULL)
+        tree = _sk_back_abstract(machine->arena, body, var);
+      break;
+    }
+    case SKE_NEUTRAL: {
+      SK_Tree* head = _skt_node(machine->arena, LD_NODE, NULL, NULL, value->fields.neutral.head);
+      tree = _ske_read_back_app(machine, head, value->fields.neutral.args);
+      break;
+    }
+  }
+  machine->s_depth--;
+  return tree;
+}
+
+SK_Tree* _ske_read_back_app(SKE_Machine* machine, SK_Tree* head, SKE_Env* args) {
+  assert(machine != NULL && head != NULL);
+  if (args == NULL)
+    return head;
+  if (machine->s_depth == SK_BACK_MAX_DEPTH)
+    return NULL;
+
+  // the last argument is the first of the list
+  machine->s_depth++;
+  SK_Tree* left  = _ske_read_back_app(machine, head, args->up),
+         * right = left != NULL ? _ske_read_back(machine, _ske_force(machine, args->thunk)) : NULL;
+  machine->s_depth--;
+  if (right == NULL)
+    return NULL;
+  return _skt_node(machine->arena, APP_NODE, left, right, NULL);
+}
+
+SKE_Thunk* _ske_global(SKE_Machine* machine, ASTN_Stmt* stmt) {
+  assert(machine != NULL && stmt != NULL);
+
+  SKE_Thunk* thunk = (SKE_Thunk*)_sk_index_get_ptr(&machine->globals, stmt);
+  if (thunk != NULL)
+    return thunk;
+
+  // a definition of this program is evaluated from its source, a linked one from its SK tree
+  if (stmt->expr != NULL) {
+    thunk = _ske_thunk(machine, SKE_EXPR);
+    thunk->fields.expr.expr = stmt->expr;
+    thunk->fields.expr.env  = NULL;
+  } else {
+    thunk = _ske_thunk(machine, SKE_TREE);
+    thunk->fields.tree = stmt->sk_expr;
+  }
+  _sk_index_put_ptr(&machine->globals, stmt, thunk);
+  return thunk;
+}
+
+void _ske_unwind(SKE_Machine* machine, size_t base) {
+  assert(machine != NULL && base <= machine->s_stack);
+
+  // the thunks left blackholed get back what they were, a later definition may still force them
+  for (; machine->s_stack > base; machine->s_stack--) {
+    SKE_Frame* frame = &machine->stack[machine->s_stack - 1];
+    if (frame->type == SKE_UPDATE)
+      frame->thunk->state = frame->state;
+  }
+}
+
+void _ske_push(SKE_Machine* machine, uint32_t type, SKE_Thunk* thunk) {
+  assert(machine != NULL && thunk != NULL);
+
+  if (machine->s_stack == machine->capacity) {
+    machine->capacity = machine->capacity > 0 ? 2 * machine->capacity : 1 << 10;
+    machine->stack = (SKE_Frame*)realloc(machine->stack, machine->capacity * sizeof(SKE_Frame));
+    assert(machine->stack != NULL);
+  }
+  machine->stack[machine->s_stack++] = (SKE_Frame){ .type = type, .state = thunk->state, .thunk = thunk };
+}
+
+SKE_Thunk* _ske_thunk(SKE_Machine* machine, uint32_t state) {
+  SKE_Thunk* thunk = (SKE_Thunk*)arena_alloc(machine->arena, sizeof(struct ske_thunk));
+  assert(thunk != NULL);
+  thunk->state = state;
+  return thunk;
+}
+
+SKE_Value* _ske_value(SKE_Machine* machine, uint32_t type, uint32_t s_args) {
+  SKE_Value* value = (SKE_Value*)arena_alloc(machine->arena, sizeof(struct ske_value));
+  assert(value != NULL);
+  value->type   = type;
+  value->s_args = s_args;
+  return value;
+}
+
+SKE_Thunk* _ske_neutral(SKE_Machine* machine, ASTN_Ident* var) {
+  SKE_Thunk* thunk = _ske_thunk(machine, SKE_VALUE);
+  thunk->fields.value = _ske_value(machine, SKE_NEUTRAL, 0);
+  thunk->fields.value->fields.neutral.head = var;
+  thunk->fields.value->fields.neutral.args = NULL;
+  return thunk;
+}
+
+SKE_Env* _ske_env(SKE_Machine* machine, SKE_Thunk* thunk, SKE_Env* up) {
+  SKE_Env* env = (SKE_Env*)arena_alloc(machine->arena, sizeof(struct ske_env));
+  assert(env != NULL);
+  *env = (SKE_Env){ .thunk = thunk, .up = up };
+  return env;
+}
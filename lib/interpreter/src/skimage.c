@@ -0,0 +1,351 @@
+#include "skimage_priv.h"
+
+// ========================# PUBLIC #========================
+
+bool ski_write(FILE* file, SK_Tree** roots, size_t s_roots) {
+  assert(file != NULL && roots != NULL);
+
+  SKI_Writer writer = {
+    .index = SK_INDEX_EMPTY,
+    .names = hashmap_create(1 << 5, .75),
+    .nodes = NULL, .s_nodes = 0, .c_nodes = 0,
+    .idents = NULL, .tokens = NULL, .s_idents = 0, .c_idents = 0,
+    .symbols = NULL, .s_symbols = 0, .c_symbols = 0
+  };
+  assert(writer.names != NULL);
+
+  struct astn_stmt* stmts = (struct astn_stmt*)malloc((s_roots > 0 ? s_roots : 1) * sizeof(struct astn_stmt));
+  assert(stmts != NULL);
+
+  for (size_t i = 0; i < s_roots; i++) {
+    assert(roots[i] != NULL && roots[i]->ld_ident != NULL);
+    stmts[i] = (struct astn_stmt){
+      .frow    = 0,
+      .fcol    = 0,
+      .erow    = 0,
+      .ecol    = 0,
+      .var     = (ASTN_Ident*)(uintptr_t)(_ski_emit_ident(&writer, roots[i]->ld_ident->token->str) + 1),
+      .expr    = NULL,
+      .next    = NULL,
+      .sk_expr = SKI_NODE(_ski_emit(&writer, roots[i]))
+    };
+  }
+
+  // every struct is a multiple of eight bytes, so each section starts aligned right after the last
+  struct ski_header header = {
+    .magic     = SKI_MAGIC,
+    .version   = SKI_VERSION,
+    .s_tree    = sizeof(struct sk_tree),
+    .s_stmt    = sizeof(struct astn_stmt),
+    .s_ident   = sizeof(struct astn_id),
+    .s_token   = sizeof(struct astn_token),
+    .base      = SKI_BASE,
+    .s_nodes   = writer.s_nodes,
+    .s_stmts   = s_roots,
+    .s_idents  = writer.s_idents,
+    .s_symbols = writer.s_symbols
+  };
+  header.nodes_offset   = sizeof(struct ski_header);
+  header.stmts_offset   = header.nodes_offset + writer.s_nodes * sizeof(struct sk_tree);
+  header.idents_offset  = header.stmts_offset + s_roots * sizeof(struct astn_stmt);
+  header.tokens_offset  = header.idents_offset + writer.s_idents * sizeof(struct astn_id);
+  header.symbols_offset = header.tokens_offset + writer.s_idents * sizeof(struct astn_token);
+  header.s_image        = header.symbols_offset + writer.s_symbols;
+  _ski_fix(&writer, &header, stmts);
+
+  bool written = (
+       fwrite(&header, sizeof(struct ski_header), 1, file) == 1
+    && fwrite(writer.nodes, sizeof(struct sk_tree), writer.s_nodes, file) == writer.s_nodes
+    && fwrite(stmts, sizeof(struct astn_stmt), s_roots, file) == s_roots
+    && fwrite(writer.idents, sizeof(struct astn_id), writer.s_idents, file) == writer.s_idents
+    && fwrite(writer.tokens, sizeof(struct astn_token), writer.s_idents, file) == writer.s_idents
+    && fwrite(writer.symbols, 1, writer.s_symbols, file) == writer.s_symbols
+  );
+
+  free(stmts);
+  free(writer.nodes);
+  free(writer.idents);
+  free(writer.tokens);
+  free(writer.symbols);
+  _sk_index_free(&writer.index);
+  hashmap_free(writer.names, NULL, false);
+  return written;
+}
+
+SKI_Image* ski_load(const char* filename) {
+  assert(filename != NULL);
+
+  int32_t fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[SKI LOADER]: could not open %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  // the header says where the image wants to be before anything is mapped
+  struct stat st;
+  struct ski_header header;
+  if (
+       fstat(fd, &st) != 0 || pread(fd, &header, sizeof(struct ski_header), 0) != (ssize_t)sizeof(struct ski_header)
+    || !_ski_valid_header(&header, (size_t)st.st_size)
+  ) {
+    fprintf(stderr, "[SKI LOADER]: %s is not a heap image of this build (version %u)\n", filename, SKI_VERSION);
+    close(fd);
+    return NULL;
+  }
+
+  // at its own address the image is used as it is and its pages stay those of the page cache,
+  // a kernel without MAP_FIXED_NOREPLACE takes the address as a hint and may map it elsewhere
+  size_t s_memory = (size_t)st.st_size;
+  void* base = (void*)(uintptr_t)header.base;
+  void* memory = mmap(base, s_memory, PROT_READ, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, 0);
+  bool relocated = memory != base;
+  if (relocated) {
+    if (memory != MAP_FAILED)
+      munmap(memory, s_memory);
+    memory = mmap(NULL, s_memory, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (memory == MAP_FAILED) {
+    fprintf(stderr, "[SKI LOADER]: could not map %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  SKI_Image* image = (SKI_Image*)malloc(sizeof(struct ski_image));
+  assert(image != NULL);
+
+  *image = (SKI_Image){
+    .memory    = memory,
+    .s_memory  = s_memory,
+    .header    = (const struct ski_header*)memory,
+    .stmts     = (ASTN_Stmt*)((char*)memory + header.stmts_offset),
+    .relocated = relocated
+  };
+  if (relocated) {
+    _ski_relocate(image, (uintptr_t)memory - (uintptr_t)header.base);
+    (void)mprotect(memory, s_memory, PROT_READ);
+  }
+
+  if (!_ski_valid_stmts(image)) {
+    fprintf(stderr, "[SKI LOADER]: %s has a statement out of bounds\n", filename);
+    ski_unload(image);
+    return NULL;
+  }
+  return image;
+}
+
+ASTN_Stmt* ski_get_stmts(SKI_Image* image) {
+  assert(image != NULL);
+  return image->header->s_stmts > 0 ? image->stmts : NULL;
+}
+
+size_t ski_get_size_stmts(SKI_Image* image) {
+  assert(image != NULL);
+  return image->header->s_stmts;
+}
+
+size_t ski_get_size_nodes(SKI_Image* image) {
+  assert(image != NULL);
+  return image->header->s_nodes;
+}
+
+bool ski_is_relocated(SKI_Image* image) {
+  assert(image != NULL);
+  return image->relocated;
+}
+
+bool ski_contains(SKI_Image* image, const void* ptr) {
+  if (image == NULL || ptr == NULL)
+    return false;
+  return (const char*)ptr >= (const char*)image->memory && (const char*)ptr < (const char*)image->memory + image->s_memory;
+}
+
+void ski_unload(SKI_Image* image) {
+  if (image == NULL)
+    return;
+  munmap(image->memory, image->s_memory);
+  free(image);
+}
+
+// ========================# PRIVATE #========================
+
+uint64_t _ski_emit(SKI_Writer* writer, const SK_Tree* expr) {
+  assert(writer != NULL && expr != NULL);
+
+  uint64_t index;
+  if (_sk_index_get(&writer->index, expr, &index))
+    return index;
+
+  // children are emitted first, the node then lands at s_nodes
+  struct sk_tree node = *expr;
+  switch (expr->type) {
+    case APP_NODE: {
+      node.left  = SKI_NODE(_ski_emit(writer, expr->left));
+      node.right = SKI_NODE(_ski_emit(writer, expr->right));
+      break;
+    }
+    case REF_NODE: {
+      node.left = SKI_NODE(_ski_emit(writer, expr->left));
+      break;
+    }
+    case LD_NODE:
+    case S_NODE:
+    case K_NODE: {
+      break;
+    }
+  }
+  if (expr->ld_ident != NULL)
+    node.ld_ident = (ASTN_Ident*)(uintptr_t)(_ski_emit_ident(writer, expr->ld_ident->token->str) + 1);
+
+  if (writer->s_nodes == writer->c_nodes) {
+    writer->c_nodes = writer->c_nodes > 0 ? 2 * writer->c_nodes : 1 << 10;
+    writer->nodes = (struct sk_tree*)realloc(writer->nodes, writer->c_nodes * sizeof(struct sk_tree));
+    assert(writer->nodes != NULL);
+  }
+  index = writer->s_nodes++;
+  writer->nodes[index] = node;
+  _sk_index_put(&writer->index, expr, index);
+  return index;
+}
+
+uint64_t _ski_emit_ident(SKI_Writer* writer, const char* str) {
+  assert(writer != NULL && str != NULL);
+
+  // indices are stored plus one so that the first name is not mistaken for a missing key
+  void* found = hashmap_get(writer->names, (char*)str);
+  if (found != NULL)
+    return (uint64_t)((uintptr_t)found - 1);
+
+  size_t s_str = strlen(str) + 1;
+  if (writer->s_symbols + s_str > writer->c_symbols) {
+    writer->c_symbols = 2 * (writer->c_symbols + s_str);
+    writer->symbols = (char*)realloc(writer->symbols, writer->c_symbols);
+    assert(writer->symbols != NULL);
+  }
+  if (writer->s_idents == writer->c_idents) {
+    writer->c_idents = writer->c_idents > 0 ? 2 * writer->c_idents : 1 << 6;
+    writer->idents = (struct astn_id*)realloc(writer->idents, writer->c_idents * sizeof(struct astn_id));
+    writer->tokens = (struct astn_token*)realloc(writer->tokens, writer->c_idents * sizeof(struct astn_token));
+    assert(writer->idents != NULL && writer->tokens != NULL);
+  }
+
+  uint64_t index = writer->s_idents++;
+  writer->idents[index] = (struct astn_id){ .frow = 0, .fcol = 0, .erow = 0, .ecol = 0, .s_id = 0, .token = NULL, .next = NULL };
+  // a token has padding before str, cleared so that the same definitions always make the same file
+  memset(&writer->tokens[index], 0, sizeof(struct astn_token));
+  writer->tokens[index].str = (const char*)(uintptr_t)writer->s_symbols;
+  memcpy(writer->symbols + writer->s_symbols, str, s_str);
+  writer->s_symbols += s_str;
+
+  (void)hashmap_insert(&writer->names, (char*)str, (void*)((uintptr_t)index + 1), NULL, false);
+  return index;
+}
+
+void _ski_fix(SKI_Writer* writer, const struct ski_header* header, struct astn_stmt* stmts) {
+  assert(writer != NULL && header != NULL && (stmts != NULL || header->s_stmts == 0));
+
+  // the offsets are only known once everything is emitted, the staged indices become addresses
+  uintptr_t idents  = header->base + header->idents_offset,
+            tokens  = header->base + header->tokens_offset,
+            symbols = header->base + header->symbols_offset;
+  for (size_t i = 0; i < writer->s_nodes; i++)
+    if (writer->nodes[i].ld_ident != NULL)
+      writer->nodes[i].ld_ident = (ASTN_Ident*)(idents + ((uintptr_t)writer->nodes[i].ld_ident - 1) * sizeof(struct astn_id));
+  for (size_t i = 0; i < writer->s_idents; i++) {
+    writer->idents[i].token = (ASTN_Token*)(tokens + i * sizeof(struct astn_token));
+    writer->tokens[i].str   = (const char*)(symbols + (uintptr_t)writer->tokens[i].str);
+  }
+  for (size_t i = 0; i < header->s_stmts; i++) {
+    stmts[i].var  = (ASTN_Ident*)(idents + ((uintptr_t)stmts[i].var - 1) * sizeof(struct astn_id));
+    stmts[i].next = i + 1 < header->s_stmts ? (ASTN_Stmt*)(header->base + header->stmts_offset + (i + 1) * sizeof(struct astn_stmt)) : NULL;
+  }
+}
+
+void _ski_relocate(SKI_Image* image, uintptr_t delta) {
+  assert(image != NULL);
+
+  // every page is written once and stops being shared, the price of a taken address
+  const struct ski_header* header = image->header;
+  struct sk_tree*    nodes  = (struct sk_tree*)((char*)image->memory + header->nodes_offset);
+  struct astn_id*    idents = (struct astn_id*)((char*)image->memory + header->idents_offset);
+  struct astn_token* tokens = (struct astn_token*)((char*)image->memory + header->tokens_offset);
+  for (uint64_t i = 0; i < header->s_nodes; i++) {
+    SKI_MOVE(nodes[i].left, delta);
+    SKI_MOVE(nodes[i].right, delta);
+    SKI_MOVE(nodes[i].ld_ident, delta);
+  }
+  for (uint64_t i = 0; i < header->s_stmts; i++) {
+    SKI_MOVE(image->stmts[i].var, delta);
+    SKI_MOVE(image->stmts[i].next, delta);
+    SKI_MOVE(image->stmts[i].sk_expr, delta);
+  }
+  for (uint64_t i = 0; i < header->s_idents; i++) {
+    SKI_MOVE(idents[i].token, delta);
+    SKI_MOVE(idents[i].next, delta);
+    SKI_MOVE(tokens[i].str, delta);
+  }
+}
+
+bool _ski_valid_header(const struct ski_header* header, size_t s_memory) {
+  assert(header != NULL);
+
+  if (
+       header->magic != SKI_MAGIC || header->version != SKI_VERSION
+    || header->s_tree != sizeof(struct sk_tree) || header->s_stmt != sizeof(struct astn_stmt)
+    || header->s_ident != sizeof(struct astn_id) || header->s_token != sizeof(struct astn_token)
+    || header->base == 0 || header->base % (uint64_t)sysconf(_SC_PAGESIZE) != 0 || header->s_image != s_memory
+  )
+    return false;
+
+  // the counts are bounded by the file first, so that the section ends below cannot overflow
+  if (
+       header->s_nodes > s_memory / sizeof(struct sk_tree) || header->s_stmts > s_memory / sizeof(struct astn_stmt)
+    || header->s_idents > s_memory / sizeof(struct astn_id) || header->s_symbols > s_memory
+  )
+    return false;
+
+  uint64_t e_nodes  = header->nodes_offset + header->s_nodes * sizeof(struct sk_tree),
+           e_stmts  = header->stmts_offset + header->s_stmts * sizeof(struct astn_stmt),
+           e_idents = header->idents_offset + header->s_idents * sizeof(struct astn_id),
+           e_tokens = header->tokens_offset + header->s_idents * sizeof(struct astn_token);
+  return (
+       header->nodes_offset >= sizeof(struct ski_header) && header->nodes_offset % SKI_ALIGN == 0
+    && header->stmts_offset >= e_nodes && header->stmts_offset % SKI_ALIGN == 0
+    && header->idents_offset >= e_stmts && header->idents_offset % SKI_ALIGN == 0
+    && header->tokens_offset >= e_idents && header->tokens_offset % SKI_ALIGN == 0
+    && header->symbols_offset >= e_tokens && header->symbols_offset <= s_memory
+    && header->s_symbols <= s_memory - header->symbols_offset
+  );
+}
+
+bool _ski_valid_stmts(SKI_Image* image) {
+  assert(image != NULL);
+
+  // every name read through the statements has to end inside the symbol table
+  const struct ski_header* header = image->header;
+  const char* symbols = (const char*)image->memory + header->symbols_offset;
+  if (header->s_stmts > 0 && (header->s_symbols == 0 || symbols[header->s_symbols - 1] != '\0'))
+    return false;
+
+  for (uint64_t i = 0; i < header->s_stmts; i++) {
+    const ASTN_Stmt* stmt = &image->stmts[i];
+    if (
+         !_ski_within(header, stmt->var, header->idents_offset, header->s_idents, sizeof(struct astn_id))
+      || !_ski_within(header, stmt->sk_expr, header->nodes_offset, header->s_nodes, sizeof(struct sk_tree))
+      || !_ski_within(header, stmt->var->token, header->tokens_offset, header->s_idents, sizeof(struct astn_token))
+      || !_ski_within(header, stmt->var->token->str, header->symbols_offset, header->s_symbols, 1)
+      || stmt->expr != NULL || stmt->next != (i + 1 < header->s_stmts ? &image->stmts[i + 1] : NULL)
+    )
+      return false;
+  }
+  return true;
+}
+
+bool _ski_within(const struct ski_header* header, const void* ptr, uint64_t offset, uint64_t count, size_t size) {
+  assert(header != NULL && size > 0);
+
+  uintptr_t start = (uintptr_t)header + offset;
+  if ((uintptr_t)ptr < start)
+    return false;
+  uintptr_t at = (uintptr_t)ptr - start;
+  return at / size < count && at % size == 0;
+}
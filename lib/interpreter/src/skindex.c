@@ -0,0 +1,75 @@
+#include "skindex_priv.h"
+
+// ========================# PRIVATE #========================
+
+bool _sk_index_get(SK_Index* index, const void* key, uint64_t* value) {
+  assert(index != NULL && key != NULL && value != NULL);
+  if (index->capacity == 0)
+    return false;
+
+  size_t mask = index->capacity - 1,
+         i    = (size_t)(((uintptr_t)key >> 3) * 0x9e3779b97f4a7c15ull) & mask;
+  for (; index->keys[i] != NULL; i = (i + 1) & mask) {
+    if (index->keys[i] != key)
+      continue;
+    *value = index->values[i];
+    return true;
+  }
+  return false;
+}
+
+void _sk_index_put(SK_Index* index, const void* key, uint64_t value) {
+  assert(index != NULL && key != NULL);
+
+  if (2 * (index->s_index + 1) > index->capacity) {
+    SK_Index grown = {
+      .keys     = NULL,
+      .values   = NULL,
+      .s_index  = 0,
+      .capacity = index->capacity > 0 ? 2 * index->capacity : 1 << 6
+    };
+    grown.keys   = (const void**)calloc(grown.capacity, sizeof(void*));
+    grown.values = (uint64_t*)malloc(grown.capacity * sizeof(uint64_t));
+    assert(grown.keys != NULL && grown.values != NULL);
+
+    for (size_t i = 0; i < index->capacity; i++)
+      if (index->keys[i] != NULL)
+        _sk_index_put(&grown, index->keys[i], index->values[i]);
+
+    _sk_index_free(index);
+    *index = grown;
+  }
+
+  size_t mask = index->capacity - 1,
+         i    = (size_t)(((uintptr_t)key >> 3) * 0x9e3779b97f4a7c15ull) & mask;
+  for (; index->keys[i] != NULL && index->keys[i] != key; i = (i + 1) & mask);
+
+  if (index->keys[i] == NULL)
+    index->s_index++;
+  index->keys[i]   = key;
+  index->values[i] = value;
+}
+
+void* _sk_index_get_ptr(SK_Index* index, const void* key) {
+  uint64_t value = 0;
+  return _sk_index_get(index, key, &value) ? (void*)(uintptr_t)value : NULL;
+}
+
+void _sk_index_put_ptr(SK_Index* index, const void* key, void* value) {
+  _sk_index_put(index, key, (uint64_t)(uintptr_t)value);
+}
+
+void _sk_index_clear(SK_Index* index) {
+  assert(index != NULL);
+
+  // the keys are emptied in place, a pass that is run again keeps the capacity it grew to
+  index->s_index = 0;
+  if (index->capacity > 0)
+    memset(index->keys, 0, index->capacity * sizeof(void*));
+}
+
+void _sk_index_free(SK_Index* index) {
+  assert(index != NULL);
+  free(index->keys);
+  free(index->values);
+}
@@ -0,0 +1,1068 @@
+#include "sknet_priv.h"
+
+__thread uint64_t _skn_steps = 0;
+
+static uint32_t _skn_threads = 1;
+
+// ========================# PUBLIC #========================
+
+SK_Tree** ast_interact(Arena arena, AST* ast, HashTable table, Diagnostics* diagnostics) {
+  assert(arena != NULL && ast != NULL && table != NULL && diagnostics != NULL);
+
+  SKN_Machine machine;
+  if (!_skn_create(&machine, arena, diagnostics)) {
+    fprintf(
+      stderr, "[NET]: could not map the net in file %s, the definitions are converted and reduced as SK instead\n",
+      diagnostics_get_filename(diagnostics)
+    );
+    return ast_convert(arena, ast, table, diagnostics);
+  }
+
+  size_t s_stmts = ast->s_stmts;
+  SK_Tree** roots = (SK_Tree**)arena_alloc_tagged(arena, s_stmts * sizeof(SK_Tree*), TAG_ROOTS);
+  assert(roots != NULL);
+
+  ASTN_Stmt* stmt = ast->stmts;
+  for (size_t i = 0; i < s_stmts; i++, stmt = stmt->next)
+    roots[i] = _skn_evaluate_stmt(&machine, arena, stmt, table);
+
+  _skn_destroy(&machine);
+  return roots;
+}
+
+void skn_set_threads(uint32_t s_threads) {
+  assert(s_threads > 0);
+  _skn_threads = s_threads < SKN_MAX_THREADS ? s_threads : SKN_MAX_THREADS;
+}
+
+uint64_t skn_get_steps(void) {
+  return _skn_steps;
+}
+
+// ========================# PRIVATE #========================
+
+bool _skn_create(SKN_Machine* machine, Arena arena, Diagnostics* diagnostics) {
+  assert(machine != NULL && arena != NULL && diagnostics != NULL);
+
+  // past SKN_MAX_NODES every thread may still take one chunk to finish the interaction it is in
+  size_t s_nodes = (size_t)SKN_MAX_NODES + (size_t)SKN_CHUNK * (SKN_MAX_THREADS + 1);
+  size_t s_map   = s_nodes * (sizeof(SKN_Node) + sizeof(SKN_Port));
+  void*  map     = mmap(NULL, s_map, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (map == MAP_FAILED)
+    return false;
+
+  *machine = (SKN_Machine){
+    .arena       = arena_shard_create(arena),
+    .diagnostics = diagnostics,
+    .nodes       = (SKN_Node*)map,
+    .vars        = (SKN_Port*)((SKN_Node*)map + s_nodes),
+    .s_map       = s_map,
+    .workers     = (SKN_Worker*)calloc(_skn_threads, sizeof(SKN_Worker)),
+    .s_workers   = _skn_threads
+  };
+  assert(machine->arena != NULL && machine->workers != NULL);
+  for (uint32_t i = 0; i < machine->s_workers; i++) {
+    machine->workers[i].machine = machine;
+    pthread_mutex_init(&machine->workers[i].lock, NULL);
+  }
+
+  // S and K for the definitions linked as SK trees, their binders already resolved
+  Arena a = machine->arena;
+  ASTN_Expr* sxz = _skn_ast(a, EXPR_APP, _skn_ast(a, EXPR_IDENT, NULL, NULL, 2), _skn_ast(a, EXPR_IDENT, NULL, NULL, 0), 0),
+           * syz = _skn_ast(a, EXPR_APP, _skn_ast(a, EXPR_IDENT, NULL, NULL, 1), _skn_ast(a, EXPR_IDENT, NULL, NULL, 0), 0),
+           * kx  = _skn_ast(a, EXPR_IDENT, NULL, NULL, 1);
+  machine->combinators[0] = _skn_ast(a, EXPR_ABS, _skn_ast(a, EXPR_ABS, _skn_ast(a, EXPR_ABS, _skn_ast(a, EXPR_APP, sxz, syz, 0), NULL, 0), NULL, 0), NULL, 0);
+  machine->combinators[1] = _skn_ast(a, EXPR_ABS, _skn_ast(a, EXPR_ABS, kx, NULL, 0), NULL, 0);
+  return true;
+}
+
+void _skn_destroy(SKN_Machine* machine) {
+  assert(machine != NULL);
+
+  for (uint32_t i = 0; i < machine->s_workers; i++) {
+    SKN_Worker* worker = &machine->workers[i];
+    free(worker->redexes);
+    free(worker->shared);
+    free(worker->free_nodes.items);
+    free(worker->free_vars.items);
+    pthread_mutex_destroy(&worker->lock);
+  }
+  free(machine->workers);
+  free(machine->names);
+  free(machine->order);
+  free(machine->counts);
+  free(machine->open);
+  free(machine->binders);
+  _sk_index_free(&machine->globals);
+  _sk_index_free(&machine->fallen);
+  (void)munmap(machine->nodes, machine->s_map);
+  (void)arena_reset(machine->arena);
+}
+
+void _skn_reset(SKN_Machine* machine) {
+  assert(machine != NULL);
+
+  // every definition gets a net of its own, the nodes and wires of the last one are taken again
+  machine->s_nodes  = 0;
+  machine->s_vars   = 0;
+  machine->s_steps  = 0;
+  machine->aborted  = false;
+  machine->s_names  = 0;
+  machine->s_order  = 0;
+  _sk_index_free(&machine->globals);
+  machine->globals = SK_INDEX_EMPTY;
+  for (uint32_t i = 0; i < machine->s_workers; i++) {
+    SKN_Worker* worker = &machine->workers[i];
+    worker->s_redexes = worker->s_shared = 0;
+    worker->free_nodes.s_items = worker->free_vars.s_items = 0;
+    worker->next_node = worker->end_node = worker->next_var = worker->end_var = 0;
+    worker->s_steps = 0;
+  }
+}
+
+SK_Tree* _skn_evaluate_stmt(SKN_Machine* machine, Arena arena, ASTN_Stmt* stmt, HashTable table) {
+  assert(machine != NULL && arena != NULL && stmt != NULL && table != NULL);
+
+  // the net is built from the whole definition, but a name defined later is only an error here
+  _ast_expr_report_later(stmt->expr, machine->diagnostics);
+
+  ArenaMark mark = arena_mark(machine->arena);
+  const char* tag = arena_tag(machine->arena, TAG_SK_EVAL);
+  _skn_reset(machine);
+  _skn_build(machine, stmt);
+  bool reduced  = !machine->aborted && _skn_reduce(machine);
+  SK_Tree* root = reduced ? _skn_read_back(machine) : NULL;
+
+  _skn_steps += machine->s_steps;
+  if (_sk_stats != NULL)
+    _sk_stats->s_net_steps += machine->s_steps;
+
+  if (root == NULL) {
+    (void)arena_tag(machine->arena, tag);
+    (void)arena_release(machine->arena, mark);
+
+    // the net of a later definition takes the SK tree instead of running into the same wall
+    _sk_index_put_ptr(&machine->fallen, stmt, stmt);
+    return _sk_back_convert(
+      arena, machine->arena, stmt, table, machine->diagnostics, "NET",
+      reduced ? "could not be read back from its net" : "has no normal form within the limits of the net"
+    );
+  }
+
+  root = _ast_stmt_define(arena, machine->arena, stmt, root);
+  (void)arena_tag(machine->arena, tag);
+  (void)arena_release(machine->arena, mark);
+  return root;
+}
+
+void _skn_build(SKN_Machine* machine, ASTN_Stmt* stmt) {
+  assert(machine != NULL && stmt != NULL);
+
+  // the definitions the statement reaches are compiled once each, dependencies first, and their
+  // value goes through duplicators to every use, like a variable bound around the statement: at
+  // level 0, with the definition an argument at level 1
+  SKN_Worker* worker = &machine->workers[0];
+  _skn_reach(machine, stmt->expr);
+  for (size_t i = 0; i < machine->s_order && !machine->aborted; i++) {
+    ASTN_Stmt* global = machine->order[i];
+    SKN_Port   uses   = _skn_share(machine, (SKN_Uses*)_sk_index_get_ptr(&machine->globals, global));
+    _skn_link(worker, _skn_definition(machine, global), uses);
+  }
+
+  machine->root = _skn_node(worker, SKN_ROOT, 0);
+  SKN_Port value = machine->aborted ? SKN_PORT(SKN_ERA, 0) : _skn_term(machine, stmt->expr, 0);
+  machine->nodes[machine->root].ports[0] = value;
+  machine->nodes[machine->root].ports[1] = SKN_NONE;
+}
+
+void _skn_reach(SKN_Machine* machine, ASTN_Expr* expr) {
+  assert(machine != NULL && expr != NULL);
+
+  switch (expr->type) {
+    case EXPR_APP: {
+      _skn_reach(machine, expr->fields.app.left);
+      _skn_reach(machine, expr->fields.app.right);
+      break;
+    }
+    case EXPR_ABS: {
+      _skn_reach(machine, expr->fields.abs.expr);
+      break;
+    }
+    case EXPR_IDENT: {
+      ASTN_Stmt* stmt = expr->fields.ident.stmt;
+      if (expr->index != AST_UNBOUND || stmt == NULL || stmt->sk_expr == NULL)
+        break;
+
+      SKN_Uses* uses = (SKN_Uses*)_sk_index_get_ptr(&machine->globals, stmt);
+      if (uses == NULL) {
+        uses = (SKN_Uses*)arena_alloc(machine->arena, sizeof(struct skn_uses));
+        assert(uses != NULL);
+        *uses = (SKN_Uses){ .ports = NULL, .s_ports = 0, .next = 0, .level = 0 };
+        _sk_index_put_ptr(&machine->globals, stmt, uses);
+        if (stmt->expr != NULL && _sk_index_get_ptr(&machine->fallen, stmt) == NULL)
+          _skn_reach(machine, stmt->expr);
+
+        if (machine->s_order == machine->c_order) {
+          machine->c_order = machine->c_order > 0 ? 2 * machine->c_order : 1 << 6;
+          machine->order = (ASTN_Stmt**)realloc(machine->order, machine->c_order * sizeof(ASTN_Stmt*));
+          assert(machine->order != NULL);
+        }
+        machine->order[machine->s_order++] = stmt;
+      }
+      uses->s_ports++;
+      break;
+    }
+  }
+}
+
+SKN_Port _skn_definition(SKN_Machine* machine, ASTN_Stmt* stmt) {
+  assert(machine != NULL && stmt != NULL);
+
+  // a linked definition, or one that fell back, only has its SK tree
+  if (stmt->expr != NULL && _sk_index_get_ptr(&machine->fallen, stmt) == NULL)
+    return _skn_term(machine, stmt->expr, 1);
+  return _skn_tree(machine, stmt->sk_expr, 1);
+}
+
+SKN_Port _skn_term(SKN_Machine* machine, ASTN_Expr* expr, uint32_t level) {
+  assert(machine != NULL && expr != NULL);
+
+  machine->s_counts   = 0;
+  machine->next_count = 0;
+  machine->s_open     = 0;
+  machine->s_binders  = 0;
+  _skn_count(machine, expr);
+  return _skn_compile(machine, expr, level);
+}
+
+void _skn_count(SKN_Machine* machine, ASTN_Expr* expr) {
+  assert(machine != NULL && expr != NULL);
+
+  switch (expr->type) {
+    case EXPR_APP: {
+      _skn_count(machine, expr->fields.app.left);
+      _skn_count(machine, expr->fields.app.right);
+      break;
+    }
+    case EXPR_ABS: {
+      if (machine->s_counts == machine->c_counts) {
+        machine->c_counts = machine->c_counts > 0 ? 2 * machine->c_counts : 1 << 6;
+        machine->counts = (uint32_t*)realloc(machine->counts, machine->c_counts * sizeof(uint32_t));
+        assert(machine->counts != NULL);
+      }
+      if (machine->s_open == machine->c_open) {
+        machine->c_open = machine->c_open > 0 ? 2 * machine->c_open : 1 << 6;
+        machine->open = (uint32_t*)realloc(machine->open, machine->c_open * sizeof(uint32_t));
+        assert(machine->open != NULL);
+      }
+      machine->counts[machine->s_counts] = 0;
+      machine->open[machine->s_open++]   = (uint32_t)machine->s_counts++;
+      _skn_count(machine, expr->fields.abs.expr);
+      machine->s_open--;
+      break;
+    }
+    case EXPR_IDENT: {
+      if (expr->index == AST_UNBOUND)
+        break;
+      assert(expr->index < machine->s_open);
+      machine->counts[machine->open[machine->s_open - 1 - expr->index]]++;
+      break;
+    }
+  }
+}
+
+SKN_Port _skn_compile(SKN_Machine* machine, ASTN_Expr* expr, uint32_t level) {
+  assert(machine != NULL && expr != NULL);
+  if (machine->aborted)
+    return SKN_PORT(SKN_ERA, 0);
+
+  // an argument is one level deeper than the application it is given in
+  SKN_Worker* worker = &machine->workers[0];
+  switch (expr->type) {
+    case EXPR_APP: {
+      uint32_t node   = _skn_node(worker, SKN_CON, level),
+               result = _skn_var(worker);
+      SKN_Port fun    = _skn_compile(machine, expr->fields.app.left, level),
+               arg    = _skn_compile(machine, expr->fields.app.right, level + 1);
+      machine->nodes[node].ports[0] = arg;
+      machine->nodes[node].ports[1] = SKN_PORT(SKN_VAR, result);
+      _skn_link(worker, fun, SKN_PORT(SKN_CON, node));
+      return SKN_PORT(SKN_VAR, result);
+    }
+    case EXPR_ABS: {
+      uint32_t node = _skn_node(worker, SKN_CON, level);
+      if (machine->s_binders == machine->c_binders) {
+        machine->c_binders = machine->c_binders > 0 ? 2 * machine->c_binders : 1 << 6;
+        machine->binders = (SKN_Uses*)realloc(machine->binders, machine->c_binders * sizeof(SKN_Uses));
+        assert(machine->binders != NULL);
+      }
+      SKN_Uses* binder = &machine->binders[machine->s_binders];
+      *binder = (SKN_Uses){ .ports = NULL, .s_ports = machine->counts[machine->next_count++], .next = 0, .level = level };
+      SKN_Port var = _skn_share(machine, binder);
+
+      machine->s_binders++;
+      SKN_Port body = _skn_compile(machine, expr->fields.abs.expr, level);
+      machine->s_binders--;
+      machine->nodes[node].ports[0] = var;
+      machine->nodes[node].ports[1] = body;
+      return SKN_PORT(SKN_CON, node);
+    }
+    case EXPR_IDENT: {
+      if (expr->index != AST_UNBOUND) {
+        assert(expr->index < machine->s_binders);
+        SKN_Uses* binder = &machine->binders[machine->s_binders - 1 - expr->index];
+        assert(binder->next < binder->s_ports);
+        return _skn_use(machine, binder->ports[binder->next++], binder->level, level);
+      }
+
+      ASTN_Stmt* stmt = expr->fields.ident.stmt;
+      if (stmt != NULL && stmt->sk_expr != NULL) {
+        SKN_Uses* uses = (SKN_Uses*)_sk_index_get_ptr(&machine->globals, stmt);
+        assert(uses != NULL && uses->next < uses->s_ports);
+        return _skn_use(machine, uses->ports[uses->next++], 0, level);
+      }
+      // a free name, or a definition that comes later, which was reported
+      return _skn_name(machine, expr->fields.ident.var);
+    }
+  }
+
+  return SKN_PORT(SKN_ERA, 0);
+}
+
+SKN_Port _skn_tree(SKN_Machine* machine, SK_Tree* tree, uint32_t level) {
+  assert(machine != NULL && tree != NULL);
+  if (machine->aborted)
+    return SKN_PORT(SKN_ERA, 0);
+
+  // a shared subtree is compiled once per use, the trees of linked definitions are small
+  switch (tree->type) {
+    case APP_NODE: {
+      SKN_Worker* worker = &machine->workers[0];
+      uint32_t node   = _skn_node(worker, SKN_CON, level),
+               result = _skn_var(worker);
+      SKN_Port fun    = _skn_tree(machine, tree->left, level),
+               arg    = _skn_tree(machine, tree->right, level + 1);
+      machine->nodes[node].ports[0] = arg;
+      machine->nodes[node].ports[1] = SKN_PORT(SKN_VAR, result);
+      _skn_link(worker, fun, SKN_PORT(SKN_CON, node));
+      return SKN_PORT(SKN_VAR, result);
+    }
+    case REF_NODE: {
+      return _skn_tree(machine, tree->left, level);
+    }
+    case LD_NODE: {
+      return _skn_name(machine, tree->ld_ident);
+    }
+    case S_NODE: {
+      return _skn_term(machine, machine->combinators[0], level);
+    }
+    case K_NODE: {
+      return _skn_term(machine, machine->combinators[1], level);
+    }
+  }
+
+  return SKN_PORT(SKN_ERA, 0);
+}
+
+SKN_Port _skn_share(SKN_Machine* machine, SKN_Uses* uses) {
+  assert(machine != NULL && uses != NULL);
+
+  SKN_Worker* worker = &machine->workers[0];
+  uint32_t s_ports = uses->s_ports;
+  uses->next = 0;
+  if (s_ports == 0)
+    return SKN_PORT(SKN_ERA, 0);
+
+  uses->ports = (SKN_Port*)arena_alloc(machine->arena, s_ports * sizeof(SKN_Port));
+  assert(uses->ports != NULL);
+
+  // a chain of duplicators, one per use but the last, at the level of the binder
+  SKN_Port top = SKN_NONE, *last = &top;
+  for (uint32_t i = 0; i + 1 < s_ports && !machine->aborted; i++) {
+    uint32_t node = _skn_node(worker, SKN_DUP, uses->level),
+             var  = _skn_var(worker);
+    *last = SKN_PORT(SKN_DUP, node);
+    machine->nodes[node].ports[0] = uses->ports[i] = SKN_PORT(SKN_VAR, var);
+    last = &machine->nodes[node].ports[1];
+  }
+  uint32_t var = _skn_var(worker);
+  *last = uses->ports[s_ports - 1] = SKN_PORT(SKN_VAR, var);
+  return top;
+}
+
+SKN_Port _skn_use(SKN_Machine* machine, SKN_Port port, uint32_t bound, uint32_t level) {
+  assert(machine != NULL && bound <= level);
+
+  // a use of a binder at a lower level goes through a bracket for every level in between, the
+  // croissant at the end opens the value the binder takes
+  SKN_Worker* worker = &machine->workers[0];
+  for (uint32_t i = bound; i <= level && !machine->aborted; i++) {
+    uint32_t node = _skn_node(worker, i < level ? SKN_BRACKET : SKN_CROISSANT, i),
+             var  = _skn_var(worker);
+    machine->nodes[node].ports[0] = SKN_PORT(SKN_VAR, var);
+    machine->nodes[node].ports[1] = SKN_NONE;
+    _skn_link(worker, port, SKN_PORT(SKN_DUP, node));
+    port = SKN_PORT(SKN_VAR, var);
+  }
+  return port;
+}
+
+SKN_Port _skn_name(SKN_Machine* machine, ASTN_Ident* ident) {
+  assert(machine != NULL && ident != NULL);
+
+  if (machine->s_names == machine->c_names) {
+    machine->c_names = machine->c_names > 0 ? 2 * machine->c_names : 1 << 6;
+    machine->names = (ASTN_Ident**)realloc(machine->names, machine->c_names * sizeof(ASTN_Ident*));
+    assert(machine->names != NULL);
+  }
+  machine->names[machine->s_names] = ident;
+
+  uint32_t node = _skn_node(&machine->workers[0], SKN_NAM, machine->s_names++);
+  machine->nodes[node].ports[0] = machine->nodes[node].ports[1] = SKN_NONE;
+  return SKN_PORT(SKN_NAM, node);
+}
+
+ASTN_Expr* _skn_ast(Arena arena, uint32_t type, ASTN_Expr* left, ASTN_Expr* right, uint32_t index) {
+  ASTN_Expr* expr = (ASTN_Expr*)arena_alloc(arena, sizeof(struct astn_expr));
+  assert(expr != NULL);
+  memset(expr, 0, sizeof(struct astn_expr));
+  expr->type  = type;
+  expr->index = type == EXPR_IDENT ? index : AST_UNBOUND;
+  if (type == EXPR_APP) {
+    expr->fields.app.left  = left;
+    expr->fields.app.right = right;
+  } else if (type == EXPR_ABS) {
+    expr->fields.abs.expr = left;
+  }
+  return expr;
+}
+
+bool _skn_reduce(SKN_Machine* machine) {
+  assert(machine != NULL);
+
+  // this thread starts alone, _skn_run starts the others once the net turns out to be worth it
+  machine->s_active  = 1;
+  machine->s_started = 1;
+  (void)_skn_run(&machine->workers[0]);
+  for (uint32_t i = 1; i < machine->s_started; i++)
+    pthread_join(machine->workers[i].thread, NULL);
+
+  for (uint32_t i = 0; i < machine->s_workers; i++) {
+    machine->s_steps += machine->workers[i].s_steps;
+    machine->workers[i].s_steps = 0;
+  }
+  return !machine->aborted;
+}
+
+void* _skn_run(void* arg) {
+  SKN_Worker*  worker  = (SKN_Worker*)arg;
+  SKN_Machine* machine = worker->machine;
+  bool alone = worker == &machine->workers[0] && machine->s_workers > 1;
+
+  // a thread is active while it has redexes of its own, it is counted before it starts
+  do {
+    while (worker->s_redexes > 0 && !__atomic_load_n(&machine->aborted, __ATOMIC_RELAXED)) {
+      SKN_Redex redex = worker->redexes[--worker->s_redexes];
+      _skn_interact(worker, redex.a, redex.b);
+
+      if (++worker->s_steps == SKN_FLUSH) {
+        uint64_t s_steps = __atomic_add_fetch(&machine->s_steps, SKN_FLUSH, __ATOMIC_RELAXED);
+        worker->s_steps = 0;
+        if (s_steps > SKN_MAX_STEPS)
+          __atomic_store_n(&machine->aborted, true, __ATOMIC_RELAXED);
+        else if (alone && s_steps >= SKN_PARALLEL) {
+          _skn_start(machine);
+          alone = false;
+        }
+      }
+      if (worker->s_redexes > SKN_SHARE && __atomic_load_n(&worker->s_shared, __ATOMIC_RELAXED) == 0 &&
+          __atomic_load_n(&machine->s_active, __ATOMIC_RELAXED) < __atomic_load_n(&machine->s_started, __ATOMIC_RELAXED))
+        _skn_give(worker);
+    }
+    (void)__atomic_sub_fetch(&machine->s_active, 1, __ATOMIC_SEQ_CST);
+  } while (_skn_wait(worker));
+
+  return NULL;
+}
+
+void _skn_start(SKN_Machine* machine) {
+  assert(machine != NULL);
+
+  // a thread that could not be started is not tried again for this net, the others do its share
+  for (uint32_t i = machine->s_started; i < machine->s_workers; i++) {
+    (void)__atomic_add_fetch(&machine->s_active, 1, __ATOMIC_SEQ_CST);
+    if (pthread_create(&machine->workers[i].thread, NULL, _skn_run, &machine->workers[i]) != 0) {
+      (void)__atomic_sub_fetch(&machine->s_active, 1, __ATOMIC_SEQ_CST);
+      break;
+    }
+    __atomic_store_n(&machine->s_started, i + 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+bool _skn_wait(SKN_Worker* worker) {
+  assert(worker != NULL);
+
+  // done once no thread is active and nothing is left to steal, in that order: a thread only
+  // hands redexes out while it is active, so none can appear after both were seen
+  SKN_Machine* machine = worker->machine;
+  for (;;) {
+    if (__atomic_load_n(&machine->aborted, __ATOMIC_RELAXED))
+      return false;
+    if (_skn_any_shared(machine)) {
+      (void)__atomic_add_fetch(&machine->s_active, 1, __ATOMIC_SEQ_CST);
+      if (_skn_steal(worker))
+        return true;
+      (void)__atomic_sub_fetch(&machine->s_active, 1, __ATOMIC_SEQ_CST);
+    } else if (__atomic_load_n(&machine->s_active, __ATOMIC_SEQ_CST) == 0 && !_skn_any_shared(machine)) {
+      return false;
+    }
+    sched_yield();
+  }
+}
+
+bool _skn_any_shared(SKN_Machine* machine) {
+  for (uint32_t i = 0; i < machine->s_workers; i++)
+    if (__atomic_load_n(&machine->workers[i].s_shared, __ATOMIC_SEQ_CST) > 0)
+      return true;
+  return false;
+}
+
+void _skn_give(SKN_Worker* worker) {
+  assert(worker != NULL);
+
+  // the oldest half, at the bottom of the stack, are the redexes furthest from what this thread
+  // is working on
+  size_t s_given = worker->s_redexes / 2;
+  pthread_mutex_lock(&worker->lock);
+  if (worker->s_shared + s_given > worker->c_shared) {
+    worker->c_shared = 2 * (worker->s_shared + s_given);
+    worker->shared = (SKN_Redex*)realloc(worker->shared, worker->c_shared * sizeof(SKN_Redex));
+    assert(worker->shared != NULL);
+  }
+  memcpy(worker->shared + worker->s_shared, worker->redexes, s_given * sizeof(SKN_Redex));
+  __atomic_store_n(&worker->s_shared, worker->s_shared + s_given, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&worker->lock);
+
+  worker->s_redexes -= s_given;
+  memmove(worker->redexes, worker->redexes + s_given, worker->s_redexes * sizeof(SKN_Redex));
+}
+
+bool _skn_steal(SKN_Worker* worker) {
+  assert(worker != NULL);
+
+  SKN_Machine* machine = worker->machine;
+  uint32_t self = (uint32_t)(worker - machine->workers);
+  for (uint32_t i = 0; i < machine->s_workers; i++) {
+    SKN_Worker* victim = &machine->workers[(self + i) % machine->s_workers];
+    if (__atomic_load_n(&victim->s_shared, __ATOMIC_SEQ_CST) == 0)
+      continue;
+
+    pthread_mutex_lock(&victim->lock);
+    size_t s_taken = (victim->s_shared + 1) / 2;
+    if (worker->s_redexes + s_taken > worker->c_redexes) {
+      worker->c_redexes = 2 * (worker->s_redexes + s_taken);
+      worker->redexes = (SKN_Redex*)realloc(worker->redexes, worker->c_redexes * sizeof(SKN_Redex));
+      assert(worker->redexes != NULL);
+    }
+    memcpy(worker->redexes + worker->s_redexes, victim->shared + victim->s_shared - s_taken, s_taken * sizeof(SKN_Redex));
+    worker->s_redexes += s_taken;
+    __atomic_store_n(&victim->s_shared, victim->s_shared - s_taken, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&victim->lock);
+    if (s_taken > 0)
+      return true;
+  }
+  return false;
+}
+
+void _skn_interact(SKN_Worker* worker, SKN_Port a, SKN_Port b) {
+  assert(worker != NULL);
+
+  // ordered by tag, so that each pair of kinds has one case
+  if (SKN_TAG(a) > SKN_TAG(b)) {
+    SKN_Port t = a;
+    a = b;
+    b = t;
+  }
+  // an eraser has no node, b only is one when a is too, which is never pushed
+  SKN_Machine* machine = worker->machine;
+  SKN_Node*    y = &machine->nodes[SKN_INDEX(b)];
+
+  switch (SKN_TAG(a)) {
+    case SKN_ERA: {
+      if (SKN_TAG(b) == SKN_CON || SKN_TAG(b) == SKN_DUP) {
+        SKN_Port y0 = y->ports[0], y1 = y->ports[1];
+        uint32_t s_aux = _skn_arity(y->kind);
+        _skn_free_node(worker, SKN_INDEX(b));
+        _skn_link(worker, y0, SKN_PORT(SKN_ERA, 0));
+        if (s_aux > 1)
+          _skn_link(worker, y1, SKN_PORT(SKN_ERA, 0));
+      } else if (SKN_TAG(b) == SKN_NAM) {
+        _skn_free_node(worker, SKN_INDEX(b));
+      }
+      break;
+    }
+    case SKN_CON:
+    case SKN_DUP: {
+      SKN_Node* x  = &machine->nodes[SKN_INDEX(a)];
+      SKN_Port  x0 = x->ports[0], x1 = x->ports[1];
+      if (SKN_TAG(b) == SKN_NAM && SKN_TAG(a) == SKN_CON) {
+        // an application of a free name is stuck, the name keeps it for the read back
+        y->ports[0] = a;
+      } else if (SKN_TAG(b) == SKN_NAM && x->kind == SKN_DUP) {
+        uint32_t copy = _skn_node(worker, SKN_NAM, y->label);
+        machine->nodes[copy].ports[0] = machine->nodes[copy].ports[1] = SKN_NONE;
+        _skn_free_node(worker, SKN_INDEX(a));
+        _skn_link(worker, x0, b);
+        _skn_link(worker, x1, SKN_PORT(SKN_NAM, copy));
+      } else if (SKN_TAG(b) == SKN_NAM) {
+        // a name is the same at every level
+        _skn_free_node(worker, SKN_INDEX(a));
+        _skn_link(worker, x0, b);
+      } else if (SKN_TAG(b) == SKN_CON || (x->kind == y->kind && x->label == y->label)) {
+        // a lambda meeting its application, or control nodes that pair up
+        SKN_Port y0 = y->ports[0], y1 = y->ports[1];
+        uint32_t s_aux = _skn_arity(x->kind);
+        _skn_free_node(worker, SKN_INDEX(a));
+        _skn_free_node(worker, SKN_INDEX(b));
+        _skn_link(worker, x0, y0);
+        if (s_aux > 1)
+          _skn_link(worker, x1, y1);
+      } else if (SKN_TAG(a) == SKN_DUP && x->label < y->label) {
+        _skn_commute(worker, a, b);
+      } else if (y->label < x->label) {
+        _skn_commute(worker, b, a);
+      } else {
+        // a control node can only meet a lambda or an application above its level, and one of
+        // another kind at a level of its own, in a net that is not the translation of a term
+        __atomic_store_n(&machine->aborted, true, __ATOMIC_RELAXED);
+      }
+      break;
+    }
+  }
+}
+
+void _skn_commute(SKN_Worker* worker, SKN_Port a, SKN_Port b) {
+  assert(worker != NULL);
+
+  // a is the control node of the lower level and b passes through it, one level down through a
+  // croissant and one up through a bracket. Each node is copied to the aux ports of the other,
+  // the copies wired crosswise: aux j of the copy of a at aux i of b meets aux i of the copy of b
+  // at aux j of a
+  SKN_Machine* machine = worker->machine;
+  SKN_Node x = machine->nodes[SKN_INDEX(a)],
+           y = machine->nodes[SKN_INDEX(b)];
+  uint32_t s_x   = _skn_arity(x.kind), s_y = _skn_arity(y.kind),
+           label = y.label + (x.kind == SKN_BRACKET) - (x.kind == SKN_CROISSANT),
+           xs[2] = { SKN_INDEX(a), s_y > 1 ? _skn_node(worker, x.kind, x.label) : 0 },
+           ys[2] = { SKN_INDEX(b), s_x > 1 ? _skn_node(worker, y.kind, label) : 0 };
+  machine->nodes[ys[0]].label = label;
+
+  for (uint32_t i = 0; i < s_x; i++) {
+    for (uint32_t j = 0; j < s_y; j++) {
+      uint32_t w = _skn_var(worker);
+      machine->nodes[xs[j]].ports[i] = machine->nodes[ys[i]].ports[j] = SKN_PORT(SKN_VAR, w);
+    }
+    if (s_y == 1)
+      machine->nodes[ys[i]].ports[1] = SKN_NONE;
+  }
+  for (uint32_t j = 0; j < s_y && s_x == 1; j++)
+    machine->nodes[xs[j]].ports[1] = SKN_NONE;
+
+  for (uint32_t i = 0; i < s_x; i++)
+    _skn_link(worker, x.ports[i], SKN_PORT(SKN_TAG(b), ys[i]));
+  for (uint32_t j = 0; j < s_y; j++)
+    _skn_link(worker, y.ports[j], SKN_PORT(SKN_TAG(a), xs[j]));
+}
+
+uint32_t _skn_arity(uint32_t kind) {
+  return kind == SKN_CROISSANT || kind == SKN_BRACKET ? 1 : 2;
+}
+
+void _skn_link(SKN_Worker* worker, SKN_Port a, SKN_Port b) {
+  assert(worker != NULL);
+
+  SKN_Machine* machine = worker->machine;
+  for (;;) {
+    if (SKN_TAG(a) != SKN_VAR) {
+      SKN_Port t = a;
+      a = b;
+      b = t;
+    }
+    // two principal ports make a redex
+    if (SKN_TAG(a) != SKN_VAR) {
+      _skn_push(worker, a, b);
+      return;
+    }
+    // the end a of the wire now leads to b: the first of its two ends to get here leaves b in the
+    // cell and is done, the second takes what the first left and links it to b instead
+    SKN_Port other = __atomic_exchange_n(&machine->vars[SKN_INDEX(a)], b, __ATOMIC_ACQ_REL);
+    if (other == SKN_NONE)
+      return;
+    _skn_free_var(worker, SKN_INDEX(a));
+    a = other;
+  }
+}
+
+void _skn_push(SKN_Worker* worker, SKN_Port a, SKN_Port b) {
+  assert(worker != NULL);
+  if (SKN_TAG(a) == SKN_ERA && SKN_TAG(b) == SKN_ERA)
+    return;
+
+  if (worker->s_redexes == worker->c_redexes) {
+    worker->c_redexes = worker->c_redexes > 0 ? 2 * worker->c_redexes : 1 << 10;
+    worker->redexes = (SKN_Redex*)realloc(worker->redexes, worker->c_redexes * sizeof(SKN_Redex));
+    assert(worker->redexes != NULL);
+  }
+  worker->redexes[worker->s_redexes++] = (SKN_Redex){ .a = a, .b = b };
+}
+
+uint32_t _skn_node(SKN_Worker* worker, uint32_t kind, uint32_t label) {
+  assert(worker != NULL);
+
+  SKN_Machine* machine = worker->machine;
+  uint32_t node;
+  if (worker->free_nodes.s_items > 0) {
+    node = worker->free_nodes.items[--worker->free_nodes.s_items];
+  } else {
+    if (worker->next_node == worker->end_node) {
+      uint32_t start = __atomic_fetch_add(&machine->s_nodes, SKN_CHUNK, __ATOMIC_RELAXED);
+      if (start >= SKN_MAX_NODES)
+        __atomic_store_n(&machine->aborted, true, __ATOMIC_RELAXED);
+      // the read back walks every node taken, those never handed out must not look alive
+      for (uint32_t i = 0; i < SKN_CHUNK; i++)
+        machine->nodes[start + i].kind = SKN_FREED;
+      worker->next_node = start;
+      worker->end_node  = start + SKN_CHUNK;
+    }
+    node = worker->next_node++;
+  }
+  machine->nodes[node].kind  = kind;
+  machine->nodes[node].label = label;
+  return node;
+}
+
+uint32_t _skn_var(SKN_Worker* worker) {
+  assert(worker != NULL);
+
+  SKN_Machine* machine = worker->machine;
+  uint32_t var;
+  if (worker->free_vars.s_items > 0) {
+    var = worker->free_vars.items[--worker->free_vars.s_items];
+  } else {
+    if (worker->next_var == worker->end_var) {
+      uint32_t start = __atomic_fetch_add(&machine->s_vars, SKN_CHUNK, __ATOMIC_RELAXED);
+      if (start >= SKN_MAX_NODES)
+        __atomic_store_n(&machine->aborted, true, __ATOMIC_RELAXED);
+      for (uint32_t i = 0; i < SKN_CHUNK; i++)
+        machine->vars[start + i] = SKN_FREED;
+      worker->next_var = start;
+      worker->end_var  = start + SKN_CHUNK;
+    }
+    var = worker->next_var++;
+  }
+  machine->vars[var] = SKN_NONE;
+  return var;
+}
+
+void _skn_free_node(SKN_Worker* worker, uint32_t node) {
+  // only the redex pointed to a node it consumes, so this thread is the only one to see it again
+  worker->machine->nodes[node].kind = SKN_FREED;
+  _skn_indices_push(&worker->free_nodes, node);
+}
+
+void _skn_free_var(SKN_Worker* worker, uint32_t var) {
+  __atomic_store_n(&worker->machine->vars[var], SKN_FREED, __ATOMIC_RELAXED);
+  _skn_indices_push(&worker->free_vars, var);
+}
+
+SK_Tree* _skn_read_back(SKN_Machine* machine) {
+  assert(machine != NULL);
+
+  // the net only keeps pointers from a port to what it leads to, the read back also needs who
+  // points to a node and where the other end of a wire is, so they are indexed first
+  size_t s_nodes = machine->s_nodes, s_vars = machine->s_vars;
+  machine->owners  = (SKN_Loc*)malloc((2 * s_vars + 1) * sizeof(SKN_Loc));
+  machine->holders = (SKN_Loc*)malloc((s_nodes + 1) * sizeof(SKN_Loc));
+  machine->bound   = (SKN_Binding**)calloc(s_nodes + 1, sizeof(SKN_Binding*));
+  assert(machine->owners != NULL && machine->holders != NULL && machine->bound != NULL);
+  for (size_t i = 0; i < 2 * s_vars; i++)
+    machine->owners[i] = SKN_NOWHERE;
+  for (size_t i = 0; i < s_nodes; i++)
+    machine->holders[i] = SKN_NOWHERE;
+
+  for (size_t i = 0; i < s_nodes; i++) {
+    SKN_Node* node = &machine->nodes[i];
+    if (node->kind == SKN_FREED)
+      continue;
+    _skn_register(machine, node->ports[0], SKN_SLOT(i, 0));
+    if (node->kind == SKN_CON || node->kind == SKN_DUP)
+      _skn_register(machine, node->ports[1], SKN_SLOT(i, 1));
+  }
+  for (size_t i = 0; i < s_vars; i++)
+    if (machine->vars[i] != SKN_NONE && machine->vars[i] != SKN_FREED)
+      _skn_register(machine, machine->vars[i], SKN_CELL(i));
+
+  machine->s_read  = 0;
+  machine->s_depth = 0;
+  SK_Tree* root = _skn_read_port(machine, machine->nodes[machine->root].ports[0], SKN_SLOT(machine->root, 0), NULL);
+
+  free(machine->bound);
+  free(machine->holders);
+  free(machine->owners);
+  return root;
+}
+
+void _skn_register(SKN_Machine* machine, SKN_Port port, SKN_Loc loc) {
+  switch (SKN_TAG(port)) {
+    case SKN_VAR: {
+      SKN_Loc* ends = &machine->owners[2 * (size_t)SKN_INDEX(port)];
+      ends[ends[0] != SKN_NOWHERE] = loc;
+      break;
+    }
+    case SKN_CON:
+    case SKN_DUP:
+    case SKN_NAM: {
+      machine->holders[SKN_INDEX(port)] = loc;
+      break;
+    }
+  }
+}
+
+SKN_Loc _skn_other_end(SKN_Machine* machine, uint32_t var, SKN_Loc loc) {
+  SKN_Loc* ends = &machine->owners[2 * (size_t)var];
+  return ends[0] == loc ? ends[1] : ends[0];
+}
+
+SK_Tree* _skn_read_port(SKN_Machine* machine, SKN_Port port, SKN_Loc from, const SKN_Context* context) {
+  assert(machine != NULL);
+  if (++machine->s_read > SKN_MAX_STEPS || machine->s_depth == SKN_MAX_DEPTH)
+    return NULL;
+
+  // port is written at from and leads to what gives its value
+  SK_Tree* tree = NULL;
+  machine->s_depth++;
+  switch (SKN_TAG(port)) {
+    case SKN_VAR: {
+      uint32_t var = SKN_INDEX(port);
+      SKN_Port cell = machine->vars[var];
+      if (cell == SKN_FREED)
+        break;
+      tree = cell != SKN_NONE ? _skn_read_port(machine, cell, SKN_CELL(var), context) : _skn_read_loc(machine, _skn_other_end(machine, var, from), context);
+      break;
+    }
+    case SKN_CON: {
+      // a lambda, its body is read with a name of its own for every time it is reached
+      uint32_t     node    = SKN_INDEX(port);
+      ASTN_Ident*  var     = _sk_back_var(machine->arena);
+      SKN_Binding* binding = (SKN_Binding*)arena_alloc(machine->arena, sizeof(struct skn_binding));
+      assert(binding != NULL);
+      *binding = (SKN_Binding){ .var = var, .context = context, .next = machine->bound[node] };
+
+      machine->bound[node] = binding;
+      SK_Tree* body = _skn_read_port(machine, machine->nodes[node].ports[1], SKN_SLOT(node, 1), context);
+      machine->bound[node] = (SKN_Binding*)binding->next;
+      if (body != NULL)
+        tree = _sk_back_abstract(machine->arena, body, var);
+      break;
+    }
+    case SKN_DUP: {
+      // a control node that gives a value the other way round undoes what it did to the context:
+      // the copy of a duplicator is the one on top of its level, a croissant takes its level away
+      // and a bracket splits the pair at its level in two
+      uint32_t         node  = SKN_INDEX(port), label = machine->nodes[node].label, i = 0;
+      const SKN_Stack* stack = _skn_context_get(context, label);
+      switch (machine->nodes[node].kind) {
+        case SKN_DUP: {
+          if (stack == NULL || stack->item > SKN_COPY1)
+            break;
+          i = stack->item;
+          context = _skn_context_set(machine, context, label, stack->next);
+          tree = _skn_read_port(machine, machine->nodes[node].ports[i], SKN_SLOT(node, i), context);
+          break;
+        }
+        case SKN_CROISSANT: {
+          if (stack == NULL || stack->item != SKN_STAR || stack->next != NULL)
+            break;
+          context = _skn_context_remove(machine, context, label);
+          tree = _skn_read_port(machine, machine->nodes[node].ports[0], SKN_SLOT(node, 0), context);
+          break;
+        }
+        case SKN_BRACKET: {
+          if (stack == NULL || stack->item != SKN_PAIR || stack->next != NULL)
+            break;
+          context = _skn_context_set(machine, context, label, stack->pair[0]);
+          context = _skn_context_insert(machine, context, label + 1, stack->pair[1]);
+          tree = _skn_read_port(machine, machine->nodes[node].ports[0], SKN_SLOT(node, 0), context);
+          break;
+        }
+      }
+      break;
+    }
+    case SKN_NAM: {
+      tree = _skt_node(machine->arena, LD_NODE, NULL, NULL, machine->names[machine->nodes[SKN_INDEX(port)].label]);
+      break;
+    }
+  }
+  machine->s_depth--;
+  return tree;
+}
+
+SK_Tree* _skn_read_loc(SKN_Machine* machine, SKN_Loc loc, const SKN_Context* context) {
+  assert(machine != NULL);
+  if (loc == SKN_NOWHERE || ++machine->s_read > SKN_MAX_STEPS || machine->s_depth == SKN_MAX_DEPTH)
+    return NULL;
+
+  // loc is where a wire ends on the side that gives the value
+  SK_Tree* tree = NULL;
+  machine->s_depth++;
+  if ((loc & 3) == 2) {
+    // the wire was linked on to this cell, the value comes from its own remaining end
+    SKN_Loc* ends = &machine->owners[2 * (loc >> 2)];
+    if (ends[1] == SKN_NOWHERE)
+      tree = _skn_read_loc(machine, ends[0], context);
+  } else {
+    uint32_t  node = (uint32_t)(loc >> 2), slot = (uint32_t)(loc & 3);
+    SKN_Node* n    = &machine->nodes[node];
+    switch (n->kind) {
+      case SKN_CON: {
+        if (slot == 0) {
+          tree = _skn_read_var(machine, node, context);
+        } else {
+          SK_Tree* fun = _skn_read_holder(machine, node, context),
+                 * arg = fun != NULL ? _skn_read_port(machine, n->ports[0], SKN_SLOT(node, 0), context) : NULL;
+          if (arg != NULL)
+            tree = _skt_node(machine->arena, APP_NODE, fun, arg, NULL);
+        }
+        break;
+      }
+      case SKN_DUP: {
+        // copy slot of what the duplicator takes
+        const SKN_Stack* stack = _skn_context_get(context, n->label);
+        context = _skn_context_set(machine, context, n->label, _skn_stack_push(machine, slot, NULL, NULL, stack));
+        tree = _skn_read_holder(machine, node, context);
+        break;
+      }
+      case SKN_CROISSANT: {
+        const SKN_Stack* star = _skn_stack_push(machine, SKN_STAR, NULL, NULL, NULL);
+        tree = _skn_read_holder(machine, node, _skn_context_insert(machine, context, n->label, star));
+        break;
+      }
+      case SKN_BRACKET: {
+        const SKN_Stack* pair = _skn_stack_push(
+          machine, SKN_PAIR, _skn_context_get(context, n->label), _skn_context_get(context, n->label + 1), NULL
+        );
+        context = _skn_context_remove(machine, context, n->label + 1);
+        tree = _skn_read_holder(machine, node, _skn_context_set(machine, context, n->label, pair));
+        break;
+      }
+      case SKN_NAM: {
+        tree = _skt_node(machine->arena, LD_NODE, NULL, NULL, machine->names[n->label]);
+        break;
+      }
+    }
+  }
+  machine->s_depth--;
+  return tree;
+}
+
+SK_Tree* _skn_read_holder(SKN_Machine* machine, uint32_t node, const SKN_Context* context) {
+  assert(machine != NULL);
+  // what the principal port of node leads to gives the value it takes
+  return _skn_read_loc(machine, machine->holders[node], context);
+}
+
+SK_Tree* _skn_read_var(SKN_Machine* machine, uint32_t node, const SKN_Context* context) {
+  assert(machine != NULL);
+
+  // the variable of a lambda, only while its body is being read. A body shared between copies of
+  // the lambda is read once per copy, the one this path belongs to agrees with it on every level
+  // below that of the lambda
+  for (const SKN_Binding* binding = machine->bound[node]; binding != NULL; binding = binding->next)
+    if (_skn_context_agrees(binding->context, context, machine->nodes[node].label))
+      return _skt_node(machine->arena, LD_NODE, NULL, NULL, binding->var);
+  return NULL;
+}
+
+const SKN_Stack* _skn_stack_push(SKN_Machine* machine, uint32_t item, const SKN_Stack* a, const SKN_Stack* b, const SKN_Stack* next) {
+  SKN_Stack* stack = (SKN_Stack*)arena_alloc(machine->arena, sizeof(struct skn_stack));
+  assert(stack != NULL);
+  *stack = (SKN_Stack){ .item = item, .pair = { a, b }, .next = next };
+  return stack;
+}
+
+bool _skn_stack_equal(const SKN_Stack* a, const SKN_Stack* b) {
+  for (; a != NULL && b != NULL; a = a->next, b = b->next) {
+    if (a == b)
+      return true;
+    if (a->item != b->item)
+      return false;
+    if (a->item == SKN_PAIR && !(_skn_stack_equal(a->pair[0], b->pair[0]) && _skn_stack_equal(a->pair[1], b->pair[1])))
+      return false;
+  }
+  return a == b;
+}
+
+const SKN_Stack* _skn_context_get(const SKN_Context* context, uint32_t level) {
+  for (; context != NULL && level > 0; level--)
+    context = context->next;
+  return context != NULL ? context->level : NULL;
+}
+
+const SKN_Context* _skn_context_set(SKN_Machine* machine, const SKN_Context* context, uint32_t level, const SKN_Stack* stack) {
+  // the levels up to the one changed are copied, the rest is shared
+  SKN_Context* copy = (SKN_Context*)arena_alloc(machine->arena, sizeof(struct skn_context));
+  assert(copy != NULL);
+  if (level == 0)
+    *copy = (SKN_Context){ .level = stack, .next = context != NULL ? context->next : NULL };
+  else
+    *copy = (SKN_Context){
+      .level = context != NULL ? context->level : NULL,
+      .next  = _skn_context_set(machine, context != NULL ? context->next : NULL, level - 1, stack)
+    };
+  return copy;
+}
+
+const SKN_Context* _skn_context_insert(SKN_Machine* machine, const SKN_Context* context, uint32_t level, const SKN_Stack* stack) {
+  SKN_Context* copy = (SKN_Context*)arena_alloc(machine->arena, sizeof(struct skn_context));
+  assert(copy != NULL);
+  if (level == 0)
+    *copy = (SKN_Context){ .level = stack, .next = context };
+  else
+    *copy = (SKN_Context){
+      .level = context != NULL ? context->level : NULL,
+      .next  = _skn_context_insert(machine, context != NULL ? context->next : NULL, level - 1, stack)
+    };
+  return copy;
+}
+
+const SKN_Context* _skn_context_remove(SKN_Machine* machine, const SKN_Context* context, uint32_t level) {
+  if (context == NULL)
+    return NULL;
+  if (level == 0)
+    return context->next;
+  SKN_Context* copy = (SKN_Context*)arena_alloc(machine->arena, sizeof(struct skn_context));
+  assert(copy != NULL);
+  *copy = (SKN_Context){ .level = context->level, .next = _skn_context_remove(machine, context->next, level - 1) };
+  return copy;
+}
+
+bool _skn_context_agrees(const SKN_Context* a, const SKN_Context* b, uint32_t s_levels) {
+  for (uint32_t i = 0; i < s_levels; i++) {
+    if (!_skn_stack_equal(a != NULL ? a->level : NULL, b != NULL ? b->level : NULL))
+      return false;
+    a = a != NULL ? a->next : NULL;
+    b = b != NULL ? b->next : NULL;
+  }
+  return true;
+}
+
+void _skn_indices_push(SKN_Indices* indices, uint32_t index) {
+  assert(indices != NULL);
+
+  if (indices->s_items == indices->capacity) {
+    indices->capacity = indices->capacity > 0 ? 2 * indices->capacity : 1 << 10;
+    indices->items = (uint32_t*)realloc(indices->items, indices->capacity * sizeof(uint32_t));
+    assert(indices->items != NULL);
+  }
+  indices->items[indices->s_items++] = index;
+}
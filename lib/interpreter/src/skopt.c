@@ -0,0 +1,175 @@
+#include "skopt_priv.h"
+
+bool _sk_opt_enabled = true;
+__thread uint64_t _skt_rewrites[SK_OPT_RULES] = { 0 };
+
+// tried in this order at every application, the first one that matches is taken
+static const SK_OptRewrite _sk_opt_rewrites[SK_OPT_RULES] = {
+  _skt_opt_k_redex, _skt_opt_i_redex, _skt_opt_eta, _skt_opt_k_app, _skt_opt_i, _skt_opt_share
+};
+
+static const char* _sk_opt_rule_names[SK_OPT_RULES] = {
+  "K x y", "S K a x", "S (K x) (S K a)", "S (K x) (K y)", "S K a", "&(leaf)"
+};
+
+// ========================# PUBLIC #========================
+
+SK_Tree* skt_optimize(Arena arena, SK_Tree* root) {
+  assert(arena != NULL);
+  if (root == NULL)
+    return NULL;
+
+  // a rewrite can make its parent, or the application it built, match another rule
+  const char* tag = arena_tag(arena, TAG_SK_OPTIMIZE);
+  SKO_Pass pass = {
+    .arena   = arena,
+    .shares  = SK_INDEX_EMPTY,
+    .changed = true
+  };
+  while (pass.changed) {
+    pass.changed = false;
+    _sk_index_clear(&pass.shares);
+    root = _skt_opt_expr(&pass, root);
+  }
+
+  _sk_index_free(&pass.shares);
+  (void)arena_tag(arena, tag);
+  return root;
+}
+
+uint64_t skt_get_rewrites(SK_OptRule rule) {
+  assert(rule < SK_OPT_RULES);
+  return _skt_rewrites[rule];
+}
+
+const char* sk_opt_rule_name(SK_OptRule rule) {
+  assert(rule < SK_OPT_RULES);
+  return _sk_opt_rule_names[rule];
+}
+
+void sk_opt_enable(void) {
+  _sk_opt_enabled = true;
+}
+
+void sk_opt_disable(void) {
+  _sk_opt_enabled = false;
+}
+
+// ========================# PRIVATE #========================
+
+SK_Tree* _skt_opt_expr(SKO_Pass* pass, SK_Tree* expr) {
+  assert(pass != NULL && expr != NULL);
+
+  // a node outside the arena belongs to an earlier definition, reached through a share that
+  // skt_copy kept: it was rewritten when that definition was converted, and may be read only
+  if (!arena_contains(pass->arena, expr))
+    return expr;
+
+  // a named REF is another definition, rewritten when it was converted and not this pass's to touch
+  if (expr->type == REF_NODE) {
+    if (expr->left == NULL || expr->left->ld_ident != NULL)
+      return expr;
+    SK_Tree* share = (SK_Tree*)_sk_index_get_ptr(&pass->shares, expr->left);
+    if (share == NULL) {
+      share = _skt_opt_expr(pass, expr->left);
+      _sk_index_put_ptr(&pass->shares, expr->left, share);
+    }
+    expr->left = share;
+  } else if (expr->type == APP_NODE) {
+    expr->left  = _skt_opt_expr(pass, expr->left);
+    expr->right = _skt_opt_expr(pass, expr->right);
+  } else {
+    return expr;
+  }
+
+  for (uint32_t i = 0; i < SK_OPT_RULES && (expr->type == APP_NODE || expr->type == REF_NODE);) {
+    SK_Tree* rewritten = _sk_opt_rewrites[i](pass->arena, expr);
+    if (rewritten == NULL) {
+      i++;
+      continue;
+    }
+
+    _skt_rewrites[i]++;
+    if (_sk_stats != NULL)
+      _sk_stats->s_rewrites[i]++;
+    pass->changed = true;
+    expr = rewritten;
+    i = 0;
+  }
+  return expr;
+}
+
+SK_Tree* _skt_opt_k_redex(Arena arena, SK_Tree* expr) {
+  (void)arena;
+  if (!_skt_opt_is(expr, K_NODE, 2))
+    return NULL;
+  return expr->left->right;
+}
+
+SK_Tree* _skt_opt_i_redex(Arena arena, SK_Tree* expr) {
+  (void)arena;
+  if (!_skt_opt_is(expr, S_NODE, 3) || expr->left->left->right->type != K_NODE)
+    return NULL;
+  return expr->right;
+}
+
+SK_Tree* _skt_opt_eta(Arena arena, SK_Tree* expr) {
+  (void)arena;
+  if (!_skt_opt_is(expr, S_NODE, 2) || !_skt_opt_is(expr->left->right, K_NODE, 1))
+    return NULL;
+  SK_Tree* identity = expr->right;
+  if (!_skt_opt_is(identity, S_NODE, 2) || identity->left->right->type != K_NODE)
+    return NULL;
+  return expr->left->right->right;
+}
+
+SK_Tree* _skt_opt_k_app(Arena arena, SK_Tree* expr) {
+  if (
+       !_skt_opt_is(expr, S_NODE, 2)
+    || !_skt_opt_is(expr->left->right, K_NODE, 1)
+    || !_skt_opt_is(expr->right, K_NODE, 1)
+  )
+    return NULL;
+
+  SK_Tree* kx  = expr->left->right,
+         * ky  = expr->right,
+         * app = (SK_Tree*)arena_alloc(arena, sizeof(struct sk_tree));
+  assert(app != NULL);
+  *app = (SK_Tree){ .type = APP_NODE, .span = ky->span, .left = kx->right, .right = ky->right, .ld_ident = NULL };
+
+  expr->left  = kx->left;
+  expr->right = app;
+  return expr;
+}
+
+SK_Tree* _skt_opt_i(Arena arena, SK_Tree* expr) {
+  (void)arena;
+  if (
+       !_skt_opt_is(expr, S_NODE, 2) || expr->left->right->type != K_NODE
+    || expr->right->type == S_NODE || expr->right->type == K_NODE
+  )
+    return NULL;
+
+  // S K a never evaluates a, so it becomes S K K sharing the K leaf the way skt_read shares leaves
+  expr->right = expr->left->right;
+  return expr;
+}
+
+SK_Tree* _skt_opt_share(Arena arena, SK_Tree* expr) {
+  (void)arena;
+  if (expr->type != REF_NODE || expr->left->ld_ident != NULL)
+    return NULL;
+
+  // an application has to stay behind its REF, skt_beta_redu rewrites applications in place
+  return expr->left->type != APP_NODE ? expr->left : NULL;
+}
+
+bool _skt_opt_is(SK_Tree* expr, uint32_t type, uint32_t s_args) {
+  assert(expr != NULL);
+
+  // expr is a combinator of that type applied to exactly s_args arguments
+  for (; s_args > 0; s_args--, expr = expr->left)
+    if (expr->type != APP_NODE)
+      return false;
+  return expr->type == type;
+}
@@ -0,0 +1,191 @@
+#include "skprof_priv.h"
+
+SK_Profile* _sk_profile = NULL;
+
+// ========================# PUBLIC #========================
+
+bool sk_profile_enable(void) {
+  if (_sk_profile != NULL)
+    return true;
+
+  SK_Profile* profile = (SK_Profile*)calloc(1, sizeof(SK_Profile));
+  if (profile == NULL)
+    return false;
+
+  profile->c_spans = 1 << 10;
+  profile->spans   = (SK_Span*)malloc(profile->c_spans * sizeof(SK_Span));
+  profile->c_defs  = 1 << 6;
+  profile->defs    = (char**)malloc(profile->c_defs * sizeof(char*));
+  profile->c_costs = 1 << 10;
+  profile->costs   = (SK_Cost*)calloc(profile->c_costs, sizeof(SK_Cost));
+  assert(profile->spans != NULL && profile->defs != NULL && profile->costs != NULL);
+
+  profile->spans[profile->s_spans++] = (SK_Span){ .def = 0, .label = NULL };
+  profile->defs[profile->s_defs++]   = strdup("<toplevel>");
+  assert(profile->defs[0] != NULL);
+
+  _sk_profile = profile;
+  return true;
+}
+
+bool sk_profile_write(FILE* file, bool alloc) {
+  assert(file != NULL);
+  SK_Profile* profile = _sk_profile;
+  if (profile == NULL)
+    return false;
+
+  for (size_t i = 0; i < profile->c_costs; i++) {
+    SK_Cost* cost = &profile->costs[i];
+    uint64_t value = alloc ? cost->s_alloc : cost->s_steps;
+    if (cost->key == 0 || value == 0)
+      continue;
+
+    // keys are stored plus one so that an empty slot is a zero key
+    uint32_t def  = (uint32_t)((cost->key - 1) >> 32),
+             span = (uint32_t)(cost->key - 1);
+    SK_Span* source = &profile->spans[span];
+
+    _sk_profile_write_def(file, def);
+    fputc(';', file);
+    _sk_profile_write_def(file, source->def);
+    if (span == 0)
+      fprintf(file, ";<unknown> %zu\n", value);
+    else
+      fprintf(
+        file, ";%s@%u:%u-%u:%u %zu\n", source->label,
+        source->frow, source->fcol, source->erow, source->ecol, value
+      );
+  }
+  return true;
+}
+
+void sk_profile_disable(void) {
+  SK_Profile* profile = _sk_profile;
+  if (profile == NULL)
+    return;
+
+  _sk_profile = NULL;
+  for (size_t i = 0; i < profile->s_spans; i++)
+    free(profile->spans[i].label);
+  for (size_t i = 0; i < profile->s_defs; i++)
+    free(profile->defs[i]);
+  free(profile->spans);
+  free(profile->defs);
+  free(profile->costs);
+  free(profile);
+}
+
+// ========================# PRIVATE #========================
+
+void _sk_profile_enter_def(ASTN_Ident* var) {
+  SK_Profile* profile = _sk_profile;
+  assert(profile != NULL && var != NULL);
+
+  if (profile->s_defs == profile->c_defs) {
+    profile->c_defs *= 2;
+    profile->defs = (char**)realloc(profile->defs, profile->c_defs * sizeof(char*));
+    assert(profile->defs != NULL);
+  }
+  profile->defs[profile->s_defs] = strdup(var->token->str);
+  assert(profile->defs[profile->s_defs] != NULL);
+  profile->def = (uint32_t)profile->s_defs++;
+}
+
+uint32_t _sk_profile_span(ASTN_Expr* expr) {
+  SK_Profile* profile = _sk_profile;
+  assert(profile != NULL && expr != NULL);
+
+  if (profile->s_spans == profile->c_spans) {
+    profile->c_spans *= 2;
+    profile->spans = (SK_Span*)realloc(profile->spans, profile->c_spans * sizeof(SK_Span));
+    assert(profile->spans != NULL);
+  }
+
+  // the AST may be dropped before the profile is written (--stream), so the label is copied
+  char* label = NULL;
+  switch (expr->type) {
+    case EXPR_APP: {
+      label = strdup("app");
+      break;
+    }
+    case EXPR_ABS: {
+      const char* var = expr->fields.abs.vars->token->str;
+      label = (char*)malloc(strlen(var) + 2);
+      if (label != NULL) {
+        label[0] = '\\';
+        strcpy(label + 1, var);
+      }
+      break;
+    }
+    case EXPR_IDENT: {
+      label = strdup(expr->fields.ident.var->token->str);
+      break;
+    }
+  }
+  assert(label != NULL);
+
+  profile->spans[profile->s_spans] = (SK_Span){
+    .frow  = expr->frow,
+    .fcol  = expr->fcol,
+    .erow  = expr->erow,
+    .ecol  = expr->ecol,
+    .def   = profile->def,
+    .label = label
+  };
+  return (uint32_t)profile->s_spans++;
+}
+
+void _sk_profile_stamp(SK_Tree* expr, uint32_t span) {
+  // nodes made by deeper calls already carry their own span, as do the definitions REFs share
+  for (; expr != NULL && expr->span == 0; expr = expr->right) {
+    expr->span = span;
+    if (expr->type != APP_NODE)
+      return;
+    _sk_profile_stamp(expr->left, span);
+  }
+}
+
+void _sk_profile_charge(SK_Tree* node, uint64_t s_alloc) {
+  assert(_sk_profile != NULL && node != NULL);
+
+  SK_Cost* cost = _sk_profile_cost(((uint64_t)_sk_profile->def << 32 | node->span) + 1);
+  cost->s_steps++;
+  cost->s_alloc += s_alloc;
+}
+
+SK_Cost* _sk_profile_cost(uint64_t key) {
+  SK_Profile* profile = _sk_profile;
+  assert(profile != NULL && key != 0);
+
+  // kept at most half full
+  if (2 * (profile->s_costs + 1) > profile->c_costs) {
+    size_t   c_costs = 2 * profile->c_costs;
+    SK_Cost* costs   = (SK_Cost*)calloc(c_costs, sizeof(SK_Cost));
+    assert(costs != NULL);
+    for (size_t i = 0; i < profile->c_costs; i++) {
+      if (profile->costs[i].key == 0)
+        continue;
+      size_t j = (size_t)(profile->costs[i].key * 0x9e3779b97f4a7c15ull >> 32) & (c_costs - 1);
+      while (costs[j].key != 0)
+        j = (j + 1) & (c_costs - 1);
+      costs[j] = profile->costs[i];
+    }
+    free(profile->costs);
+    profile->costs   = costs;
+    profile->c_costs = c_costs;
+  }
+
+  size_t i = (size_t)(key * 0x9e3779b97f4a7c15ull >> 32) & (profile->c_costs - 1);
+  while (profile->costs[i].key != 0 && profile->costs[i].key != key)
+    i = (i + 1) & (profile->c_costs - 1);
+  if (profile->costs[i].key == 0) {
+    profile->costs[i].key = key;
+    profile->s_costs++;
+  }
+  return &profile->costs[i];
+}
+
+void _sk_profile_write_def(FILE* file, uint32_t def) {
+  assert(_sk_profile != NULL && file != NULL);
+  fputs(def < _sk_profile->s_defs ? _sk_profile->defs[def] : "<unknown>", file);
+}
@@ -0,0 +1,360 @@
+#include "skread_priv.h"
+
+#define SKR_IS_NAME_START(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || (c) == '_')
+#define SKR_IS_NAME(c)       (SKR_IS_NAME_START(c) || ((c) >= '0' && (c) <= '9'))
+
+// ========================# PUBLIC #========================
+
+SK_Tree** skt_read(Arena arena, const char* filename, size_t* s_roots) {
+  assert(arena != NULL && filename != NULL && s_roots != NULL);
+
+  int32_t fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[SK READER]: could not open %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return NULL;
+  }
+
+  size_t s_buffer = (size_t)st.st_size;
+  if (s_buffer == 0) {
+    close(fd);
+    *s_roots = 0;
+    return NULL;
+  }
+
+  const char* buffer = (const char*)mmap(NULL, s_buffer, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (buffer == MAP_FAILED) {
+    fprintf(stderr, "[SK READER]: could not map %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+  (void)madvise((void*)buffer, s_buffer, MADV_SEQUENTIAL);
+
+  SK_Tree** roots = skt_read_buffer(arena, buffer, s_buffer, filename, s_roots);
+  munmap((void*)buffer, s_buffer);
+  return roots;
+}
+
+SK_Tree** skt_read_buffer(Arena arena, const char* buffer, size_t s_buffer, const char* filename, size_t* s_roots) {
+  assert(arena != NULL && buffer != NULL && filename != NULL && s_roots != NULL);
+
+  SKR_Reader reader = {
+    .arena    = arena,
+    .filename = filename,
+    .cursor   = buffer,
+    .end      = buffer + s_buffer,
+    .line     = buffer,
+    .row      = 1,
+    .defs     = hashmap_create(1 << 5, .75),
+    .shares   = NULL, .s_shares = 0, .c_shares = 0,
+    .frames   = NULL, .s_frames = 0, .c_frames = 0,
+    .key      = NULL, .c_key = 0,
+    .slab     = NULL, .s_slab = 0,
+    .s_node   = NULL, .k_node = NULL
+  };
+  assert(reader.defs != NULL);
+
+  const char* tag = arena_tag(arena, TAG_SK_READ);
+  reader.s_node = _skr_node(&reader, S_NODE, NULL, NULL, NULL);
+  reader.k_node = _skr_node(&reader, K_NODE, NULL, NULL, NULL);
+
+  SK_Tree** defs = NULL;
+  size_t s_defs = 0, c_defs = 0;
+  bool failed = false;
+
+  for (_skr_skip_space(&reader); reader.cursor < reader.end; _skr_skip_space(&reader)) {
+    // numbers restart with every skt_write call, so $N may be defined again but never skips one
+    uint32_t share = 0;
+    ASTN_Ident* ident = NULL;
+    if (*reader.cursor == '$') {
+      if (!_skr_read_share(&reader, &share) || share > reader.s_shares + 1) {
+        failed = _skr_error(&reader, "expected the number of the next shared term after '$'");
+        break;
+      }
+    } else {
+      size_t s_name = 0;
+      const char* name = _skr_read_name(&reader, &s_name);
+      if (name == NULL) {
+        failed = _skr_error(&reader, "expected a definition name");
+        break;
+      }
+      ident = _skr_ident(&reader, name, s_name);
+    }
+
+    _skr_skip_space(&reader);
+    if (reader.cursor >= reader.end || *reader.cursor != '=') {
+      failed = _skr_error(&reader, "expected '=' after the definition name");
+      break;
+    }
+    reader.cursor++;
+
+    SK_Tree* root = _skr_read_term(&reader);
+    if (root == NULL) {
+      failed = true;
+      break;
+    }
+
+    if (ident == NULL) {
+      if (share > reader.c_shares) {
+        reader.c_shares = reader.c_shares > 0 ? 2 * reader.c_shares : 1 << 6;
+        reader.shares = (SK_Tree**)realloc(reader.shares, reader.c_shares * sizeof(SK_Tree*));
+        assert(reader.shares != NULL);
+      }
+      reader.shares[share - 1] = root;
+      if (share > reader.s_shares)
+        reader.s_shares = share;
+      continue;
+    }
+
+    // the root carries the definition name, so it cannot be a shared leaf
+    if (root == reader.s_node || root == reader.k_node)
+      root = _skr_node(&reader, root->type, NULL, NULL, NULL);
+    root->ld_ident = ident;
+    (void)hashmap_insert(&reader.defs, (char*)ident->token->str, root, NULL, false);
+
+    if (s_defs == c_defs) {
+      c_defs = c_defs > 0 ? 2 * c_defs : 1 << 6;
+      defs = (SK_Tree**)realloc(defs, c_defs * sizeof(SK_Tree*));
+      assert(defs != NULL);
+    }
+    defs[s_defs++] = root;
+  }
+
+  SK_Tree** roots = NULL;
+  if (!failed && s_defs > 0) {
+    roots = (SK_Tree**)arena_alloc_tagged(arena, s_defs * sizeof(SK_Tree*), TAG_ROOTS);
+    assert(roots != NULL);
+    memcpy(roots, defs, s_defs * sizeof(SK_Tree*));
+  }
+  *s_roots = failed ? 0 : s_defs;
+
+  (void)arena_tag(arena, tag);
+  free(defs);
+  free(reader.frames);
+  free(reader.shares);
+  free(reader.key);
+  hashmap_free(reader.defs, NULL, false);
+  return roots;
+}
+
+// ========================# PRIVATE #========================
+
+SK_Tree* _skr_read_term(SKR_Reader* reader) {
+  assert(reader != NULL);
+
+  // application is left associative and only parentheses nest, so the reader keeps one
+  // partial application per open parenthesis instead of recursing
+  reader->s_frames = 0;
+  _skr_push(reader, false);
+
+  while (true) {
+    _skr_skip_space(reader);
+    if (reader->cursor >= reader->end) {
+      (void)_skr_error(reader, "unexpected end of file, missing ';'");
+      return NULL;
+    }
+
+    char c = *reader->cursor;
+    switch (c) {
+      case ';': {
+        if (reader->s_frames != 1) {
+          (void)_skr_error(reader, "unclosed parenthesis");
+          return NULL;
+        }
+        if (reader->frames[0].term == NULL) {
+          (void)_skr_error(reader, "empty definition");
+          return NULL;
+        }
+        reader->cursor++;
+        return reader->frames[0].term;
+      }
+      case '(': {
+        reader->cursor++;
+        _skr_push(reader, false);
+        continue;
+      }
+      case ')': {
+        SKR_Frame frame = reader->frames[reader->s_frames - 1];
+        if (reader->s_frames == 1 || frame.term == NULL) {
+          (void)_skr_error(reader, reader->s_frames == 1 ? "unbalanced ')'" : "empty parentheses");
+          return NULL;
+        }
+        reader->cursor++;
+        reader->s_frames--;
+        _skr_apply(reader, frame.is_ref ? _skr_node(reader, REF_NODE, frame.term, NULL, NULL) : frame.term);
+        continue;
+      }
+      case '&': {
+        reader->cursor++;
+        if (reader->cursor < reader->end && *reader->cursor == '(') {
+          reader->cursor++;
+          _skr_push(reader, true);
+          continue;
+        }
+
+        if (reader->cursor < reader->end && *reader->cursor == '$') {
+          uint32_t share = 0;
+          if (!_skr_read_share(reader, &share) || share > reader->s_shares) {
+            (void)_skr_error(reader, "reference to a shared term that is not defined before it");
+            return NULL;
+          }
+          _skr_apply(reader, _skr_node(reader, REF_NODE, reader->shares[share - 1], NULL, NULL));
+          continue;
+        }
+
+        size_t s_name = 0;
+        const char* name = _skr_read_name(reader, &s_name);
+        if (name == NULL) {
+          (void)_skr_error(reader, "expected a name after '&'");
+          return NULL;
+        }
+
+        // the converter resolves every earlier definition, so any other name is a shared free variable
+        SK_Tree* def = (SK_Tree*)hashmap_get(reader->defs, (char*)_skr_key(reader, name, s_name));
+        if (def == NULL)
+          def = _skr_node(reader, LD_NODE, NULL, NULL, _skr_ident(reader, name, s_name));
+        _skr_apply(reader, _skr_node(reader, REF_NODE, def, NULL, NULL));
+        continue;
+      }
+      default: {
+        size_t s_name = 0;
+        const char* name = _skr_read_name(reader, &s_name);
+        if (name == NULL) {
+          (void)_skr_error(reader, "unexpected character");
+          return NULL;
+        }
+
+        size_t i = 0;
+        for (; i < s_name && (name[i] == 'S' || name[i] == 'K'); i++);
+        if (i < s_name) {
+          _skr_apply(reader, _skr_node(reader, LD_NODE, NULL, NULL, _skr_ident(reader, name, s_name)));
+          continue;
+        }
+
+        for (i = 0; i < s_name; i++)
+          _skr_apply(reader, name[i] == 'S' ? reader->s_node : reader->k_node);
+        continue;
+      }
+    }
+  }
+}
+
+const char* _skr_read_name(SKR_Reader* reader, size_t* s_name) {
+  assert(reader != NULL && s_name != NULL);
+
+  const char* start = reader->cursor;
+  if (start >= reader->end || !SKR_IS_NAME_START(*start))
+    return NULL;
+
+  const char* c = start + 1;
+  for (; c < reader->end && SKR_IS_NAME(*c); c++);
+
+  reader->cursor = c;
+  *s_name = (size_t)(c - start);
+  return start;
+}
+
+bool _skr_read_share(SKR_Reader* reader, uint32_t* share) {
+  assert(reader != NULL && share != NULL && reader->cursor < reader->end && *reader->cursor == '$');
+
+  // at most nine digits, so that the number fits and is never 0
+  const char* c = ++reader->cursor;
+  uint32_t number = 0;
+  for (; c < reader->end && *c >= '0' && *c <= '9' && c - reader->cursor < 9; c++)
+    number = 10 * number + (uint32_t)(*c - '0');
+
+  bool valid = c > reader->cursor && number > 0 && (c == reader->end || *c < '0' || *c > '9');
+  reader->cursor = c;
+  *share = number;
+  return valid;
+}
+
+SK_Tree* _skr_node(SKR_Reader* reader, uint32_t type, SK_Tree* left, SK_Tree* right, ASTN_Ident* ident) {
+  assert(reader != NULL);
+
+  if (reader->s_slab == 0) {
+    reader->slab = (SK_Tree*)arena_alloc_array(reader->arena, sizeof(struct sk_tree), SKR_SLAB);
+    assert(reader->slab != NULL);
+    reader->s_slab = SKR_SLAB;
+  }
+
+  SK_Tree* node = reader->slab++;
+  reader->s_slab--;
+  *node = (SK_Tree){ .type = type, .left = left, .right = right, .ld_ident = ident };
+  return node;
+}
+
+ASTN_Ident* _skr_ident(SKR_Reader* reader, const char* name, size_t s_name) {
+  assert(reader != NULL && name != NULL);
+
+  char* str = (char*)arena_alloc(reader->arena, s_name + 1);
+  assert(str != NULL);
+  memcpy(str, name, s_name);
+  str[s_name] = '\0';
+
+  uint32_t fcol = (uint32_t)(name - reader->line) + 1;
+  ASTN_Token* token = astn_create_token(reader->arena, str, reader->row, fcol, fcol + (uint32_t)s_name - 1);
+  return astn_create_ident(reader->arena, token, NULL);
+}
+
+const char* _skr_key(SKR_Reader* reader, const char* name, size_t s_name) {
+  assert(reader != NULL && name != NULL);
+
+  // the mapped input is not NUL terminated, lookups go through a reusable copy
+  if (s_name + 1 > reader->c_key) {
+    reader->c_key = 2 * (s_name + 1);
+    reader->key = (char*)realloc(reader->key, reader->c_key);
+    assert(reader->key != NULL);
+  }
+  memcpy(reader->key, name, s_name);
+  reader->key[s_name] = '\0';
+  return reader->key;
+}
+
+void _skr_push(SKR_Reader* reader, bool is_ref) {
+  assert(reader != NULL);
+
+  if (reader->s_frames == reader->c_frames) {
+    reader->c_frames = reader->c_frames > 0 ? 2 * reader->c_frames : 1 << 6;
+    reader->frames = (SKR_Frame*)realloc(reader->frames, reader->c_frames * sizeof(SKR_Frame));
+    assert(reader->frames != NULL);
+  }
+  reader->frames[reader->s_frames++] = (SKR_Frame){ .term = NULL, .is_ref = is_ref };
+}
+
+void _skr_apply(SKR_Reader* reader, SK_Tree* term) {
+  assert(reader != NULL && term != NULL && reader->s_frames > 0);
+
+  SKR_Frame* frame = &reader->frames[reader->s_frames - 1];
+  frame->term = frame->term == NULL ? term : _skr_node(reader, APP_NODE, frame->term, term, NULL);
+}
+
+void _skr_skip_space(SKR_Reader* reader) {
+  assert(reader != NULL);
+
+  const char* c = reader->cursor;
+  for (; c < reader->end; c++) {
+    if (*c == '\n') {
+      reader->row++;
+      reader->line = c + 1;
+    } else if (*c != ' ' && *c != '\t' && *c != '\r') {
+      break;
+    }
+  }
+  reader->cursor = c;
+}
+
+bool _skr_error(SKR_Reader* reader, const char* message) {
+  assert(reader != NULL && message != NULL);
+
+  fprintf(
+    stderr, "[SK READER]: %s at line %u column %u in file %s\n",
+    message, reader->row, (uint32_t)(reader->cursor - reader->line) + 1, reader->filename
+  );
+  return true;
+}
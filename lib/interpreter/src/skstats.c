@@ -0,0 +1,144 @@
+#include "skstats_priv.h"
+
+SK_Stats* _sk_stats = NULL;
+
+static SK_Stats _sk_stats_run;
+
+static const char* _sk_phase_names[SK_PHASES] = { "parse", "check", "transform", "convert", "write" };
+
+// ========================# PUBLIC #========================
+
+void sk_stats_enable(void) {
+  if (_sk_stats != NULL)
+    return;
+
+  _sk_stats_run = (SK_Stats){ 0 };
+  _sk_stats = &_sk_stats_run;
+}
+
+void sk_stats_begin(SK_Phase phase) {
+  if (_sk_stats == NULL)
+    return;
+  assert(phase < SK_PHASES);
+  _sk_stats->t_starts[phase] = _sk_stats_now();
+}
+
+void sk_stats_end(SK_Phase phase) {
+  if (_sk_stats == NULL)
+    return;
+  assert(phase < SK_PHASES);
+  _sk_stats->t_phases[phase] += _sk_stats_now() - _sk_stats->t_starts[phase];
+}
+
+void sk_stats_count_stmt(ASTN_Stmt* stmt) {
+  if (_sk_stats == NULL || stmt == NULL)
+    return;
+  _sk_stats->s_stmts++;
+  _sk_stats->s_ast_nodes += _sk_stats_count_expr(stmt->expr);
+}
+
+void sk_stats_count_root(SK_Tree* root) {
+  if (_sk_stats == NULL)
+    return;
+  _sk_stats->s_sk_nodes += _sk_stats_count_sk(root);
+}
+
+void sk_stats_print(FILE* file, Arena arena) {
+  if (_sk_stats == NULL)
+    return;
+  if (file == NULL)
+    file = stdout;
+
+  double t_total = 0;
+  for (uint32_t i = 0; i < SK_PHASES; i++)
+    t_total += _sk_stats->t_phases[i];
+
+  fprintf(file, "Statistics:\n");
+  for (uint32_t i = 0; i < SK_PHASES; i++)
+    fprintf(
+      file, "  %-10s %12.3f ms  %5.1f%%\n", _sk_phase_names[i], 1e3 * _sk_stats->t_phases[i],
+      t_total > 0 ? 100 * _sk_stats->t_phases[i] / t_total : 0
+    );
+  fprintf(file, "  %-10s %12.3f ms\n", "total", 1e3 * t_total);
+  fprintf(file, "  statements:      %zu;\n", _sk_stats->s_stmts);
+  fprintf(file, "  ast nodes:       %zu;\n", _sk_stats->s_ast_nodes);
+  fprintf(file, "  sk nodes:        %zu;\n", _sk_stats->s_sk_nodes);
+  fprintf(file, "  K steps:         %zu;\n", _sk_stats->s_k_steps);
+  fprintf(file, "  S steps:         %zu;\n", _sk_stats->s_s_steps);
+  fprintf(file, "  REF unfolds:     %zu;\n", _sk_stats->s_ref_steps);
+  fprintf(file, "  machine steps:   %zu;\n", _sk_stats->s_eval_steps);
+  fprintf(file, "  instantiations:  %zu;\n", _sk_stats->s_super_steps);
+  fprintf(file, "  interactions:    %zu;\n", _sk_stats->s_net_steps);
+  fprintf(file, "  skt_copy:        %zu bytes;\n", _sk_stats->s_copied);
+  for (uint32_t i = 0; i < SK_OPT_RULES; i++)
+    fprintf(file, "  %-17s%zu;\n", sk_opt_rule_name(i), _sk_stats->s_rewrites[i]);
+  fprintf(file, "  peephole saved:  %zu nodes;\n", _sk_stats->s_opt_nodes);
+  if (arena != NULL) {
+    fprintf(file, "  arena used:      %zu bytes;\n", arena_get_size_used(arena));
+    fprintf(file, "  arena reserved:  %zu bytes;\n", arena_get_size_reserved(arena));
+    if (arena_get_size_peak(arena) > 0)
+      fprintf(file, "  arena peak:      %zu bytes;\n", arena_get_size_peak(arena));
+  }
+}
+
+void sk_stats_write_json(FILE* file, Arena arena) {
+  if (_sk_stats == NULL)
+    return;
+  assert(file != NULL);
+
+  fprintf(file, "{\n  \"phases_ms\": {");
+  for (uint32_t i = 0; i < SK_PHASES; i++)
+    fprintf(file, "%s \"%s\": %.3f", i > 0 ? "," : "", _sk_phase_names[i], 1e3 * _sk_stats->t_phases[i]);
+  fprintf(file, " },\n");
+  fprintf(file, "  \"statements\": %zu, \"ast_nodes\": %zu, \"sk_nodes\": %zu,\n",
+    _sk_stats->s_stmts, _sk_stats->s_ast_nodes, _sk_stats->s_sk_nodes);
+  fprintf(file, "  \"steps\": { \"k\": %zu, \"s\": %zu, \"ref\": %zu, \"machine\": %zu, \"super\": %zu, \"net\": %zu },\n",
+    _sk_stats->s_k_steps, _sk_stats->s_s_steps, _sk_stats->s_ref_steps, _sk_stats->s_eval_steps, _sk_stats->s_super_steps,
+    _sk_stats->s_net_steps);
+  fprintf(file, "  \"rewrites\": {");
+  for (uint32_t i = 0; i < SK_OPT_RULES; i++)
+    fprintf(file, "%s \"%s\": %zu", i > 0 ? "," : "", sk_opt_rule_name(i), _sk_stats->s_rewrites[i]);
+  fprintf(file, " },\n  \"peephole_saved_nodes\": %zu,\n", _sk_stats->s_opt_nodes);
+  fprintf(file, "  \"copied_bytes\": %zu", _sk_stats->s_copied);
+  if (arena != NULL)
+    fprintf(file, ",\n  \"arena\": { \"used\": %zu, \"reserved\": %zu, \"peak\": %zu }",
+      arena_get_size_used(arena), arena_get_size_reserved(arena), arena_get_size_peak(arena));
+  fprintf(file, "\n}\n");
+}
+
+void sk_stats_disable(void) {
+  _sk_stats = NULL;
+}
+
+// ========================# PRIVATE #========================
+
+double _sk_stats_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+uint64_t _sk_stats_count_expr(ASTN_Expr* expr) {
+  if (expr == NULL)
+    return 0;
+
+  switch (expr->type) {
+    case EXPR_APP:
+      return 1 + _sk_stats_count_expr(expr->fields.app.left) + _sk_stats_count_expr(expr->fields.app.right);
+    case EXPR_ABS:
+      return 1 + _sk_stats_count_expr(expr->fields.abs.expr);
+    case EXPR_IDENT:
+      return 1;
+  }
+  return 0;
+}
+
+uint64_t _sk_stats_count_sk(SK_Tree* expr) {
+  if (expr == NULL)
+    return 0;
+
+  // what a REF points to is shared with the tree it was made from and counted there
+  if (expr->type == APP_NODE)
+    return 1 + _sk_stats_count_sk(expr->left) + _sk_stats_count_sk(expr->right);
+  return 1;
+}
@@ -0,0 +1,392 @@
+#include "sksuper_priv.h"
+
+__thread uint64_t _sks_steps = 0;
+
+// ========================# PUBLIC #========================
+
+SK_Tree** ast_supercombine(Arena arena, AST* ast, HashTable table, Diagnostics* diagnostics) {
+  assert(arena != NULL && ast != NULL && table != NULL && diagnostics != NULL);
+
+  size_t s_stmts = ast->s_stmts;
+  SK_Tree** roots = (SK_Tree**)arena_alloc_tagged(arena, s_stmts * sizeof(SK_Tree*), TAG_ROOTS);
+  assert(roots != NULL);
+
+  // the graph of a definition is reduced in place and shared with every later one, so nothing is
+  // released before the last root is read back and evacuated
+  SKS_Machine machine = {
+    .arena       = arena_shard_create(arena),
+    .diagnostics = diagnostics,
+    .stack       = NULL, .s_stack = 0, .capacity = 0,
+    .args        = NULL, .c_args = 0,
+    .globals     = SK_INDEX_EMPTY,
+    .trees       = SK_INDEX_EMPTY,
+    .s_steps     = 0, .s_nodes = 0, .s_budget = 0, .s_depth = 0
+  };
+  assert(machine.arena != NULL);
+
+  ASTN_Stmt* stmt = ast->stmts;
+  for (size_t i = 0; i < s_stmts; i++, stmt = stmt->next)
+    roots[i] = _sks_evaluate_stmt(&machine, arena, stmt, table);
+
+  free(machine.stack);
+  free(machine.args);
+  _sk_index_free(&machine.globals);
+  _sk_index_free(&machine.trees);
+  (void)arena_reset(machine.arena);
+  return roots;
+}
+
+uint64_t sks_get_steps(void) {
+  return _sks_steps;
+}
+
+// ========================# PRIVATE #========================
+
+SK_Tree* _sks_evaluate_stmt(SKS_Machine* machine, Arena arena, ASTN_Stmt* stmt, HashTable table) {
+  assert(machine != NULL && arena != NULL && stmt != NULL && table != NULL);
+
+  // the spine only unwinds as far as the head needs, a name off it would go unreported
+  _ast_expr_report_later(stmt->expr, machine->diagnostics);
+
+  const char* tag = arena_tag(machine->arena, TAG_SK_EVAL);
+  machine->s_steps  = 0;
+  machine->s_nodes  = 0;
+  machine->s_budget = SK_BACK_MAX_STEPS;
+  machine->s_depth  = 0;
+
+  SK_Tree* root = _sks_read_back(machine, _sks_global(machine, stmt));
+
+  _sks_steps += machine->s_steps;
+  if (_sk_stats != NULL)
+    _sk_stats->s_super_steps += machine->s_steps;
+
+  if (root == NULL) {
+    (void)arena_tag(machine->arena, tag);
+    root = _sk_back_convert(
+      arena, machine->arena, stmt, table, machine->diagnostics, "SUPERCOMBINATOR",
+      "has no normal form within the limits of the reducer"
+    );
+
+    // the graph of a later definition links a copy of the SK tree
+    _sk_index_put_ptr(&machine->globals, stmt, _sks_tree(machine, root));
+    return root;
+  }
+
+  root = _ast_stmt_define(arena, machine->arena, stmt, root);
+  (void)arena_tag(machine->arena, tag);
+  return root;
+}
+
+SKS_Node* _sks_compile(SKS_Machine* machine, ASTN_Expr* expr, SKS_Scope* scope) {
+  assert(machine != NULL && expr != NULL && scope != NULL);
+
+  switch (expr->type) {
+    case EXPR_APP: {
+      SKS_Node* fun = _sks_compile(machine, expr->fields.app.left, scope);
+      return _sks_app(machine, fun, _sks_compile(machine, expr->fields.app.right, scope));
+    }
+    case EXPR_ABS: {
+      return _sks_lift(machine, expr, scope);
+    }
+    case EXPR_IDENT: {
+      SKS_Node* node;
+      if (expr->index != AST_UNBOUND) {
+        assert(expr->index < scope->s_params && scope->params[expr->index] != SKS_UNUSED);
+        node = _sks_node(machine, SKS_ARG);
+        node->fields.arg = scope->params[expr->index];
+      } else if (expr->fields.ident.stmt != NULL && expr->fields.ident.stmt->sk_expr != NULL) {
+        node = _sks_node(machine, SKS_GLOBAL);
+        node->fields.global = expr->fields.ident.stmt;
+      } else {
+        // a free name, or a definition that comes later, which was reported
+        node = _sks_node(machine, SKS_NAME);
+        node->fields.name = expr->fields.ident.var;
+      }
+      return node;
+    }
+  }
+
+  return NULL;
+}
+
+SKS_Node* _sks_lift(SKS_Machine* machine, ASTN_Expr* abs, SKS_Scope* scope) {
+  assert(machine != NULL && abs != NULL && abs->type == EXPR_ABS && scope != NULL);
+
+  // \x1 -> ... \xn -> body becomes one supercombinator of the variables from outside that body uses
+  // and of x1 ... xn, applied where the abstraction was to the arguments standing for the former
+  uint32_t s_binders = 0;
+  ASTN_Expr* body = abs;
+  for (; body->type == EXPR_ABS; body = body->fields.abs.expr)
+    s_binders++;
+
+  bool* used = (bool*)arena_alloc(machine->arena, (scope->s_params + 1) * sizeof(bool));
+  assert(used != NULL);
+  memset(used, 0, (scope->s_params + 1) * sizeof(bool));
+  _sks_used(body, s_binders, used, scope->s_params);
+
+  uint32_t s_free = 0;
+  for (uint32_t i = 0; i < scope->s_params; i++)
+    s_free += used[i];
+
+  SKS_Scope inner = {
+    .params   = (uint32_t*)arena_alloc(machine->arena, (s_binders + scope->s_params) * sizeof(uint32_t)),
+    .s_params = s_binders + scope->s_params
+  };
+  assert(inner.params != NULL);
+  for (uint32_t i = 0; i < s_binders; i++)
+    inner.params[i] = s_free + s_binders - 1 - i;
+  for (uint32_t i = 0, j = 0; i < scope->s_params; i++)
+    inner.params[s_binders + i] = used[i] ? j++ : SKS_UNUSED;
+
+  SKS_Comb* comb = (SKS_Comb*)arena_alloc(machine->arena, sizeof(struct sks_comb));
+  assert(comb != NULL);
+  comb->arity = s_free + s_binders;
+  comb->body  = _sks_compile(machine, body, &inner);
+
+  SKS_Node* node = _sks_node(machine, SKS_COMB);
+  node->fields.comb = comb;
+  for (uint32_t i = 0; i < scope->s_params; i++) {
+    if (!used[i])
+      continue;
+    SKS_Node* arg = _sks_node(machine, SKS_ARG);
+    arg->fields.arg = scope->params[i];
+    node = _sks_app(machine, node, arg);
+  }
+  return node;
+}
+
+void _sks_used(ASTN_Expr* expr, uint32_t s_binders, bool* used, uint32_t s_used) {
+  assert(expr != NULL && used != NULL);
+
+  switch (expr->type) {
+    case EXPR_APP: {
+      _sks_used(expr->fields.app.left, s_binders, used, s_used);
+      _sks_used(expr->fields.app.right, s_binders, used, s_used);
+      break;
+    }
+    case EXPR_ABS: {
+      _sks_used(expr->fields.abs.expr, s_binders + 1, used, s_used);
+      break;
+    }
+    case EXPR_IDENT: {
+      if (expr->index == AST_UNBOUND || expr->index < s_binders)
+        break;
+      assert(expr->index - s_binders < s_used);
+      used[expr->index - s_binders] = true;
+      break;
+    }
+  }
+}
+
+SKS_Node* _sks_instantiate(SKS_Machine* machine, SKS_Node* body) {
+  assert(machine != NULL && body != NULL);
+
+  switch (body->type) {
+    case SKS_APP: {
+      SKS_Node* fun = _sks_instantiate(machine, body->fields.app.fun);
+      return _sks_app(machine, fun, _sks_instantiate(machine, body->fields.app.arg));
+    }
+    case SKS_ARG: {
+      return machine->args[body->fields.arg];
+    }
+    default: {
+      return body;
+    }
+  }
+}
+
+SKS_Node* _sks_whnf(SKS_Machine* machine, SKS_Node* root) {
+  assert(machine != NULL && root != NULL);
+
+  size_t base = machine->s_stack;
+  for (SKS_Node* node = root;;) {
+    node = _sks_deref(machine, node);
+    if (node->type == SKS_APP) {
+      _sks_push(machine, node);
+      node = node->fields.app.fun;
+      continue;
+    }
+
+    uint32_t arity = node->type == SKS_COMB ? node->fields.comb->arity
+                   : node->type == SKS_S    ? 3
+                   : node->type == SKS_K    ? 2
+                   : 0;
+    if (arity == 0 || machine->s_stack - base < arity) {
+      // a name applied to anything, or a function waiting for more arguments
+      machine->s_stack = base;
+      return _sks_deref(machine, root);
+    }
+    if (++machine->s_steps + machine->s_nodes > machine->s_budget) {
+      machine->s_stack = base;
+      return NULL;
+    }
+
+    if (machine->c_args < arity) {
+      machine->c_args = 2 * arity;
+      machine->args = (SKS_Node**)realloc(machine->args, machine->c_args * sizeof(SKS_Node*));
+      assert(machine->args != NULL);
+    }
+    for (uint32_t i = 0; i < arity; i++)
+      machine->args[i] = machine->stack[machine->s_stack - 1 - i]->fields.app.arg;
+    SKS_Node* redex = machine->stack[machine->s_stack - arity];
+    machine->s_stack -= arity;
+
+    // the redex is overwritten, an instance that is not a new node is reached through an IND
+    switch (node->type) {
+      case SKS_COMB: {
+        SKS_Node* body = node->fields.comb->body;
+        if (body->type == SKS_APP) {
+          SKS_Node* fun = _sks_instantiate(machine, body->fields.app.fun);
+          redex->fields.app.arg = _sks_instantiate(machine, body->fields.app.arg);
+          redex->fields.app.fun = fun;
+        } else {
+          redex->type = SKS_IND;
+          redex->fields.ind = _sks_instantiate(machine, body);
+        }
+        break;
+      }
+      case SKS_S: {
+        SKS_Node* xz = _sks_app(machine, machine->args[0], machine->args[2]);
+        redex->fields.app.arg = _sks_app(machine, machine->args[1], machine->args[2]);
+        redex->fields.app.fun = xz;
+        break;
+      }
+      default: {
+        assert(node->type == SKS_K);
+        redex->type = SKS_IND;
+        redex->fields.ind = machine->args[0];
+        break;
+      }
+    }
+    node = redex;
+  }
+}
+
+SKS_Node* _sks_deref(SKS_Machine* machine, SKS_Node* node) {
+  assert(machine != NULL && node != NULL);
+
+  for (;;) {
+    if (node->type == SKS_IND)
+      node = node->fields.ind;
+    else if (node->type == SKS_GLOBAL)
+      node = _sks_global(machine, node->fields.global);
+    else
+      return node;
+  }
+}
+
+SK_Tree* _sks_read_back(SKS_Machine* machine, SKS_Node* node) {
+  assert(machine != NULL);
+  if (node == NULL || machine->s_steps + ++machine->s_nodes > machine->s_budget || machine->s_depth == SK_BACK_MAX_DEPTH)
+    return NULL;
+  node = _sks_whnf(machine, node);
+  if (node == NULL)
+    return NULL;
+
+  // the spine stays on the stack while the arguments are read back above it
+  size_t base = machine->s_stack;
+  SKS_Node* head = node;
+  for (; head->type == SKS_APP; head = _sks_deref(machine, head->fields.app.fun))
+    _sks_push(machine, head);
+  size_t s_args = machine->s_stack - base;
+
+  SK_Tree* tree = NULL;
+  machine->s_depth++;
+  if (head->type == SKS_NAME) {
+    tree = _skt_node(machine->arena, LD_NODE, NULL, NULL, head->fields.name);
+    for (size_t i = 0; i < s_args && tree != NULL; i++) {
+      SK_Tree* arg = _sks_read_back(machine, machine->stack[base + s_args - 1 - i]->fields.app.arg);
+      tree = arg != NULL ? _skt_node(machine->arena, APP_NODE, tree, arg, NULL) : NULL;
+    }
+  } else {
+    // a supercombinator, S or K short of its arity
+    ASTN_Ident* var = _sk_back_var(machine->arena);
+    SKS_Node* name = _sks_node(machine, SKS_NAME);
+    name->fields.name = var;
+    SK_Tree* body = _sks_read_back(machine, _sks_app(machine, node, name));
+    if (body != NULL)
+      tree = _sk_back_abstract(machine->arena, body, var);
+  }
+  machine->s_depth--;
+  machine->s_stack = base;
+  return tree;
+}
+
+SKS_Node* _sks_global(SKS_Machine* machine, ASTN_Stmt* stmt) {
+  assert(machine != NULL && stmt != NULL);
+
+  SKS_Node* node = (SKS_Node*)_sk_index_get_ptr(&machine->globals, stmt);
+  if (node != NULL)
+    return node;
+
+  // a definition of this program is an instance of its lifted expression, a linked one is its SK tree
+  if (stmt->expr != NULL) {
+    SKS_Scope scope = { .params = NULL, .s_params = 0 };
+    node = _sks_instantiate(machine, _sks_compile(machine, stmt->expr, &scope));
+  } else {
+    node = _sks_tree(machine, stmt->sk_expr);
+  }
+  _sk_index_put_ptr(&machine->globals, stmt, node);
+  return node;
+}
+
+SKS_Node* _sks_tree(SKS_Machine* machine, SK_Tree* tree) {
+  assert(machine != NULL && tree != NULL);
+
+  SKS_Node* node = (SKS_Node*)_sk_index_get_ptr(&machine->trees, tree);
+  if (node != NULL)
+    return node;
+
+  // a shared subtree is copied once, so that its reduction is shared as well
+  switch (tree->type) {
+    case APP_NODE: {
+      SKS_Node* fun = _sks_tree(machine, tree->left);
+      node = _sks_app(machine, fun, _sks_tree(machine, tree->right));
+      break;
+    }
+    case REF_NODE: {
+      node = _sks_tree(machine, tree->left);
+      break;
+    }
+    case LD_NODE: {
+      node = _sks_node(machine, SKS_NAME);
+      node->fields.name = tree->ld_ident;
+      break;
+    }
+    case S_NODE: {
+      node = _sks_node(machine, SKS_S);
+      break;
+    }
+    case K_NODE: {
+      node = _sks_node(machine, SKS_K);
+      break;
+    }
+  }
+  _sk_index_put_ptr(&machine->trees, tree, node);
+  return node;
+}
+
+void _sks_push(SKS_Machine* machine, SKS_Node* node) {
+  assert(machine != NULL && node != NULL);
+
+  if (machine->s_stack == machine->capacity) {
+    machine->capacity = machine->capacity > 0 ? 2 * machine->capacity : 1 << 10;
+    machine->stack = (SKS_Node**)realloc(machine->stack, machine->capacity * sizeof(SKS_Node*));
+    assert(machine->stack != NULL);
+  }
+  machine->stack[machine->s_stack++] = node;
+}
+
+SKS_Node* _sks_node(SKS_Machine* machine, uint32_t type) {
+  SKS_Node* node = (SKS_Node*)arena_alloc(machine->arena, sizeof(struct sks_node));
+  assert(node != NULL);
+  node->type = type;
+  return node;
+}
+
+SKS_Node* _sks_app(SKS_Machine* machine, SKS_Node* fun, SKS_Node* arg) {
+  SKS_Node* node = _sks_node(machine, SKS_APP);
+  node->fields.app.fun = fun;
+  node->fields.app.arg = arg;
+  return node;
+}
@@ -0,0 +1,208 @@
+#include "sktrace_priv.h"
+
+SK_Trace* _sk_trace = NULL;
+
+static uint32_t _sk_trace_threads = 0;
+static __thread uint16_t _sk_trace_thread = 0;
+
+static const char* _sk_rule_names[] = { "K", "S", "REF", "begin", "end" };
+
+// ========================# PUBLIC #========================
+
+bool sk_trace_enable(uint32_t s_events) {
+  if (_sk_trace != NULL)
+    return true;
+  if (s_events == 0)
+    return false;
+
+  // a power of two, so that the slot of an event is its sequence number masked
+  uint64_t capacity = 1;
+  while (capacity < s_events)
+    capacity <<= 1;
+
+  SK_Trace* trace = (SK_Trace*)malloc(sizeof(SK_Trace));
+  if (trace == NULL)
+    return false;
+  trace->events = (SK_TraceEvent*)malloc(capacity * sizeof(SK_TraceEvent));
+  if (trace->events == NULL) {
+    free(trace);
+    return false;
+  }
+  trace->mask    = capacity - 1;
+  trace->head    = 0;
+  trace->t_start = _sk_trace_now();
+
+  _sk_trace = trace;
+  return true;
+}
+
+bool sk_trace_dump(const char* path) {
+  assert(path != NULL);
+  SK_Trace* trace = _sk_trace;
+  if (trace == NULL)
+    return false;
+
+  FILE* file = fopen(path, "wb");
+  if (file == NULL)
+    return false;
+
+  uint64_t head     = __atomic_load_n(&trace->head, __ATOMIC_ACQUIRE),
+           capacity = trace->mask + 1,
+           s_events = head < capacity ? head : capacity,
+           first    = (head - s_events) & trace->mask,
+           s_tail   = capacity - first < s_events ? capacity - first : s_events;
+
+  struct sk_trace_header header = {
+    .magic     = SKTRACE_MAGIC,
+    .version   = SKTRACE_VERSION,
+    .s_event   = sizeof(SK_TraceEvent),
+    .s_events  = (uint32_t)s_events,
+    .s_dropped = head - s_events
+  };
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+         && fwrite(trace->events + first, sizeof(SK_TraceEvent), s_tail, file) == s_tail
+         && fwrite(trace->events, sizeof(SK_TraceEvent), s_events - s_tail, file) == s_events - s_tail;
+  return fclose(file) == 0 && ok;
+}
+
+bool sk_trace_convert(const char* path, FILE* out, bool replay) {
+  assert(path != NULL && out != NULL);
+
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "[TRACE]: could not open %s\n", path);
+    return false;
+  }
+
+  struct sk_trace_header header;
+  if (
+    fread(&header, sizeof(header), 1, file) != 1 || header.magic != SKTRACE_MAGIC
+    || header.version != SKTRACE_VERSION || header.s_event != sizeof(SK_TraceEvent)
+  ) {
+    fprintf(stderr, "[TRACE]: %s is not a trace written by this interpreter\n", path);
+    fclose(file);
+    return false;
+  }
+
+  SK_TraceEvent* events = (SK_TraceEvent*)malloc((header.s_events > 0 ? header.s_events : 1) * sizeof(SK_TraceEvent));
+  assert(events != NULL);
+  size_t s_read = fread(events, sizeof(SK_TraceEvent), header.s_events, file);
+  fclose(file);
+  if (s_read != header.s_events) {
+    fprintf(stderr, "[TRACE]: %s is truncated, %zu of %u events\n", path, s_read, header.s_events);
+    free(events);
+    return false;
+  }
+
+  if (header.s_dropped > 0)
+    fprintf(stderr, "[TRACE]: the ring buffer overwrote the first %zu events\n", header.s_dropped);
+  if (replay)
+    _sk_trace_write_replay(out, events, header.s_events);
+  else
+    _sk_trace_write_chrome(out, events, header.s_events);
+
+  free(events);
+  return true;
+}
+
+void sk_trace_disable(void) {
+  SK_Trace* trace = _sk_trace;
+  if (trace == NULL)
+    return;
+
+  _sk_trace = NULL;
+  free(trace->events);
+  free(trace);
+}
+
+// ========================# PRIVATE #========================
+
+void _sk_trace_record(SK_Rule rule, SK_Tree* node, uint32_t step, uint32_t depth, int32_t s_alloc) {
+  SK_Trace* trace = _sk_trace;
+  if (_sk_trace_thread == 0)
+    _sk_trace_thread = (uint16_t)__atomic_add_fetch(&_sk_trace_threads, 1, __ATOMIC_RELAXED);
+
+  uint64_t i = __atomic_fetch_add(&trace->head, 1, __ATOMIC_RELAXED);
+  trace->events[i & trace->mask] = (SK_TraceEvent){
+    .time    = _sk_trace_now() - trace->t_start,
+    .node    = (uint64_t)(uintptr_t)node,
+    .step    = step,
+    .depth   = depth,
+    .s_alloc = s_alloc,
+    .rule    = (uint16_t)rule,
+    .thread  = _sk_trace_thread
+  };
+}
+
+uint64_t _sk_trace_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void _sk_trace_write_chrome(FILE* file, const SK_TraceEvent* events, uint32_t s_events) {
+  assert(file != NULL && events != NULL);
+
+  // a step lasts until the next event of its thread, so it is written once that one is seen
+  uint32_t* pending = (uint32_t*)calloc(1 << 16, sizeof(uint32_t));
+  assert(pending != NULL);
+
+  fprintf(file, "{ \"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+  bool first = true;
+  for (uint32_t i = 0; i < s_events; i++) {
+    const SK_TraceEvent* event = &events[i];
+    if (pending[event->thread] != 0) {
+      _sk_trace_write_step(file, &events[pending[event->thread] - 1], event->time, first);
+      pending[event->thread] = 0;
+      first = false;
+    }
+
+    if (event->rule <= SK_RULE_REF) {
+      pending[event->thread] = i + 1;
+      continue;
+    }
+    fprintf(
+      file, "%s\n  { \"name\": \"skt_beta_redu\", \"cat\": \"reduce\", \"ph\": \"%s\", \"ts\": %.3f, \"pid\": 1, \"tid\": %u,"
+      " \"args\": { \"root\": \"0x%lx\", \"steps\": %u } }",
+      first ? "" : ",", event->rule == SK_RULE_BEGIN ? "B" : "E", 1e-3 * event->time, event->thread,
+      (unsigned long)event->node, event->step
+    );
+    first = false;
+  }
+  // the last step of every thread has nothing after it to end it
+  for (uint32_t t = 0; t < (1u << 16); t++) {
+    if (pending[t] == 0)
+      continue;
+    const SK_TraceEvent* step = &events[pending[t] - 1];
+    _sk_trace_write_step(file, step, step->time, first);
+    first = false;
+  }
+  fprintf(file, "\n] }\n");
+
+  free(pending);
+}
+
+void _sk_trace_write_step(FILE* file, const SK_TraceEvent* step, uint64_t end, bool first) {
+  assert(file != NULL && step != NULL);
+
+  fprintf(
+    file, "%s\n  { \"name\": \"%s\", \"cat\": \"reduce\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u,"
+    " \"args\": { \"step\": %u, \"depth\": %u, \"node\": \"0x%lx\", \"alloc\": %d } }",
+    first ? "" : ",", _sk_rule_names[step->rule], 1e-3 * step->time, 1e-3 * (end - step->time), step->thread,
+    step->step, step->depth, (unsigned long)step->node, step->s_alloc
+  );
+}
+
+void _sk_trace_write_replay(FILE* file, const SK_TraceEvent* events, uint32_t s_events) {
+  assert(file != NULL && events != NULL);
+
+  fprintf(file, "%-14s %-7s %-6s %-8s %-8s %-20s %s\n", "time (us)", "thread", "rule", "step", "depth", "node", "alloc");
+  for (uint32_t i = 0; i < s_events; i++) {
+    const SK_TraceEvent* event = &events[i];
+    fprintf(
+      file, "%-14.3f %-7u %-6s %-8u %-8u 0x%-18lx %+d\n", 1e-3 * event->time, event->thread,
+      event->rule <= SK_RULE_END ? _sk_rule_names[event->rule] : "?", event->step, event->depth,
+      (unsigned long)event->node, event->s_alloc
+    );
+  }
+}
@@ -0,0 +1,249 @@
+#include "skwrite_priv.h"
+
+// ========================# PUBLIC #========================
+
+void skt_write(FILE* file, SK_Tree** roots, size_t s_roots) {
+  assert(file != NULL && roots != NULL);
+
+  SKW_Writer writer = {
+    .file   = file,
+    .index  = SK_INDEX_EMPTY,
+    .shares = NULL, .s_shares = 0, .capacity = 0,
+    .s_repeated = 0, .s_names = 0
+  };
+
+  // every share is counted before anything is written, a $N definition has to come before
+  // the first definition that uses it
+  for (size_t i = 0; i < s_roots; i++)
+    _skw_count(&writer, roots[i]);
+
+  for (size_t i = 0; i < s_roots; i++) {
+    if (writer.s_repeated > 0)
+      _skw_define(&writer, roots[i]);
+    fprintf(file, "%s = ", roots[i]->ld_ident->token->str);
+    _skw_write_expr(&writer, roots[i]);
+    fprintf(file, ";\n");
+  }
+
+  free(writer.shares);
+  _sk_index_free(&writer.index);
+}
+
+// ========================# PRIVATE #========================
+
+void _skw_count(SKW_Writer* writer, const SK_Tree* expr) {
+  assert(writer != NULL);
+
+  for (; expr != NULL; expr = expr->right) {
+    if (expr->type == APP_NODE) {
+      _skw_count(writer, expr->left);
+      continue;
+    }
+    if (expr->type != REF_NODE || expr->left->ld_ident != NULL)
+      return;
+
+    // what is inside a share is only written as often as the share itself
+    SKW_Share* share = _skw_share(writer, expr->left);
+    if (++share->s_uses == 2)
+      writer->s_repeated++;
+    if (share->s_uses == 1)
+      _skw_count(writer, expr->left);
+    return;
+  }
+}
+
+void _skw_define(SKW_Writer* writer, const SK_Tree* expr) {
+  assert(writer != NULL);
+
+  for (; expr != NULL; expr = expr->right) {
+    if (expr->type == APP_NODE) {
+      _skw_define(writer, expr->left);
+      continue;
+    }
+    if (expr->type != REF_NODE || expr->left->ld_ident != NULL)
+      return;
+
+    SKW_Share* share = _skw_share(writer, expr->left);
+    if (share->name != 0)
+      return;
+    if (share->s_uses < 2) {
+      _skw_define(writer, expr->left);
+      return;
+    }
+
+    // the shares it contains are defined first, they were all counted so none is added here
+    const SK_Tree* node = share->node;
+    _skw_define(writer, node);
+    share = _skw_share(writer, node);
+    share->name = ++writer->s_names;
+
+    fprintf(writer->file, "$%u = ", share->name);
+    _skw_write_expr(writer, node);
+    fprintf(writer->file, ";\n");
+    return;
+  }
+}
+
+void _skw_write_expr(SKW_Writer* writer, const SK_Tree* expr) {
+  assert(writer != NULL && expr != NULL);
+
+  switch (expr->type) {
+    case APP_NODE: {
+      // a bare S or K right after a name would read back as part of that name, &$N ends at its digits
+      bool ends_with_name = (
+           expr->left->type == LD_NODE
+        || (expr->left->type == REF_NODE && expr->left->left->ld_ident != NULL)
+      );
+      bool parens = (expr->right->type != S_NODE && expr->right->type != K_NODE) || ends_with_name;
+      _skw_write_expr(writer, expr->left);
+      if (parens)
+        putc('(', writer->file);
+      _skw_write_expr(writer, expr->right);
+      if (parens)
+        putc(')', writer->file);
+      break;
+    }
+    case REF_NODE: {
+      if (expr->left->ld_ident != NULL) {
+        putc('&', writer->file);
+        fputs(expr->left->ld_ident->token->str, writer->file);
+        break;
+      }
+      SKW_Share* share = _skw_share(writer, expr->left);
+      if (share->name != 0) {
+        fprintf(writer->file, "&$%u", share->name);
+        break;
+      }
+      fputs("&(", writer->file);
+      _skw_write_expr(writer, expr->left);
+      putc(')', writer->file);
+      break;
+    }
+    case LD_NODE: {
+      fputs(expr->ld_ident->token->str, writer->file);
+      break;
+    }
+    case K_NODE: {
+      putc('K', writer->file);
+      break;
+    }
+    case S_NODE: {
+      putc('S', writer->file);
+      break;
+    }
+  }
+}
+
+SKW_Share* _skw_share(SKW_Writer* writer, const SK_Tree* node) {
+  assert(writer != NULL && node != NULL);
+
+  // open addressing on the structural hash with linear probing, kept at most half full
+  if (2 * (writer->s_shares + 1) > writer->capacity) {
+    size_t     capacity = writer->capacity > 0 ? 2 * writer->capacity : 1 << 8;
+    SKW_Share* shares   = (SKW_Share*)calloc(capacity, sizeof(SKW_Share));
+    assert(shares != NULL);
+    for (size_t i = 0; i < writer->capacity; i++) {
+      if (writer->shares[i].node == NULL)
+        continue;
+      size_t j = (size_t)(writer->shares[i].hash >> 32) & (capacity - 1);
+      while (shares[j].node != NULL)
+        j = (j + 1) & (capacity - 1);
+      shares[j] = writer->shares[i];
+    }
+    free(writer->shares);
+    writer->shares   = shares;
+    writer->capacity = capacity;
+  }
+
+  uint64_t hash = _skw_hash(writer, node);
+  size_t   mask = writer->capacity - 1,
+           i    = (size_t)(hash >> 32) & mask;
+  for (; writer->shares[i].node != NULL; i = (i + 1) & mask)
+    if (writer->shares[i].hash == hash && _skw_equal(writer, writer->shares[i].node, node))
+      return &writer->shares[i];
+
+  writer->shares[i] = (SKW_Share){ .node = node, .hash = hash, .s_uses = 0, .name = 0 };
+  writer->s_shares++;
+  return &writer->shares[i];
+}
+
+uint64_t _skw_hash(SKW_Writer* writer, const SK_Tree* expr) {
+  assert(writer != NULL && expr != NULL);
+
+  // hashes what _skw_write_expr would write, a named reference is its name and a share its content
+  switch (expr->type) {
+    case S_NODE:
+    case K_NODE:
+      return _skw_mix(expr->type + 1, 0);
+    case LD_NODE:
+      return _skw_mix(LD_NODE + 1, _skw_hash_str(expr->ld_ident->token->str));
+    case APP_NODE:
+    case REF_NODE:
+      break;
+  }
+
+  uint64_t hash;
+  if (_sk_index_get(&writer->index, expr, &hash))
+    return hash;
+
+  if (expr->type == APP_NODE)
+    hash = _skw_mix(_skw_mix(APP_NODE + 1, _skw_hash(writer, expr->left)), _skw_hash(writer, expr->right));
+  else if (expr->left->ld_ident != NULL)
+    hash = _skw_mix(REF_NODE + 1, _skw_hash_str(expr->left->ld_ident->token->str));
+  else
+    hash = _skw_mix(LD_NODE + 2, _skw_hash(writer, expr->left));
+
+  _sk_index_put(&writer->index, expr, hash);
+  return hash;
+}
+
+uint64_t _skw_hash_str(const char* str) {
+  assert(str != NULL);
+
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (; *str != '\0'; str++)
+    hash = (hash ^ (uint8_t)*str) * 0x100000001b3ull;
+  return hash;
+}
+
+uint64_t _skw_mix(uint64_t hash, uint64_t value) {
+  hash = (hash ^ value) * 0x9e3779b97f4a7c15ull;
+  return hash ^ (hash >> 32);
+}
+
+bool _skw_equal(SKW_Writer* writer, const SK_Tree* a, const SK_Tree* b) {
+  assert(writer != NULL && a != NULL && b != NULL);
+
+  while (a != b) {
+    if (a->type != b->type || _skw_hash(writer, a) != _skw_hash(writer, b))
+      return false;
+
+    switch (a->type) {
+      case APP_NODE: {
+        if (!_skw_equal(writer, a->left, b->left))
+          return false;
+        a = a->right;
+        b = b->right;
+        continue;
+      }
+      case REF_NODE: {
+        if (a->left->ld_ident != NULL || b->left->ld_ident != NULL)
+          return (
+               a->left->ld_ident != NULL && b->left->ld_ident != NULL
+            && strcmp(a->left->ld_ident->token->str, b->left->ld_ident->token->str) == 0
+          );
+        a = a->left;
+        b = b->left;
+        continue;
+      }
+      case LD_NODE: {
+        return strcmp(a->ld_ident->token->str, b->ld_ident->token->str) == 0;
+      }
+      case S_NODE:
+      case K_NODE: {
+        return true;
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,41 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arena.h"
+
+// ========================# PUBLIC #========================
+
+// Hand written replacement for the flex lexer: the source is mmaped and whitespace, comments and
+// identifiers are skipped 16 bytes at a time. Tokens are slices of the mapping, their line and
+// column are only worked out when scanner_locate asks for them.
+typedef struct scanner Scanner;
+
+// token type of malformed input (an unterminated comment), bison's error token
+#define SC_ERROR 256
+
+typedef struct sc_token {
+  int32_t     type;  // TT_* token, 0 at the end of the input
+  const char* str;   // borrowed from the source, not NUL terminated
+  uint32_t    s_str;
+} SC_Token;
+
+// scanner_read scans a pipe or a terminal as it is written: the input is read into a reserved
+// mapping a line at a time, only as the scan runs out of it, so the source and the tokens keep
+// their address while it grows and scanner_get_source returns what has been read so far.
+Scanner*    scanner_open       (Arena, const char*);
+Scanner*    scanner_read       (Arena, int32_t, const char*);
+Scanner*    scanner_create     (Arena, const char*, size_t, const char*);
+void        scanner_close      (Scanner*);
+
+SC_Token    scanner_next       (Scanner*);
+void        scanner_locate     (Scanner*, const char*, uint32_t*, uint32_t*);
+const char* scanner_intern     (Scanner*, SC_Token);
+bool        scanner_failed     (Scanner*);
+const char* scanner_get_source (Scanner*, size_t*);
+
+#endif // !SCANNER_H
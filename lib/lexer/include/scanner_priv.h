@@ -0,0 +1,64 @@
+#ifndef SCANNER_PRIV_H
+#define SCANNER_PRIV_H
+
+#include "scanner.h"
+#include "parser.tab.h"
+
+#include <assert.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// ========================# PRIVATE #========================
+
+// address space reserved for a source read by scanner_read, and how much is read at once
+#define SC_MAX_STREAM (1ull << 32)
+#define SC_READ       (1u << 16)
+
+// The parser keeps identifier strings in the AST, so an identifier is copied into the arena the
+// first time it is seen and every later occurrence gets the same string back.
+typedef struct sc_intern {
+  const char* str;
+  uint32_t    s_str, hash;
+} SC_Intern;
+
+struct scanner {
+  Arena       arena;
+  const char* filename;
+  const char* source,
+            * cursor,
+            * end;
+  size_t      s_source, s_mapped;
+  bool        mapped, failed;
+  // scanner_read: the input, -1 once it ended, and the end of what was read, past the last newline
+  int32_t     fd;
+  const char* filled;
+  // newlines before counted are already folded into row, line is where the last counted one ended
+  const char* counted,
+            * line;
+  uint32_t    row;
+  SC_Intern*  interns;
+  size_t      s_interns, c_interns;
+};
+
+// bridge to the bison parser, yylex in lexer.x dispatches here when a scanner is open
+int32_t     scanner_lex            (Scanner*, YYSTYPE*, YYLTYPE*);
+
+const char* _scanner_skip_blank    (const char*, const char*);
+const char* _scanner_skip_ident    (const char*, const char*);
+const char* _scanner_skip_comment  (const char*, const char*);
+uint32_t    _scanner_count_lines   (const char*, const char*, const char**);
+int32_t     _scanner_keyword       (const char*, uint32_t);
+uint32_t    _scanner_hash          (const char*, uint32_t);
+void        _scanner_intern_grow   (Scanner*);
+bool        _scanner_fill          (Scanner*);
+
+#endif // !SCANNER_PRIV_H
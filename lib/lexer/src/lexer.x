@@ -1,9 +1,15 @@
 %{
 #include <unistd.h>
 #include "parser.tab.h"
+#include "scanner_priv.h"
 
-extern Arena arena;
+extern __thread Arena arena;
 int32_t current_column = 1;
+
+// yylex picks between this flex scanner and the mapped one in scanner.c, which is the only one
+// that can run on several threads at once
+__thread Scanner* scanner = NULL;
+#define YY_DECL int32_t flex_lex(YYSTYPE* yylval_param, YYLTYPE* yylloc_param)
 #define YY_USER_ACTION \
   yylloc->first_line   = yylineno; \
   yylloc->first_column = current_column; \
@@ -29,6 +35,7 @@ comment    ("//".*\n|"/*"([^*]|\*+[^*/])*\*+"/")
 %%
 
 "let"         { return TT_LET; }
+"import"      { return TT_IMPORT; }
 "="           { return TT_ASSIGN; }
 "\\"          { return TT_LAMBDA; }
 ","           { return TT_COMMA; }
@@ -45,3 +52,9 @@ comment    ("//".*\n|"/*"([^*]|\*+[^*/])*\*+"/")
 .             ;
 
 %%
+
+int32_t yylex(YYSTYPE* lval, YYLTYPE* lloc) {
+  if (scanner != NULL)
+    return scanner_lex(scanner, lval, lloc);
+  return flex_lex(lval, lloc);
+}
@@ -0,0 +1,433 @@
+#include "scanner_priv.h"
+
+#define SC_IS_IDENT_START(c) (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z') || (c) == '_')
+#define SC_IS_IDENT(c)       (SC_IS_IDENT_START(c) || ((c) >= '0' && (c) <= '9'))
+#define SC_IS_BLANK(c)       ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+// ========================# PUBLIC #========================
+
+Scanner* scanner_open(Arena arena, const char* filename) {
+  assert(arena != NULL && filename != NULL);
+
+  int32_t fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "[LEXER]: could not open %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    fprintf(stderr, "[LEXER]: could not stat %s - %s\n", filename, strerror(errno));
+    close(fd);
+    return NULL;
+  }
+
+  // an empty file cannot be mapped, it scans as an empty buffer
+  size_t s_source = (size_t)st.st_size;
+  if (s_source == 0) {
+    close(fd);
+    return scanner_create(arena, "", 0, filename);
+  }
+
+  const char* source = (const char*)mmap(NULL, s_source, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (source == MAP_FAILED) {
+    fprintf(stderr, "[LEXER]: could not map %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+  (void)madvise((void*)source, s_source, MADV_SEQUENTIAL);
+
+  Scanner* scanner = scanner_create(arena, source, s_source, filename);
+  scanner->mapped   = true;
+  scanner->s_mapped = s_source;
+  return scanner;
+}
+
+Scanner* scanner_read(Arena arena, int32_t fd, const char* filename) {
+  assert(arena != NULL && fd >= 0 && filename != NULL);
+
+  // only the pages that are read into are ever backed
+  const char* source = (const char*)mmap(NULL, SC_MAX_STREAM, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (source == MAP_FAILED) {
+    fprintf(stderr, "[LEXER]: could not reserve memory for %s - %s\n", filename, strerror(errno));
+    return NULL;
+  }
+
+  Scanner* scanner = scanner_create(arena, source, 0, filename);
+  scanner->mapped   = true;
+  scanner->s_mapped = SC_MAX_STREAM;
+  scanner->fd       = fd;
+  return scanner;
+}
+
+Scanner* scanner_create(Arena arena, const char* source, size_t s_source, const char* filename) {
+  assert(arena != NULL && source != NULL && filename != NULL);
+
+  Scanner* scanner = (Scanner*)malloc(sizeof(struct scanner));
+  assert(scanner != NULL);
+
+  *scanner = (Scanner){
+    .arena     = arena,
+    .filename  = filename,
+    .source    = source,
+    .cursor    = source,
+    .end       = source + s_source,
+    .s_source  = s_source,
+    .s_mapped  = 0,
+    .mapped    = false,
+    .failed    = false,
+    .fd        = -1,
+    .filled    = source + s_source,
+    .counted   = source,
+    .line      = source,
+    .row       = 1,
+    .interns   = NULL, .s_interns = 0, .c_interns = 0
+  };
+  return scanner;
+}
+
+void scanner_close(Scanner* scanner) {
+  if (scanner == NULL)
+    return;
+
+  if (scanner->mapped)
+    munmap((void*)scanner->source, scanner->s_mapped);
+  free(scanner->interns);
+  free(scanner);
+}
+
+SC_Token scanner_next(Scanner* scanner) {
+  assert(scanner != NULL);
+
+  const char* c   = scanner->cursor,
+            * end = scanner->end;
+
+  while (true) {
+    c = _scanner_skip_blank(c, end);
+    if (c >= end) {
+      if (_scanner_fill(scanner)) {
+        end = scanner->end;
+        continue;
+      }
+      scanner->cursor = end;
+      return (SC_Token){ .type = 0, .str = end, .s_str = 0 };
+    }
+
+    const char* start = c;
+    int32_t type = 0;
+
+    switch (*c) {
+      case '=':  type = TT_ASSIGN; c++; break;
+      case '\\': type = TT_LAMBDA; c++; break;
+      case ',':  type = TT_COMMA;  c++; break;
+      case '(':  type = TT_LPAREN; c++; break;
+      case ')':  type = TT_RPAREN; c++; break;
+      case ';':  type = TT_SEMI;   c++; break;
+      case '-': {
+        if (c + 1 < end && c[1] == '>') {
+          type = TT_ARROW;
+          c += 2;
+          break;
+        }
+        c++;
+        continue;
+      }
+      case '/': {
+        if (c + 1 < end && c[1] == '/') {
+          // a line comment may also end the file without a newline
+          const char* newline = (const char*)memchr(c + 2, '\n', (size_t)(end - c - 2));
+          c = newline != NULL ? newline : end;
+          continue;
+        }
+        if (c + 1 < end && c[1] == '*') {
+          c = _scanner_skip_comment(c + 2, end);
+          // the only token that spans lines, the rest of it may not have been read yet
+          if (c == NULL && _scanner_fill(scanner)) {
+            c   = start;
+            end = scanner->end;
+            continue;
+          }
+          if (c == NULL) {
+            uint32_t row = 0, column = 0;
+            scanner_locate(scanner, start, &row, &column);
+            fprintf(
+              stderr, "[LEXER]: unterminated comment at line %u column %u in file %s\n",
+              row, column, scanner->filename
+            );
+            scanner->failed = true;
+            scanner->cursor = end;
+            return (SC_Token){ .type = SC_ERROR, .str = start, .s_str = (uint32_t)(end - start) };
+          }
+          continue;
+        }
+        c++;
+        continue;
+      }
+      default: {
+        // like the flex rule '.', a character that starts no token is skipped
+        if (!SC_IS_IDENT_START(*c)) {
+          c++;
+          continue;
+        }
+        c = _scanner_skip_ident(c + 1, end);
+        type = _scanner_keyword(start, (uint32_t)(c - start));
+        break;
+      }
+    }
+
+    scanner->cursor = c;
+    return (SC_Token){ .type = type, .str = start, .s_str = (uint32_t)(c - start) };
+  }
+}
+
+void scanner_locate(Scanner* scanner, const char* at, uint32_t* row, uint32_t* column) {
+  assert(scanner != NULL && row != NULL && column != NULL);
+  assert(at >= scanner->source && at <= scanner->end);
+
+  // tokens are located in order, so the newline count only ever moves forward
+  if (at < scanner->counted) {
+    scanner->counted = scanner->source;
+    scanner->line    = scanner->source;
+    scanner->row     = 1;
+  }
+  scanner->row    += _scanner_count_lines(scanner->counted, at, &scanner->line);
+  scanner->counted = at;
+
+  *row    = scanner->row;
+  *column = (uint32_t)(at - scanner->line) + 1;
+}
+
+const char* scanner_intern(Scanner* scanner, SC_Token token) {
+  assert(scanner != NULL && token.str != NULL);
+
+  if (2 * (scanner->s_interns + 1) > scanner->c_interns)
+    _scanner_intern_grow(scanner);
+
+  uint32_t hash = _scanner_hash(token.str, token.s_str);
+  size_t mask = scanner->c_interns - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    SC_Intern* intern = &scanner->interns[i];
+    if (intern->str == NULL) {
+      char* str = (char*)arena_alloc(scanner->arena, token.s_str + 1);
+      assert(str != NULL);
+      memcpy(str, token.str, token.s_str);
+      str[token.s_str] = '\0';
+
+      *intern = (SC_Intern){ .str = str, .s_str = token.s_str, .hash = hash };
+      scanner->s_interns++;
+      return str;
+    }
+    if (intern->hash == hash && intern->s_str == token.s_str && memcmp(intern->str, token.str, token.s_str) == 0)
+      return intern->str;
+  }
+}
+
+bool scanner_failed(Scanner* scanner) {
+  assert(scanner != NULL);
+  return scanner->failed;
+}
+
+const char* scanner_get_source(Scanner* scanner, size_t* s_source) {
+  assert(scanner != NULL && s_source != NULL);
+  *s_source = scanner->s_source;
+  return scanner->source;
+}
+
+int32_t scanner_lex(Scanner* scanner, YYSTYPE* yylval, YYLTYPE* yylloc) {
+  assert(scanner != NULL && yylval != NULL && yylloc != NULL);
+
+  SC_Token token = scanner_next(scanner);
+
+  // the end of the input is reported as one column wide, like a token
+  uint32_t row = 0, column = 0;
+  scanner_locate(scanner, token.str, &row, &column);
+  yylloc->first_line   = (int32_t)row;
+  yylloc->first_column = (int32_t)column;
+  yylloc->last_line    = (int32_t)row;
+  yylloc->last_column  = (int32_t)(column + (token.s_str > 0 ? token.s_str : 1)) - 1;
+
+  if (token.type == TT_IDENTIFIER)
+    yylval->str = scanner_intern(scanner, token);
+  return token.type;
+}
+
+// ========================# PRIVATE #========================
+
+const char* _scanner_skip_blank(const char* c, const char* end) {
+  // most runs are a single space, only longer ones go to the vector loop
+  if (c < end && !SC_IS_BLANK(*c))
+    return c;
+
+#ifdef __SSE2__
+  const __m128i space   = _mm_set1_epi8(' '),
+                tab     = _mm_set1_epi8('\t'),
+                cr      = _mm_set1_epi8('\r'),
+                newline = _mm_set1_epi8('\n');
+  for (; c + 16 <= end; c += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i*)c);
+    __m128i blank = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+      _mm_or_si128(_mm_cmpeq_epi8(block, cr),    _mm_cmpeq_epi8(block, newline))
+    );
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(blank) ^ 0xffffu;
+    if (mask != 0)
+      return c + __builtin_ctz(mask);
+  }
+#endif
+
+  for (; c < end && SC_IS_BLANK(*c); c++);
+  return c;
+}
+
+const char* _scanner_skip_ident(const char* c, const char* end) {
+#ifdef __SSE2__
+  // (c | 0x20) - 'a' <= 25 catches both cases, unsigned compares are done as min(x, n) == x
+  const __m128i lower = _mm_set1_epi8(0x20),
+                alpha = _mm_set1_epi8('a'),
+                digit = _mm_set1_epi8('0'),
+                under = _mm_set1_epi8('_'),
+                n_alpha = _mm_set1_epi8(25),
+                n_digit = _mm_set1_epi8(9);
+  for (; c + 16 <= end; c += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i*)c);
+    __m128i a = _mm_sub_epi8(_mm_or_si128(block, lower), alpha),
+            d = _mm_sub_epi8(block, digit);
+    __m128i ident = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(a, n_alpha), a), _mm_cmpeq_epi8(_mm_min_epu8(d, n_digit), d)),
+      _mm_cmpeq_epi8(block, under)
+    );
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(ident) ^ 0xffffu;
+    if (mask != 0)
+      return c + __builtin_ctz(mask);
+  }
+#endif
+
+  for (; c < end && SC_IS_IDENT(*c); c++);
+  return c;
+}
+
+const char* _scanner_skip_comment(const char* c, const char* end) {
+  // memchr is already vectorised, a '*' is rare enough inside comments
+  while (c < end) {
+    const char* star = (const char*)memchr(c, '*', (size_t)(end - c));
+    if (star == NULL)
+      return NULL;
+    if (star + 1 < end && star[1] == '/')
+      return star + 2;
+    c = star + 1;
+  }
+  return NULL;
+}
+
+uint32_t _scanner_count_lines(const char* c, const char* end, const char** line) {
+  assert(line != NULL);
+
+  uint32_t s_lines = 0;
+#ifdef __SSE2__
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (; c + 16 <= end; c += 16) {
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)c), newline));
+    if (mask != 0) {
+      s_lines += (uint32_t)__builtin_popcount(mask);
+      *line = c + (31 - __builtin_clz(mask)) + 1;
+    }
+  }
+#endif
+
+  for (; c < end; c++) {
+    if (*c == '\n') {
+      s_lines++;
+      *line = c + 1;
+    }
+  }
+  return s_lines;
+}
+
+int32_t _scanner_keyword(const char* str, uint32_t s_str) {
+  // keywords are caseless like in lexer.x
+  if (s_str == 3 && strncasecmp(str, "let", 3) == 0)
+    return TT_LET;
+  if (s_str == 6 && strncasecmp(str, "import", 6) == 0)
+    return TT_IMPORT;
+  return TT_IDENTIFIER;
+}
+
+uint32_t _scanner_hash(const char* str, uint32_t s_str) {
+  // identifiers are short, so they are mixed eight bytes at a time instead of byte by byte
+  const uint64_t prime = 0x9e3779b97f4a7c15ull;
+  uint64_t hash = s_str * prime, word = 0;
+  for (; s_str >= 8; str += 8, s_str -= 8) {
+    memcpy(&word, str, 8);
+    hash = (hash ^ word) * prime;
+    hash ^= hash >> 32;
+  }
+  word = 0;
+  memcpy(&word, str, s_str);
+  hash = (hash ^ word) * prime;
+  return (uint32_t)(hash >> 32);
+}
+
+void _scanner_intern_grow(Scanner* scanner) {
+  assert(scanner != NULL);
+
+  size_t c_interns = scanner->c_interns > 0 ? 2 * scanner->c_interns : 1 << 8;
+  SC_Intern* interns = (SC_Intern*)calloc(c_interns, sizeof(SC_Intern));
+  assert(interns != NULL);
+
+  for (size_t i = 0; i < scanner->c_interns; i++) {
+    SC_Intern intern = scanner->interns[i];
+    if (intern.str == NULL)
+      continue;
+
+    size_t j = intern.hash & (c_interns - 1);
+    for (; interns[j].str != NULL; j = (j + 1) & (c_interns - 1));
+    interns[j] = intern;
+  }
+
+  free(scanner->interns);
+  scanner->interns   = interns;
+  scanner->c_interns = c_interns;
+}
+
+bool _scanner_fill(Scanner* scanner) {
+  assert(scanner != NULL);
+  if (scanner->fd < 0)
+    return false;
+
+  // whole lines only, so that no token is cut where a read ends; at the end of the input the last
+  // line is taken as it is
+  char* filled = (char*)scanner->filled;
+  const char* limit = scanner->source + SC_MAX_STREAM;
+  while (true) {
+    if (filled == limit) {
+      fprintf(stderr, "[LEXER]: %s is larger than %llu bytes\n", scanner->filename, (unsigned long long)SC_MAX_STREAM);
+      scanner->fd = -1;
+      break;
+    }
+    size_t s_read = (size_t)(limit - filled) < SC_READ ? (size_t)(limit - filled) : SC_READ;
+    ssize_t s_got = read(scanner->fd, filled, s_read);
+    if (s_got < 0 && errno == EINTR)
+      continue;
+    if (s_got < 0)
+      fprintf(stderr, "[LEXER]: could not read %s - %s\n", scanner->filename, strerror(errno));
+    if (s_got <= 0) {
+      scanner->fd = -1;
+      break;
+    }
+
+    filled += s_got;
+    const char* newline = (const char*)memrchr(filled - s_got, '\n', (size_t)s_got);
+    if (newline != NULL) {
+      scanner->filled   = filled;
+      scanner->end      = newline + 1;
+      scanner->s_source = (size_t)(scanner->end - scanner->source);
+      return true;
+    }
+  }
+
+  bool grown = scanner->end != filled;
+  scanner->filled   = filled;
+  scanner->end      = filled;
+  scanner->s_source = (size_t)(filled - scanner->source);
+  return grown;
+}
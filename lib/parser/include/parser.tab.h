@@ -23,6 +23,7 @@ enum yytokentype {
   TT_LPAREN     = 264,
   TT_RPAREN     = 265,
   TT_SEMI       = 266,
+  TT_IMPORT     = 267,
 
   // TT_LIT_NUMBER = 258,
   // TT_LIT_REAL   = 259,
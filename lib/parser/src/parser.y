@@ -7,16 +7,29 @@
 
 #include "arena.h"
 #include "ast.h"
+#include "diagnostics.h"
 #include "parser.tab.h"
 
-extern const char* filename;
+// the parse state is per thread, so that a driver can run one parse per thread (--batch)
+extern __thread const char* filename;
 
 extern uint32_t yylineno, yyleng, current_column;
-extern AST*  ast;
-extern Arena arena;
+extern __thread AST*  ast;
+extern __thread Arena arena;
 
 extern int32_t yylex(YYSTYPE* yylval, YYLTYPE* yylloc);
 void yyerror(YYLTYPE* yylloc, const char* error_msg);
+
+// When set, every statement is handed over as soon as its ';' is reduced and is not kept in the
+// AST, so a streaming driver never holds more than one statement. Returning false stops the parse.
+__thread bool (*parser_stmt_handler)(ASTN_Stmt*) = NULL;
+
+// Called with the module name of every `import name;`, the driver compiles or loads the module and
+// links its definitions into the table of the file being parsed. Returning false stops the parse.
+__thread bool (*parser_import_handler)(ASTN_Token*) = NULL;
+
+// syntax errors go into the driver's diagnostics when it sets them, otherwise straight to stderr
+__thread Diagnostics* parser_diagnostics = NULL;
 %}
 
 %define api.pure full
@@ -30,6 +43,7 @@ void yyerror(YYLTYPE* yylloc, const char* error_msg);
 %union {
   AST*        ast;
   ASTN_Stmt*  stmt;
+  struct { ASTN_Stmt* head, * tail; } stmts;
   ASTN_Expr*  expr;
   ASTN_Ident* id;
   ASTN_Token* token;
@@ -37,7 +51,7 @@ void yyerror(YYLTYPE* yylloc, const char* error_msg);
 }
 
 %type <ast>   lambda
-%type <stmt>  lambda_program
+%type <stmts> lambda_program
 %type <stmt>  lambda_stmt
 %type <expr>  lambda_expr
 %type <expr>  lambda_expr_app
@@ -46,7 +60,7 @@ void yyerror(YYLTYPE* yylloc, const char* error_msg);
 %type <id>    lambda_identifier
 %type <token> lambda_token
 
-%token TT_LET TT_IDENTIFIER TT_ASSIGN TT_LAMBDA TT_COMMA TT_ARROW TT_LPAREN TT_RPAREN TT_SEMI
+%token TT_LET TT_IDENTIFIER TT_ASSIGN TT_LAMBDA TT_COMMA TT_ARROW TT_LPAREN TT_RPAREN TT_SEMI TT_IMPORT
 
 %start lambda
 
@@ -55,21 +69,48 @@ void yyerror(YYLTYPE* yylloc, const char* error_msg);
 lambda:
     lambda_program
     { 
-      assert($1 != NULL);
-      ast = ast_create(arena, filename, $1); 
+      // head is only empty when the statements went to the handler or the file only imports
+      ast = ast_create(arena, filename, $1.head); 
     }
   ;
 
+// left recursive so that each statement is reduced as soon as it ends instead of at end of file
 lambda_program:
-    lambda_stmt lambda_program
-    { $$ = astn_add_stmt($1, $2); }
+    lambda_program lambda_stmt
+    {
+      $$ = $1;
+      if ($2 != NULL) {
+        if ($$.tail != NULL)
+          (void)astn_add_stmt($$.tail, $2);
+        else
+          $$.head = $2;
+        $$.tail = $2;
+      }
+    }
   | lambda_stmt
-    { $$ = $1; }
+    { $$.head = $$.tail = $1; }
   ;
 
 lambda_stmt:
     TT_LET lambda_identifier TT_ASSIGN lambda_expr TT_SEMI
-    { $$ = astn_create_stmt(arena, $2, $4, @1.first_line, @1.first_column, @5.last_line, @5.last_column); }
+    {
+      $$ = astn_create_stmt(arena, $2, $4, @1.first_line, @1.first_column, @5.last_line, @5.last_column);
+      if (parser_stmt_handler != NULL) {
+        if (!parser_stmt_handler($$))
+          YYABORT;
+        $$ = NULL;
+      }
+    }
+  | TT_IMPORT lambda_token TT_SEMI
+    {
+      if (parser_import_handler == NULL) {
+        yyerror(&@1, "import is not supported here");
+        YYABORT;
+      }
+      if (!parser_import_handler($2))
+        YYABORT;
+      $$ = NULL;
+    }
   ;
 
 lambda_expr:
@@ -114,26 +155,12 @@ lambda_token:
 void yyerror(YYLTYPE* yylloc, const char* error_msg) {
   assert(yylloc != NULL);
 
-  fprintf(stderr, "[PARSER]: %s in file %s at %u\n", error_msg, filename, yylloc->first_line);
-  FILE* file = fopen(filename, "r");
-  if (file == NULL) {
-    fprintf(stderr, "Error: Could not access or find the source file: %s\n", filename);
+  if (parser_diagnostics == NULL) {
+    fprintf(stderr, "[PARSER]: %s in file %s at %u\n", error_msg, filename, yylloc->first_line);
     return;
   }
-  char line[1024];
-  for (
-    int32_t current_line = 1;
-    fgets(line, sizeof(line), file) && current_line != yylloc->first_line;
-    current_line++
+  diagnostics_report(
+    parser_diagnostics, yylloc->first_line, yylloc->first_column, yylloc->last_column,
+    "[PARSER]: %s in file %s at %u", error_msg, filename, yylloc->first_line
   );
-  fclose(file);
-
-  fprintf(stderr, "%s", line);
-  for (int32_t i = 1; i < yylloc->first_column; i++)
-    fprintf(stderr, " ");
-  fprintf(stderr, "%s^", "\033[31m");
-  int32_t s_word = yylloc->last_column - yylloc->first_column + 1;
-  for (int32_t i = 1; i <= s_word; i++)
-    fprintf(stderr, "~");
-  fprintf(stderr, "%s\n", "\033[0m");
 }
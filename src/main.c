@@ -4,94 +4,1454 @@
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <setjmp.h>
 #include <assert.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include "parser.tab.h"
 #include "ast_priv.h"
 #include "interpreter.h"
+#include "skbin.h"
+#include "skimage.h"
+#include "skread.h"
+#include "skstats.h"
+#include "sktrace.h"
+#include "skprof.h"
+#include "skopt.h"
+#include "skeval.h"
+#include "sksuper.h"
+#include "sknet.h"
+#include "scanner.h"
+#include "diagnostics.h"
 
 extern FILE* yyin;
 extern int yylex_destroy(void);
+extern __thread Scanner* scanner;
+extern __thread bool (*parser_stmt_handler)(ASTN_Stmt*);
+extern __thread bool (*parser_import_handler)(ASTN_Token*);
+extern __thread Diagnostics* parser_diagnostics;
 
-const char* filename;
-Arena arena = NULL;
-AST*  ast   = NULL;
+__thread const char* filename;
+__thread Arena arena = NULL;
+__thread AST*  ast   = NULL;
+
+static const char* usage =
+  "usage: interpreter [options] file.ld\n"
+  "  --mem-limit=SIZE  abort cleanly once the arena reserves more than SIZE bytes (K, M, G suffixes)\n"
+  "  --hugepages       back the arena with huge pages (MAP_HUGETLB, falling back to MADV_HUGEPAGE)\n"
+  "  --arena-stats=FILE  write arena usage per allocation tag as JSON to FILE ('-' for stdout)\n"
+  "  --binary          also write the reduced program as a binary file.skb\n"
+  "  --entry=NAME      only convert and reduce the definitions NAME refers to, directly or not (repeatable)\n"
+  "  --image=FILE      start from the definitions of a heap image (.ski), mapped instead of compiled\n"
+  "  --save-image=FILE write every definition of the run, the linked ones included, as a heap image to FILE\n"
+  "  --flex            lex with the flex scanner through stdio instead of mapping the source\n"
+  "  --stream          check, convert, reduce and write every statement as soon as it is parsed\n"
+  "  --no-peephole     reduce converted terms as they are, without the peephole rewrites\n"
+  "  --compact=MODE    copy the live SK graph of a statement depth first into a fresh region: off\n"
+  "                    (the default), convert (after conversion) or phases (also after reduction)\n"
+  "  --backend=NAME    sk (convert, then reduce S and K), krivine (evaluate the lambda terms, then convert)\n"
+  "                    super (lambda lift into supercombinators, reduce the graph, then convert)\n"
+  "                    or net (reduce an interaction net on --jobs threads, then convert)\n"
+  "  --stats           print the time of every phase, node counts, reduction steps and arena usage\n"
+  "  --stats-json=FILE write the same statistics as JSON to FILE ('-' for stdout)\n"
+  "  --trace=FILE      record every reduction step in a ring buffer and dump it to FILE (.sktrace)\n"
+  "  --trace-events=N  size of the trace ring buffer in events (K, M suffixes), the oldest are overwritten\n"
+  "  --replay          with a file.sktrace, list the steps instead of writing a Chrome trace\n"
+  "  --profile=FILE    charge reduction steps to the .ld expressions they come from, as folded stacks\n"
+  "  --profile-alloc   weigh the profile by bytes allocated instead of reduction steps\n"
+  "  --batch           compile every .ld file given, and every one under the directories given, on a thread pool\n"
+  "  --jobs=N          number of --batch worker threads, or of --backend=net ones (default: online CPUs)\n"
+  "  `import name;` links the definitions of name.ld, next to the importing file, compiled once into name.skb\n"
+  "  a file.sk or file.skb is loaded directly, skipping parsing and conversion\n"
+  "  a file named - is read from standard input as it is written, every statement is written to standard output\n"
+  "  as soon as it is parsed, like --stream\n"
+  "  a file.sktrace is converted to a Chrome trace (chrome://tracing, Perfetto) on stdout\n";
+
+// dumped at exit, so that a run stopped by _arena_oom still leaves its trace behind
+static const char* trace_path = NULL;
+
+// the program is read from standard input and its SK written to standard output, with --stream
+static bool from_stdin = false;
+
+// --entry, only the definitions these reach are converted and reduced
+static const char** entries   = NULL;
+static size_t       s_entries = 0;
+
+// --backend, all of them give the reduced SK roots of a checked and resolved AST
+typedef SK_Tree** (*Backend)(Arena, AST*, HashTable, Diagnostics*);
+static const struct {
+  const char* name;
+  Backend     convert;
+} backends[] = {
+  { "sk",      ast_convert      },
+  { "krivine", ast_evaluate     },
+  { "super",   ast_supercombine },
+  { "net",     ast_interact     }
+};
+static Backend backend = ast_convert;
+
+// errors of every phase are collected here and printed when the phase is over
+static Diagnostics* diagnostics = NULL;
+
+// --stream keeps the reduced definitions and the symbol table, every AST is dropped after its statement
+static struct {
+  Arena     defs, scratch;
+  ArenaMark mark;
+  HashTable table;
+  FILE*     outfile;
+  SK_Tree** roots;
+  size_t    s_roots, c_roots;
+  bool      keep_roots;
+} stream;
+
+// every imported module is compiled or loaded from its cache once per run and kept until exit
+typedef struct module {
+  char*      path;
+  uint64_t   hash;    // of the source, mixed with the hashes of the modules it imports
+  SK_Tree**  roots;
+  size_t     s_roots;
+  SKB_Image* image;   // the names of cached definitions point into it, so it stays mapped
+  bool       loading; // importing it while it is still being compiled is a cycle
+} Module;
+
+// the table the file being parsed links its imports into and the modules it has imported so far
+typedef struct module_link {
+  HashTable* table;
+  SKB_Dep*   deps;
+  size_t     s_deps, c_deps;
+} ModuleLink;
+
+// per thread, every --batch job links against modules of its own
+static __thread struct {
+  Arena       arena;
+  Module**    list;
+  size_t      s_list, c_list;
+  ModuleLink  program;
+  ModuleLink* link;
+  HashMap     written;
+  SKI_Image*  image;  // --image, its statements are linked into the program's table as they are
+  SK_Tree**   linked; // every definition linked into the program's table, for --save-image
+  size_t      s_linked, c_linked;
+} modules;
+
+// --batch: every file is a job with its own arena and parser state, workers take the next job
+// with one atomic increment and the results are reported in order once all of them are done
+typedef struct batch_job {
+  char*  path;
+  bool   ok;
+  size_t s_defs, s_errors;
+  double t_compile;
+  char*  log; // what the job reported, printed with its result so that jobs do not interleave
+  size_t s_log;
+} BatchJob;
+
+static struct {
+  BatchJob* jobs;
+  size_t    s_jobs, c_jobs;
+  size_t    next;
+  uint64_t  s_limit;
+  uint32_t  arena_flags;
+  bool      write_binary;
+} batch;
+
+// where _arena_oom takes a worker whose job went over --mem-limit, so that only that job fails
+static __thread jmp_buf* batch_oom = NULL;
+static __thread FILE*    batch_log = NULL;
+
+static bool _open_source(Arena arena, bool use_flex);
+static void _extend_source(void);
+static bool _stream_stmt(ASTN_Stmt* stmt);
+static bool _select_entries(HashTable table);
+static bool _import_module(ASTN_Token* name);
+static void _link_image(HashTable* table);
+static void _keep_linked(SK_Tree* root);
+static bool _save_image(const char* path, SK_Tree** roots, size_t s_roots);
+static Module* _load_module(const char* path);
+static bool _load_module_cache(Module* module, uint64_t hash);
+static bool _compile_module(Module* module, Scanner* source, uint64_t hash);
+static void _write_module_cache(Module* module, uint64_t hash, ModuleLink* link);
+static void _write_imported(FILE* file, SK_Tree* expr);
+static char* _temp_path(const char* path);
+static void _free_modules(void);
+static char* _module_path(const char* importer, const char* name);
+static uint64_t _hash_source(const char* source, size_t s_source);
+static uint64_t _hash_mix(uint64_t hash, uint64_t value);
+static bool _run_batch(char** paths, size_t s_paths, uint64_t s_jobs);
+static bool _batch_add(const char* path);
+static void* _batch_worker(void* arg);
+static void _batch_compile(BatchJob* job);
+static void _batch_translate(BatchJob* job, FILE* log, Diagnostics* errors, HashTable* table);
+static int32_t _batch_compare(const void* a, const void* b);
+static double _now(void);
+static bool _parse_size(const char* str, uint64_t* size);
+static void _arena_oom(Arena arena, uint64_t s_alloc);
+static void _write_arena_stats(const char* path);
+static void _write_stats(bool print, const char* path);
+static void _write_trace(void);
+static void _write_profile(const char* path, bool alloc);
+static char* _replace_extension(const char* filename, const char* extension);
+static bool  _has_extension(const char* filename, const char* extension);
 
 int32_t main(int32_t argc, char* argv[]) {
-  if (argc < 2) {
+  uint64_t s_limit = 0;
+  uint32_t arena_flags = 0;
+  const char* arena_stats = NULL,
+            * stats_json  = NULL,
+            * profile     = NULL,
+            * image_path  = NULL,
+            * save_image  = NULL;
+  bool write_binary  = false,
+       use_flex      = false,
+       streaming     = false,
+       print_stats   = false,
+       replay        = false,
+       profile_alloc = false,
+       use_batch     = false;
+  uint64_t s_trace = 1 << 18,
+           s_jobs  = (uint64_t)sysconf(_SC_NPROCESSORS_ONLN);
+
+  const struct option options[] = {
+    { "mem-limit",     required_argument, NULL, 'm' },
+    { "hugepages",     no_argument,       NULL, 'H' },
+    { "arena-stats",   required_argument, NULL, 'A' },
+    { "binary",        no_argument,       NULL, 'b' },
+    { "entry",         required_argument, NULL, 'N' },
+    { "image",         required_argument, NULL, 'i' },
+    { "save-image",    required_argument, NULL, 'I' },
+    { "flex",          no_argument,       NULL, 'F' },
+    { "stream",        no_argument,       NULL, 's' },
+    { "no-peephole",   no_argument,       NULL, 'O' },
+    { "compact",       required_argument, NULL, 'C' },
+    { "backend",       required_argument, NULL, 'e' },
+    { "stats",         no_argument,       NULL, 'S' },
+    { "stats-json",    required_argument, NULL, 'J' },
+    { "trace",         required_argument, NULL, 'T' },
+    { "trace-events",  required_argument, NULL, 'E' },
+    { "replay",        no_argument,       NULL, 'R' },
+    { "profile",       required_argument, NULL, 'P' },
+    { "profile-alloc", no_argument,       NULL, 'a' },
+    { "batch",         no_argument,       NULL, 'B' },
+    { "jobs",          required_argument, NULL, 'j' },
+    { "help",          no_argument,       NULL, 'h' },
+    { NULL,            0,                 NULL,  0  }
+  };
+
+  for (int32_t opt; (opt = getopt_long(argc, argv, "h", options, NULL)) != -1;) {
+    switch (opt) {
+      case 'm': {
+        if (!_parse_size(optarg, &s_limit)) {
+          fprintf(stderr, "[ERROR]: invalid memory limit '%s'\n", optarg);
+          return 1;
+        }
+        break;
+      }
+      case 'H': {
+        arena_flags |= ARENA_HUGEPAGES;
+        break;
+      }
+      case 'A': {
+        arena_stats = optarg;
+        break;
+      }
+      case 'b': {
+        write_binary = true;
+        break;
+      }
+      case 'N': {
+        entries = (const char**)realloc(entries, (s_entries + 1) * sizeof(const char*));
+        assert(entries != NULL);
+        entries[s_entries++] = optarg;
+        break;
+      }
+      case 'i': {
+        image_path = optarg;
+        break;
+      }
+      case 'I': {
+        save_image = optarg;
+        break;
+      }
+      case 'F': {
+        use_flex = true;
+        break;
+      }
+      case 's': {
+        streaming = true;
+        break;
+      }
+      case 'O': {
+        sk_opt_disable();
+        break;
+      }
+      case 'C': {
+        const char* modes[] = { "off", "convert", "phases" };
+        size_t i = 0;
+        for (; i < sizeof(modes) / sizeof(modes[0]) && strcmp(modes[i], optarg) != 0; i++);
+        if (i == sizeof(modes) / sizeof(modes[0])) {
+          fprintf(stderr, "[ERROR]: unknown compaction '%s', expected off, convert or phases\n", optarg);
+          return 1;
+        }
+        skt_set_compact((SK_Compact)i);
+        break;
+      }
+      case 'e': {
+        size_t i = 0;
+        for (; i < sizeof(backends) / sizeof(backends[0]) && strcmp(backends[i].name, optarg) != 0; i++);
+        if (i == sizeof(backends) / sizeof(backends[0])) {
+          fprintf(stderr, "[ERROR]: unknown backend '%s', expected sk, krivine, super or net\n", optarg);
+          return 1;
+        }
+        backend = backends[i].convert;
+        break;
+      }
+      case 'S': {
+        print_stats = true;
+        break;
+      }
+      case 'J': {
+        stats_json = optarg;
+        break;
+      }
+      case 'T': {
+        trace_path = optarg;
+        break;
+      }
+      case 'E': {
+        if (!_parse_size(optarg, &s_trace) || s_trace == 0 || s_trace > UINT32_MAX) {
+          fprintf(stderr, "[ERROR]: invalid number of trace events '%s'\n", optarg);
+          return 1;
+        }
+        break;
+      }
+      case 'R': {
+        replay = true;
+        break;
+      }
+      case 'P': {
+        profile = optarg;
+        break;
+      }
+      case 'a': {
+        profile_alloc = true;
+        break;
+      }
+      case 'B': {
+        use_batch = true;
+        break;
+      }
+      case 'j': {
+        if (!_parse_size(optarg, &s_jobs) || s_jobs == 0 || s_jobs > 1024) {
+          fprintf(stderr, "[ERROR]: invalid number of jobs '%s'\n", optarg);
+          return 1;
+        }
+        break;
+      }
+      case 'h': {
+        fprintf(stdout, "%s", usage);
+        return 0;
+      }
+      default: {
+        fprintf(stderr, "%s", usage);
+        return 1;
+      }
+    }
+  }
+
+  if (optind >= argc) {
     fprintf(stderr, "[ERROR]: no file was passed as argument\n");
     return 1;
   }
 
-  size_t s_filename = strlen(argv[1]);
-  if (s_filename < 4) {
-    fprintf(stderr, "[ERROR]: filename must have the following regular expression '*.lb'\n");
+  // nothing is known of the input before it is read, a pipeline gets every statement as it is done
+  from_stdin = strcmp(argv[optind], "-") == 0 && !use_batch;
+  streaming |= from_stdin;
+  if (from_stdin && (use_flex || write_binary)) {
+    fprintf(stderr, "[ERROR]: standard input cannot be combined with --flex or --binary\n");
     return 1;
   }
 
-  filename = argv[1];
-  const char file_type[3] = {
-    filename[s_filename - 3],
-    filename[s_filename - 2],
-    filename[s_filename - 1]
-  };
-
-  if (strcmp(file_type, ".ld")) {
-    fprintf(stderr, "[ERROR]: filename must have the following regular expression '*.lb'\n");
+  if (streaming && s_entries > 0) {
+    // a streamed statement is compiled before anything after it can refer to it
+    fprintf(stderr, "[ERROR]: --entry cannot be combined with --stream or standard input\n");
     return 1;
   }
 
-  yyin = fopen(filename, "r");
-  if (yyin == NULL) {
-    fprintf(stderr, "[ERROR]: could not open input file %s - %s\n", filename, strerror(errno));
+  if (streaming && backend != ast_convert) {
+    // the machines share evaluated definitions with the later ones, a statement is not done on its own
+    fprintf(stderr, "[ERROR]: --stream and standard input only work with --backend=sk\n");
     return 1;
   }
 
-  const size_t s_arena = 1 << 20, max_nodes = 5;
-  arena = arena_create_aligned(s_arena, MAX_SIZE, max_nodes);
-  assert(arena != NULL);
+  // a batch already keeps every CPU busy with files, each net is reduced on the thread of its file
+  skn_set_threads(use_batch ? 1 : (uint32_t)s_jobs);
 
-  yyparse();
-  if (ast == NULL) {
-    fprintf(stderr, "[ERROR]: could not parse input file %s\n", filename);
-    arena_destroy(arena);
-    yylex_destroy();
+  if (use_batch) {
+    // the statistics and the profile are global, flex is not reentrant and streaming is per file
+    if (
+         streaming || use_flex || print_stats || stats_json != NULL || profile != NULL || arena_stats != NULL
+      || image_path != NULL || save_image != NULL || s_entries > 0
+    ) {
+      fprintf(stderr, "[ERROR]: --batch cannot be combined with --stream, --flex, --stats, --profile, --arena-stats, --entry or the heap image options\n");
+      return 1;
+    }
+    if (trace_path != NULL) {
+      if (!sk_trace_enable((uint32_t)s_trace)) {
+        fprintf(stderr, "[ERROR]: could not allocate a trace of %zu events\n", s_trace);
+        return 1;
+      }
+      atexit(_write_trace);
+    }
+    batch.s_limit      = s_limit;
+    batch.arena_flags  = arena_flags;
+    batch.write_binary = write_binary;
+    return _run_batch(argv + optind, (size_t)(argc - optind), s_jobs) ? 0 : 1;
+  }
+
+  // imports of a program read from standard input are looked up in the working directory
+  filename = from_stdin ? "<stdin>" : argv[optind];
+  if (_has_extension(filename, ".sktrace"))
+    return sk_trace_convert(filename, stdout, replay) ? 0 : 1;
+
+  bool is_binary = _has_extension(filename, ".skb"),
+       is_text   = _has_extension(filename, ".sk");
+  if (!from_stdin && !is_binary && !is_text && !_has_extension(filename, ".ld")) {
+    fprintf(stderr, "[ERROR]: filename must have the following regular expression '*.ld', '*.sk' or '*.skb'\n");
+    return 1;
+  }
+  if ((image_path != NULL || s_entries > 0) && (is_binary || is_text)) {
+    // a loaded program refers to the definitions it was compiled with, not to the image's
+    fprintf(stderr, "[ERROR]: --image and --entry only work with a .ld program\n");
     return 1;
   }
 
-  const size_t s_table = 1 << 5;
-  HashTable table = ast_check(ast, s_table);
-  if (table == NULL) {
-    fprintf(stderr, "[ERROR]: failed AST check of file %s\n", filename);
+  const size_t s_arena = 1 << 20;
+  arena = arena_create_growable(s_arena, MAX_SIZE, s_limit, arena_flags);
+  if (arena == NULL) {
+    fprintf(stderr, "[ERROR]: could not reserve the arena within the memory limit of %zu bytes\n", s_limit);
+    return 1;
+  }
+  arena_set_oom_handler(arena, _arena_oom);
+  if (arena_stats != NULL)
+    (void)arena_stats_enable(arena);
+  if (print_stats || stats_json != NULL)
+    sk_stats_enable();
+  if (profile != NULL && !sk_profile_enable()) {
+    fprintf(stderr, "[ERROR]: could not allocate the profile\n");
+    arena_destroy(arena);
+    return 1;
+  }
+  if (trace_path != NULL) {
+    if (!sk_trace_enable((uint32_t)s_trace)) {
+      fprintf(stderr, "[ERROR]: could not allocate a trace of %zu events\n", s_trace);
+      arena_destroy(arena);
+      return 1;
+    }
+    atexit(_write_trace);
+  }
+  atexit(_free_modules);
+  if (image_path != NULL && (modules.image = ski_load(image_path)) == NULL) {
+    fprintf(stderr, "[ERROR]: could not load heap image %s\n", image_path);
     arena_destroy(arena);
-    yylex_destroy();
     return 1;
+  }
+
+  HashTable  table = NULL;
+  SKB_Image* image = NULL;
+  SK_Tree**  roots = NULL;
+  size_t   s_roots = 0;
+
+  if (is_binary) {
+    image = skb_load(filename);
+    roots = image != NULL ? skb_get_roots(arena, image) : NULL;
+    if (roots == NULL) {
+      fprintf(stderr, "[ERROR]: could not load binary SK program %s\n", filename);
+      skb_unload(image);
+      arena_destroy(arena);
+      return 1;
+    }
+    s_roots = skb_get_size_roots(image);
+  } else if (is_text) {
+    roots = skt_read(arena, filename, &s_roots);
+    if (roots == NULL) {
+      fprintf(stderr, "[ERROR]: could not read SK program %s\n", filename);
+      arena_destroy(arena);
+      return 1;
+    }
+
+    // a hand written .sk may not be in normal form yet, the output of skt_write always is
+    for (size_t i = 0; i < s_roots; i++) {
+      ASTN_Ident* ident = roots[i]->ld_ident;
+      roots[i] = skt_beta_redu(arena, roots[i]);
+      roots[i]->ld_ident = ident;
+    }
+  } else if (streaming) {
+    char* outfilename = _replace_extension(filename, ".sk");
+    stream.outfile    = from_stdin ? stdout : fopen(outfilename, "w");
+    stream.defs       = arena_shard_create(arena);
+    stream.scratch    = arena_shard_create(arena);
+    stream.table      = hashtable_create(1 << 5, .75);
+    stream.keep_roots = write_binary || save_image != NULL;
+    if (stream.outfile == NULL)
+      fprintf(stderr, "[ERROR]: could not open output file %s - %s\n", outfilename, strerror(errno));
+    free(outfilename);
+
+    (void)arena_tag(arena, TAG_LEXER);
+    diagnostics = diagnostics_create(filename);
+    parser_diagnostics = diagnostics;
+    if (stream.outfile == NULL || stream.defs == NULL || stream.scratch == NULL || !_open_source(stream.defs, use_flex)) {
+      if (stream.outfile != NULL && stream.outfile != stdout)
+        fclose(stream.outfile);
+      hashtable_free(stream.table);
+      diagnostics_destroy(diagnostics);
+      arena_destroy(arena);
+      return 1;
+    }
+
+    // the AST of a statement is everything allocated in the arena after this mark
+    stream.mark = arena_mark(arena);
+    parser_stmt_handler = _stream_stmt;
+    modules.program.table = &stream.table;
+    _link_image(&stream.table);
+    parser_import_handler = _import_module;
+    sk_stats_begin(SK_PHASE_PARSE);
+    int32_t parsed = yyparse();
+    sk_stats_end(SK_PHASE_PARSE);
+    _extend_source();
+    (void)diagnostics_flush(diagnostics, stderr);
+    if (stream.outfile != stdout)
+      fclose(stream.outfile);
+
+    table   = stream.table;
+    roots   = stream.roots;
+    s_roots = stream.s_roots;
+    if (parsed != 0) {
+      fprintf(stderr, "[ERROR]: could not parse input file %s\n", filename);
+      hashtable_free(table);
+      free(roots);
+      scanner_close(scanner);
+      diagnostics_destroy(diagnostics);
+      arena_destroy(arena);
+      yylex_destroy();
+      return 1;
+    }
   } else {
-    fprintf(stdout, "Successfully checked AST\n");
+    (void)arena_tag(arena, TAG_LEXER);
+    diagnostics = diagnostics_create(filename);
+    parser_diagnostics = diagnostics;
+    if (!_open_source(arena, use_flex)) {
+      diagnostics_destroy(diagnostics);
+      arena_destroy(arena);
+      return 1;
+    }
+
+    // imports are linked into the table while parsing, the statements are checked against it after
+    const size_t s_table = 1 << 5;
+    table = hashtable_create(s_table, .75);
+    modules.program.table = &table;
+    _link_image(&table);
+    parser_import_handler = _import_module;
+    sk_stats_begin(SK_PHASE_PARSE);
+    yyparse();
+    sk_stats_end(SK_PHASE_PARSE);
+    (void)diagnostics_flush(diagnostics, stderr);
+
+    if (ast == NULL) {
+      fprintf(stderr, "[ERROR]: could not parse input file %s\n", filename);
+      hashtable_free(table);
+      scanner_close(scanner);
+      diagnostics_destroy(diagnostics);
+      arena_destroy(arena);
+      yylex_destroy();
+      return 1;
+    }
+
+    sk_stats_begin(SK_PHASE_CHECK);
+    table = ast_check_linked(ast, table, diagnostics);
+    sk_stats_end(SK_PHASE_CHECK);
+    (void)diagnostics_flush(diagnostics, stderr);
+    if (table == NULL) {
+      fprintf(stderr, "[ERROR]: failed AST check of file %s\n", filename);
+      scanner_close(scanner);
+      diagnostics_destroy(diagnostics);
+      arena_destroy(arena);
+      yylex_destroy();
+      return 1;
+    } else {
+      fprintf(stdout, "Successfully checked AST\n");
+    }
+
+    sk_stats_begin(SK_PHASE_TRANSFORM);
+    ast_transform(arena, ast);
+    ast_resolve(ast, table);
+    sk_stats_end(SK_PHASE_TRANSFORM);
+    if (s_entries > 0 && !_select_entries(table)) {
+      hashtable_free(table);
+      scanner_close(scanner);
+      diagnostics_destroy(diagnostics);
+      arena_destroy(arena);
+      yylex_destroy();
+      return 1;
+    }
+    ast_print(ast);
+
+    for (ASTN_Stmt* stmt = ast->stmts; stmt != NULL; stmt = stmt->next)
+      sk_stats_count_stmt(stmt);
+    s_roots = ast->s_stmts;
+    sk_stats_begin(SK_PHASE_CONVERT);
+    roots = backend(arena, ast, table, diagnostics);
+    sk_stats_end(SK_PHASE_CONVERT);
+    (void)diagnostics_flush(diagnostics, stderr);
+    for (size_t i = 0; roots != NULL && i < s_roots; i++)
+      sk_stats_count_root(roots[i]);
   }
 
-  ast_transform(arena, ast);
-  ast_print(ast);
+  if (!streaming)
+    skt_print(roots, s_roots);
 
-  size_t s_roots = ast->s_stmts;
-  SK_Tree** roots = ast_convert(arena, ast, table);
+  if (!is_text && !streaming) {
+    char* outfilename = _replace_extension(filename, ".sk");
+    FILE* outfile = fopen(outfilename, "w");
+    sk_stats_begin(SK_PHASE_WRITE);
+    for (size_t i = 0; (modules.arena != NULL || modules.image != NULL) && i < s_roots; i++)
+      _write_imported(outfile, roots[i]);
+    skt_write(outfile, roots, s_roots);
+    sk_stats_end(SK_PHASE_WRITE);
 
-  skt_print(roots, s_roots);
+    fclose(outfile);
+    free(outfilename);
+  }
 
-  size_t s_outfilename = s_filename;
-  char* outfilename = strdup(filename);
-  outfilename[s_outfilename - 2] = 's';
-  outfilename[s_outfilename - 1] = 'k';
-  
-  FILE* outfile = fopen(outfilename, "w");
-  skt_write(outfile, roots, s_roots);
+  if (write_binary && !is_binary) {
+    char* binfilename = _replace_extension(filename, ".skb");
+    FILE* binfile = fopen(binfilename, "wb");
+    if (binfile == NULL || !skb_write(binfile, roots, s_roots))
+      fprintf(stderr, "[ERROR]: could not write binary SK program %s - %s\n", binfilename, strerror(errno));
+    if (binfile != NULL)
+      fclose(binfile);
+    free(binfilename);
+  }
 
-  fclose(outfile);
-  free(outfilename);
+  if (save_image != NULL && !_save_image(save_image, roots, s_roots))
+    fprintf(stderr, "[ERROR]: could not write heap image %s - %s\n", save_image, strerror(errno));
 
-  hashtable_free(table);
+  if (arena_stats != NULL)
+    _write_arena_stats(arena_stats);
+  _write_stats(print_stats, stats_json);
+  if (profile != NULL)
+    _write_profile(profile, profile_alloc);
+
+  if (table != NULL)
+    hashtable_free(table);
+  if (streaming)
+    free(roots);
+  // diagnostics borrow the mapped source, so the scanner is only closed at the very end
+  scanner_close(scanner);
+  diagnostics_destroy(diagnostics);
   arena_destroy(arena);
+  skb_unload(image);
   yylex_destroy();
 
   return 0;
 }
+
+static bool _open_source(Arena arena, bool use_flex) {
+  assert(arena != NULL);
+
+  if (use_flex) {
+    yyin = fopen(filename, "r");
+    if (yyin == NULL) {
+      fprintf(stderr, "[ERROR]: could not open input file %s - %s\n", filename, strerror(errno));
+      return false;
+    }
+    return true;
+  }
+
+  // the scanner interns identifiers into arena, which has to outlive the parse
+  scanner = from_stdin ? scanner_read(arena, STDIN_FILENO, filename) : scanner_open(arena, filename);
+  if (scanner == NULL) {
+    fprintf(stderr, "[ERROR]: could not open input file %s\n", filename);
+    return false;
+  }
+
+  size_t s_source = 0;
+  const char* source = scanner_get_source(scanner, &s_source);
+  diagnostics_set_source(diagnostics, source, s_source);
+  return true;
+}
+
+static void _extend_source(void) {
+  if (!from_stdin || scanner == NULL)
+    return;
+
+  // standard input is still being read while its errors are printed, they can only be on what was
+  size_t s_source = 0;
+  (void)scanner_get_source(scanner, &s_source);
+  diagnostics_extend_source(diagnostics, s_source);
+}
+
+static bool _stream_stmt(ASTN_Stmt* stmt) {
+  assert(stmt != NULL);
+
+  // the table and the references of later statements point to this copy, not to the AST
+  ASTN_Stmt* def = astn_create_stmt(
+    stream.defs, astn_copy_ident(stream.defs, stmt->var), stmt->expr,
+    stmt->frow, stmt->fcol, stmt->erow, stmt->ecol
+  );
+  // the statement is handled from inside yyparse, its phases are taken out of the parse time
+  sk_stats_end(SK_PHASE_PARSE);
+  sk_stats_begin(SK_PHASE_CHECK);
+  (void)ast_check_stmt(&stream.table, def, diagnostics);
+  sk_stats_end(SK_PHASE_CHECK);
+  sk_stats_begin(SK_PHASE_TRANSFORM);
+  ast_transform_stmt(arena, def);
+  ast_resolve_stmt(def, stream.table);
+  sk_stats_end(SK_PHASE_TRANSFORM);
+
+  sk_stats_count_stmt(def);
+  sk_stats_begin(SK_PHASE_CONVERT);
+  SK_Tree* root = ast_convert_stmt(stream.defs, stream.scratch, def, stream.table, diagnostics);
+  sk_stats_end(SK_PHASE_CONVERT);
+  _extend_source();
+  (void)diagnostics_flush(diagnostics, stderr);
+  sk_stats_count_root(root);
+  def->expr = NULL;
+  sk_stats_begin(SK_PHASE_WRITE);
+  if (modules.arena != NULL || modules.image != NULL)
+    _write_imported(stream.outfile, root);
+  skt_write(stream.outfile, &root, 1);
+  // the next stage of a pipeline gets the statement now, not when the buffer fills
+  if (from_stdin)
+    fflush(stream.outfile);
+  sk_stats_end(SK_PHASE_WRITE);
+
+  if (stream.keep_roots) {
+    if (stream.s_roots == stream.c_roots) {
+      stream.c_roots = stream.c_roots > 0 ? 2 * stream.c_roots : 1 << 6;
+      stream.roots = (SK_Tree**)realloc(stream.roots, stream.c_roots * sizeof(SK_Tree*));
+      assert(stream.roots != NULL);
+    }
+    stream.roots[stream.s_roots++] = root;
+  }
+
+  (void)arena_release(arena, stream.mark);
+  sk_stats_begin(SK_PHASE_PARSE);
+  return true;
+}
+
+static bool _select_entries(HashTable table) {
+  assert(table != NULL);
+
+  // an entry has to be a definition of the file, an imported one is compiled already
+  ASTN_Stmt** stmts = (ASTN_Stmt**)malloc(s_entries * sizeof(ASTN_Stmt*));
+  assert(stmts != NULL);
+  bool found = true;
+  for (size_t i = 0; i < s_entries; i++) {
+    ASTN_Token token = { .frow = 0, .fcol = 0, .ecol = 0, .str = entries[i] };
+    stmts[i] = hashtable_lookup(table, &token);
+    if (stmts[i] != NULL && stmts[i]->expr != NULL)
+      continue;
+    fprintf(stderr, "[ERROR]: entry %s is not a definition of file %s\n", entries[i], filename);
+    found = false;
+  }
+
+  if (found)
+    ast_select(ast, stmts, s_entries);
+  free(stmts);
+  return found;
+}
+
+static bool _import_module(ASTN_Token* name) {
+  assert(name != NULL);
+
+  if (modules.arena == NULL) {
+    modules.arena = arena_shard_create(arena);
+    assert(modules.arena != NULL);
+  }
+  ModuleLink* link = modules.link != NULL ? modules.link : &modules.program;
+  for (size_t i = 0; i < link->s_deps; i++)
+    if (strcmp(link->deps[i].name, name->str) == 0)
+      return true;
+
+  char* path = _module_path(filename, name->str);
+  Module* module = _load_module(path);
+  free(path);
+  if (module == NULL) {
+    diagnostics_report(
+      parser_diagnostics, name->frow, name->fcol, name->ecol,
+      "[IMPORT]: could not import module %s in file %s at %u", name->str, filename, name->frow
+    );
+    return false;
+  }
+
+  for (size_t i = 0; i < module->s_roots; i++) {
+    if (ast_link_root(modules.arena, link->table, module->roots[i])) {
+      if (link == &modules.program)
+        _keep_linked(module->roots[i]);
+      continue;
+    }
+    diagnostics_report(
+      parser_diagnostics, name->frow, name->fcol, name->ecol,
+      "[IMPORT]: %s of module %s is already defined in file %s at %u",
+      module->roots[i]->ld_ident->token->str, name->str, filename, name->frow
+    );
+  }
+
+  if (link->s_deps == link->c_deps) {
+    link->c_deps = link->c_deps > 0 ? 2 * link->c_deps : 1 << 3;
+    link->deps = (SKB_Dep*)realloc(link->deps, link->c_deps * sizeof(SKB_Dep));
+    assert(link->deps != NULL);
+  }
+  // with --stream the name goes away with its statement, the dependency outlives it
+  link->deps[link->s_deps++] = (SKB_Dep){ .name = arena_strdup(modules.arena, (char*)name->str), .hash = module->hash };
+  return true;
+}
+
+static void _link_image(HashTable* table) {
+  assert(table != NULL);
+
+  // the statements are used as they are mapped, nothing is copied out of the image
+  for (ASTN_Stmt* stmt = modules.image != NULL ? ski_get_stmts(modules.image) : NULL; stmt != NULL; stmt = stmt->next) {
+    if (hashtable_exists(*table, stmt->var->token) || !hashtable_insert(table, stmt))
+      continue;
+    _keep_linked(stmt->sk_expr);
+  }
+}
+
+static void _keep_linked(SK_Tree* root) {
+  assert(root != NULL);
+
+  if (modules.s_linked == modules.c_linked) {
+    modules.c_linked = modules.c_linked > 0 ? 2 * modules.c_linked : 1 << 6;
+    modules.linked = (SK_Tree**)realloc(modules.linked, modules.c_linked * sizeof(SK_Tree*));
+    assert(modules.linked != NULL);
+  }
+  modules.linked[modules.s_linked++] = root;
+}
+
+static bool _save_image(const char* path, SK_Tree** roots, size_t s_roots) {
+  assert(path != NULL);
+
+  // the linked definitions come first, so a run starting from the image links them in the same order
+  size_t s_saved = 0;
+  SK_Tree** saved = (SK_Tree**)malloc((modules.s_linked + s_roots + 1) * sizeof(SK_Tree*));
+  assert(saved != NULL);
+  for (size_t i = 0; i < modules.s_linked; i++)
+    saved[s_saved++] = modules.linked[i];
+  for (size_t i = 0; roots != NULL && i < s_roots; i++)
+    if (roots[i] != NULL && roots[i]->ld_ident != NULL)
+      saved[s_saved++] = roots[i];
+
+  // other runs may have the image mapped, the pages of a file they map must never change under them
+  char* tmpname = _temp_path(path);
+  FILE* file = fopen(tmpname, "wb");
+  bool written = file != NULL && ski_write(file, saved, s_saved);
+  if (file != NULL)
+    written = fclose(file) == 0 && written;
+  written = written && rename(tmpname, path) == 0;
+  if (!written)
+    (void)remove(tmpname);
+
+  free(tmpname);
+  free(saved);
+  return written;
+}
+
+static Module* _load_module(const char* path) {
+  assert(path != NULL);
+
+  for (size_t i = 0; i < modules.s_list; i++) {
+    Module* module = modules.list[i];
+    if (strcmp(module->path, path) != 0)
+      continue;
+    if (module->loading) {
+      fprintf(stderr, "[IMPORT]: import cycle through module %s\n", path);
+      return NULL;
+    }
+    // a module that failed once is not compiled again for every file importing it
+    return module->roots != NULL ? module : NULL;
+  }
+
+  Module* module = (Module*)calloc(1, sizeof(Module));
+  assert(module != NULL);
+  module->path    = strdup(path);
+  module->loading = true;
+  assert(module->path != NULL);
+  if (modules.s_list == modules.c_list) {
+    modules.c_list = modules.c_list > 0 ? 2 * modules.c_list : 1 << 3;
+    modules.list = (Module**)realloc(modules.list, modules.c_list * sizeof(Module*));
+    assert(modules.list != NULL);
+  }
+  modules.list[modules.s_list++] = module;
+
+  Scanner* source = scanner_open(modules.arena, module->path);
+  if (source == NULL) {
+    module->loading = false;
+    return NULL;
+  }
+
+  size_t s_source = 0;
+  const char* text = scanner_get_source(source, &s_source);
+  uint64_t hash = _hash_source(text, s_source);
+  bool loaded = _load_module_cache(module, hash) || _compile_module(module, source, hash);
+
+  scanner_close(source);
+  module->loading = false;
+  return loaded ? module : NULL;
+}
+
+static bool _load_module_cache(Module* module, uint64_t hash) {
+  assert(module != NULL);
+
+  char* cachename = _replace_extension(module->path, ".skb");
+  SKB_Image* image = access(cachename, R_OK) == 0 ? skb_load(cachename) : NULL;
+  free(cachename);
+  if (image == NULL)
+    return false;
+
+  // a module it imports that changed since has been compiled again, so this one has to be too
+  bool valid = skb_get_source_hash(image) == hash && skb_get_size_roots(image) > 0;
+  for (size_t i = 0; valid && i < skb_get_size_deps(image); i++) {
+    SKB_Dep dep = skb_get_dep(image, i);
+    char* path = _module_path(module->path, dep.name);
+    Module* imported = _load_module(path);
+    free(path);
+    valid = imported != NULL && imported->hash == dep.hash;
+    hash = _hash_mix(hash, dep.hash);
+  }
+
+  if (valid) {
+    module->roots   = skb_get_roots(modules.arena, image);
+    module->s_roots = skb_get_size_roots(image);
+    module->hash    = hash;
+  }
+  if (module->roots == NULL) {
+    skb_unload(image);
+    return false;
+  }
+  module->image = image;
+  return true;
+}
+
+static bool _compile_module(Module* module, Scanner* source, uint64_t hash) {
+  assert(module != NULL && source != NULL);
+
+  // the module is parsed like a file of its own from inside the parse that imports it,
+  // whose state is put back afterwards
+  const char*  saved_filename    = filename;
+  Arena        saved_arena       = arena;
+  AST*         saved_ast         = ast;
+  Scanner*     saved_scanner     = scanner;
+  Diagnostics* saved_diagnostics = parser_diagnostics;
+  ModuleLink*  saved_link        = modules.link;
+  bool (*saved_handler)(ASTN_Stmt*) = parser_stmt_handler;
+
+  HashTable table = hashtable_create(1 << 5, .75);
+  ModuleLink link = { .table = &table, .deps = NULL, .s_deps = 0, .c_deps = 0 };
+  Diagnostics* errors = diagnostics_create(module->path);
+  size_t s_source = 0;
+  const char* text = scanner_get_source(source, &s_source);
+  diagnostics_set_source(errors, text, s_source);
+
+  filename            = module->path;
+  arena               = modules.arena;
+  ast                 = NULL;
+  scanner             = source;
+  parser_diagnostics  = errors;
+  parser_stmt_handler = NULL;
+  modules.link        = &link;
+
+  bool compiled = yyparse() == 0 && ast != NULL;
+  if (compiled) {
+    table = ast_check_linked(ast, table, errors);
+    compiled = diagnostics_count(errors) == 0;
+  }
+  if (compiled) {
+    ast_transform(modules.arena, ast);
+    ast_resolve(ast, table);
+    SK_Tree** roots = ast_convert(modules.arena, ast, table, errors);
+    compiled = diagnostics_count(errors) == 0;
+    module->roots   = compiled ? roots : NULL;
+    module->s_roots = compiled ? ast->s_stmts : 0;
+  }
+
+  filename            = saved_filename;
+  arena               = saved_arena;
+  ast                 = saved_ast;
+  scanner             = saved_scanner;
+  parser_diagnostics  = saved_diagnostics;
+  parser_stmt_handler = saved_handler;
+  modules.link        = saved_link;
+
+  (void)diagnostics_flush(errors, stderr);
+  diagnostics_destroy(errors);
+  hashtable_free(table);
+
+  uint64_t mixed = hash;
+  for (size_t i = 0; i < link.s_deps; i++)
+    mixed = _hash_mix(mixed, link.deps[i].hash);
+  module->hash = mixed;
+  if (compiled)
+    _write_module_cache(module, hash, &link);
+  free(link.deps);
+  return compiled;
+}
+
+static void _write_module_cache(Module* module, uint64_t hash, ModuleLink* link) {
+  assert(module != NULL && link != NULL);
+
+  char* cachename = _replace_extension(module->path, ".skb");
+  char* tmpname   = _temp_path(cachename);
+  FILE* file = fopen(tmpname, "wb");
+  bool written = file != NULL && skb_write_module(
+    file, module->roots, module->s_roots, hash, link->deps, link->s_deps
+  );
+  if (file != NULL)
+    written = fclose(file) == 0 && written;
+  if (!written || rename(tmpname, cachename) != 0) {
+    fprintf(stderr, "[IMPORT]: could not write module cache %s - %s\n", cachename, strerror(errno));
+    (void)remove(tmpname);
+  }
+
+  free(tmpname);
+  free(cachename);
+}
+
+static void _write_imported(FILE* file, SK_Tree* expr) {
+  // an imported definition is written right before the first one referring to it, so the .sk
+  // still reads back on its own
+  for (; expr != NULL; expr = expr->right) {
+    if (expr->type == APP_NODE) {
+      _write_imported(file, expr->left);
+      continue;
+    }
+    if (expr->type != REF_NODE)
+      return;
+
+    // a share made by reduction, or the reference a name was converted to, which keeps that name
+    SK_Tree* def = expr->left;
+    if (def->ld_ident == NULL || def->type == REF_NODE) {
+      _write_imported(file, def);
+      return;
+    }
+    if (!arena_contains(modules.arena, def) && !ski_contains(modules.image, def))
+      return;
+
+    char* name = (char*)def->ld_ident->token->str;
+    if (modules.written == NULL)
+      modules.written = hashmap_create(1 << 5, .75);
+    if (hashmap_get(modules.written, name) != NULL)
+      return;
+    (void)hashmap_insert(&modules.written, name, def, NULL, false);
+    _write_imported(file, def);
+    skt_write(file, &def, 1);
+    return;
+  }
+}
+
+static char* _temp_path(const char* path) {
+  assert(path != NULL);
+
+  // written beside the file and renamed over it, so another run never maps half a file
+  size_t s_tmpname = strlen(path) + 32;
+  char* tmpname = (char*)malloc(s_tmpname);
+  assert(tmpname != NULL);
+  static uint32_t s_tmpnames = 0;
+  snprintf(
+    tmpname, s_tmpname, "%s.%d.%u", path, (int32_t)getpid(),
+    __atomic_fetch_add(&s_tmpnames, 1, __ATOMIC_RELAXED)
+  );
+  return tmpname;
+}
+
+static void _free_modules(void) {
+  for (size_t i = 0; i < modules.s_list; i++) {
+    skb_unload(modules.list[i]->image);
+    free(modules.list[i]->path);
+    free(modules.list[i]);
+  }
+  free(modules.list);
+  free(modules.program.deps);
+  free(modules.linked);
+  ski_unload(modules.image);
+  if (modules.written != NULL)
+    hashmap_free(modules.written, NULL, false);
+
+  // the shard goes with the arena it was made from, the next --batch job starts over
+  modules.arena    = NULL;
+  modules.list     = NULL;
+  modules.s_list   = modules.c_list = 0;
+  modules.program  = (ModuleLink){ .table = NULL, .deps = NULL, .s_deps = 0, .c_deps = 0 };
+  modules.link     = NULL;
+  modules.written  = NULL;
+  modules.image    = NULL;
+  modules.linked   = NULL;
+  modules.s_linked = modules.c_linked = 0;
+}
+
+static char* _module_path(const char* importer, const char* name) {
+  assert(importer != NULL && name != NULL);
+
+  const char* slash = strrchr(importer, '/');
+  size_t s_dir  = slash != NULL ? (size_t)(slash - importer) + 1 : 0,
+         s_name = strlen(name);
+
+  char* path = (char*)malloc(s_dir + s_name + sizeof(".ld"));
+  assert(path != NULL);
+  memcpy(path, importer, s_dir);
+  memcpy(path + s_dir, name, s_name);
+  strcpy(path + s_dir + s_name, ".ld");
+  return path;
+}
+
+static uint64_t _hash_source(const char* source, size_t s_source) {
+  assert(source != NULL || s_source == 0);
+
+  // eight bytes at a time like the identifier hash of the scanner
+  uint64_t hash = _hash_mix(0x243f6a8885a308d3ull, s_source), word = 0;
+  for (; s_source >= 8; source += 8, s_source -= 8) {
+    memcpy(&word, source, 8);
+    hash = _hash_mix(hash, word);
+  }
+  word = 0;
+  memcpy(&word, source, s_source);
+  return _hash_mix(hash, word);
+}
+
+static uint64_t _hash_mix(uint64_t hash, uint64_t value) {
+  hash = (hash ^ value) * 0x9e3779b97f4a7c15ull;
+  return hash ^ (hash >> 32);
+}
+
+static bool _run_batch(char** paths, size_t s_paths, uint64_t s_jobs) {
+  assert(paths != NULL);
+
+  bool added = true;
+  for (size_t i = 0; i < s_paths; i++)
+    added = _batch_add(paths[i]) && added;
+  if (batch.s_jobs == 0) {
+    fprintf(stderr, "[ERROR]: no .ld file was found to compile\n");
+    return false;
+  }
+
+  size_t s_workers = s_jobs < batch.s_jobs ? (size_t)s_jobs : batch.s_jobs;
+  pthread_t* workers = (pthread_t*)malloc(s_workers * sizeof(pthread_t));
+  assert(workers != NULL);
+
+  double start = _now();
+  size_t s_started = 0;
+  for (; s_started < s_workers; s_started++)
+    if (pthread_create(&workers[s_started], NULL, _batch_worker, NULL) != 0)
+      break;
+  // with no thread at all the jobs still run, on this one
+  if (s_started == 0)
+    (void)_batch_worker(NULL);
+  for (size_t i = 0; i < s_started; i++)
+    pthread_join(workers[i], NULL);
+  double elapsed = _now() - start;
+
+  size_t s_failed = 0;
+  for (size_t i = 0; i < batch.s_jobs; i++) {
+    BatchJob* job = &batch.jobs[i];
+    if (job->s_log > 0)
+      fwrite(job->log, 1, job->s_log, stderr);
+    fprintf(
+      stdout, "[BATCH]: %s %s, %zu definitions, %zu errors, %.3f ms\n",
+      job->path, job->ok ? "compiled" : "failed", job->s_defs, job->s_errors, 1e3 * job->t_compile
+    );
+    s_failed += !job->ok;
+    free(job->log);
+    free(job->path);
+  }
+  fprintf(
+    stdout, "[BATCH]: %zu files, %zu failed, %.3f s on %zu threads, %.1f files/s\n",
+    batch.s_jobs, s_failed, elapsed, s_started > 0 ? s_started : 1, elapsed > 0 ? batch.s_jobs / elapsed : 0
+  );
+
+  free(workers);
+  free(batch.jobs);
+  return added && s_failed == 0;
+}
+
+static bool _batch_add(const char* path) {
+  assert(path != NULL);
+
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    fprintf(stderr, "[ERROR]: could not open %s - %s\n", path, strerror(errno));
+    return false;
+  }
+
+  if (!S_ISDIR(st.st_mode)) {
+    if (!_has_extension(path, ".ld")) {
+      fprintf(stderr, "[ERROR]: %s is not a .ld file\n", path);
+      return false;
+    }
+    if (batch.s_jobs == batch.c_jobs) {
+      batch.c_jobs = batch.c_jobs > 0 ? 2 * batch.c_jobs : 1 << 6;
+      batch.jobs = (BatchJob*)realloc(batch.jobs, batch.c_jobs * sizeof(BatchJob));
+      assert(batch.jobs != NULL);
+    }
+    batch.jobs[batch.s_jobs] = (BatchJob){ .path = strdup(path), .ok = false, .log = NULL, .s_log = 0 };
+    assert(batch.jobs[batch.s_jobs].path != NULL);
+    batch.s_jobs++;
+    return true;
+  }
+
+  DIR* dir = opendir(path);
+  if (dir == NULL) {
+    fprintf(stderr, "[ERROR]: could not open directory %s - %s\n", path, strerror(errno));
+    return false;
+  }
+
+  // the entries of a directory come in no particular order, they are sorted to keep the report stable
+  size_t first = batch.s_jobs;
+  bool added = true;
+  size_t s_path = strlen(path);
+  for (struct dirent* entry; (entry = readdir(dir)) != NULL;) {
+    if (entry->d_name[0] == '.')
+      continue;
+
+    char* child = (char*)malloc(s_path + strlen(entry->d_name) + 2);
+    assert(child != NULL);
+    sprintf(child, "%s%s%s", path, s_path > 0 && path[s_path - 1] == '/' ? "" : "/", entry->d_name);
+    struct stat st_child;
+    if (stat(child, &st_child) == 0 && (S_ISDIR(st_child.st_mode) || _has_extension(child, ".ld")))
+      added = _batch_add(child) && added;
+    free(child);
+  }
+  closedir(dir);
+
+  qsort(batch.jobs + first, batch.s_jobs - first, sizeof(BatchJob), _batch_compare);
+  return added;
+}
+
+static void* _batch_worker(void* arg) {
+  (void)arg;
+  for (size_t i; (i = __atomic_fetch_add(&batch.next, 1, __ATOMIC_RELAXED)) < batch.s_jobs;)
+    _batch_compile(&batch.jobs[i]);
+  return NULL;
+}
+
+static void _batch_compile(BatchJob* job) {
+  assert(job != NULL);
+
+  double start = _now();
+  FILE* log = open_memstream(&job->log, &job->s_log);
+  assert(log != NULL);
+
+  filename = job->path;
+  ast      = NULL;
+  arena    = arena_create_growable(1 << 20, MAX_SIZE, batch.s_limit, batch.arena_flags);
+  if (arena == NULL) {
+    fprintf(log, "[ERROR]: could not reserve the arena within the memory limit of %zu bytes\n", batch.s_limit);
+    fclose(log);
+    job->t_compile = _now() - start;
+    return;
+  }
+  arena_set_oom_handler(arena, _arena_oom);
+
+  Diagnostics* errors = diagnostics_create(job->path);
+  HashTable table = hashtable_create(1 << 5, .75);
+  parser_diagnostics    = errors;
+  parser_stmt_handler   = NULL;
+  parser_import_handler = _import_module;
+  modules.program.table = &table;
+
+  // the arena of the job is dropped as a whole below, whatever it held when the limit was hit
+  jmp_buf oom;
+  batch_oom = &oom;
+  batch_log = log;
+  if (setjmp(oom) == 0)
+    _batch_translate(job, log, errors, &table);
+  else {
+    (void)diagnostics_flush(errors, log);
+    job->ok = false;
+  }
+  batch_oom = NULL;
+  batch_log = NULL;
+  job->s_errors = diagnostics_count(errors);
+
+  hashtable_free(table);
+  scanner_close(scanner);
+  scanner = NULL;
+  diagnostics_destroy(errors);
+  _free_modules();
+  arena_destroy(arena);
+  arena = NULL;
+  fclose(log);
+  job->t_compile = _now() - start;
+}
+
+static void _batch_translate(BatchJob* job, FILE* log, Diagnostics* errors, HashTable* table) {
+  assert(job != NULL && log != NULL && errors != NULL && table != NULL);
+
+  scanner = scanner_open(arena, job->path);
+  if (scanner != NULL) {
+    size_t s_source = 0;
+    const char* source = scanner_get_source(scanner, &s_source);
+    diagnostics_set_source(errors, source, s_source);
+    (void)yyparse();
+  }
+  (void)diagnostics_flush(errors, log);
+  if (ast == NULL)
+    fprintf(log, "[ERROR]: could not %s input file %s\n", scanner != NULL ? "parse" : "open", job->path);
+
+  // like a single file, errors after the parse are reported and the .sk is still written
+  if (ast != NULL) {
+    *table = ast_check_linked(ast, *table, errors);
+    (void)diagnostics_flush(errors, log);
+    ast_transform(arena, ast);
+    ast_resolve(ast, *table);
+    SK_Tree** roots = backend(arena, ast, *table, errors);
+    (void)diagnostics_flush(errors, log);
+
+    char* outfilename = _replace_extension(job->path, ".sk");
+    FILE* outfile = fopen(outfilename, "w");
+    if (outfile != NULL) {
+      for (size_t i = 0; modules.arena != NULL && i < ast->s_stmts; i++)
+        _write_imported(outfile, roots[i]);
+      skt_write(outfile, roots, ast->s_stmts);
+      job->ok = fclose(outfile) == 0;
+    }
+    if (!job->ok)
+      fprintf(log, "[ERROR]: could not write %s - %s\n", outfilename, strerror(errno));
+    free(outfilename);
+
+    if (job->ok && batch.write_binary) {
+      char* binfilename = _replace_extension(job->path, ".skb");
+      FILE* binfile = fopen(binfilename, "wb");
+      job->ok = binfile != NULL && skb_write(binfile, roots, ast->s_stmts);
+      if (binfile != NULL)
+        job->ok = fclose(binfile) == 0 && job->ok;
+      if (!job->ok)
+        fprintf(log, "[ERROR]: could not write binary SK program %s - %s\n", binfilename, strerror(errno));
+      free(binfilename);
+    }
+    job->s_defs = ast->s_stmts;
+  }
+}
+
+static int32_t _batch_compare(const void* a, const void* b) {
+  return strcmp(((const BatchJob*)a)->path, ((const BatchJob*)b)->path);
+}
+
+static double _now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static bool _parse_size(const char* str, uint64_t* size) {
+  assert(str != NULL && size != NULL);
+
+  char* end = NULL;
+  errno = 0;
+  unsigned long long value = strtoull(str, &end, 10);
+  if (errno != 0 || end == str)
+    return false;
+
+  switch (*end) {
+    case 'G': case 'g': value <<= 10; // fallthrough
+    case 'M': case 'm': value <<= 10; // fallthrough
+    case 'K': case 'k': value <<= 10; end++; break;
+    case '\0': break;
+    default: return false;
+  }
+  if (*end != '\0')
+    return false;
+
+  *size = (uint64_t)value;
+  return true;
+}
+
+static void _arena_oom(Arena failed, uint64_t s_alloc) {
+  // failed may be a shard, the limit is that of the whole family and its arena counts it all
+  Arena family = arena_get_family(failed);
+  FILE* log = batch_log != NULL ? batch_log : stderr;
+  // what the phases before reported is still queued and goes first, an exit would lose it
+  if (parser_diagnostics != NULL)
+    (void)diagnostics_flush(parser_diagnostics, log);
+  fprintf(
+    log,
+    "[ERROR]: out of arena memory while allocating %zu bytes in file %s (reserved %zu of %zu bytes)\n",
+    s_alloc, filename, arena_get_size_reserved(family), arena_get_limit(family)
+  );
+  if (batch_oom != NULL)
+    longjmp(*batch_oom, 1);
+  exit(1);
+}
+
+static void _write_arena_stats(const char* path) {
+  assert(path != NULL);
+
+  FILE* file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: could not open arena stats file %s - %s\n", path, strerror(errno));
+    return;
+  }
+  arena_stats_write_json(arena, file);
+  if (file != stdout)
+    fclose(file);
+}
+
+static void _write_stats(bool print, const char* path) {
+  if (print)
+    sk_stats_print(stderr, arena);
+  if (path == NULL)
+    return;
+
+  FILE* file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: could not open stats file %s - %s\n", path, strerror(errno));
+    return;
+  }
+  sk_stats_write_json(file, arena);
+  if (file != stdout)
+    fclose(file);
+}
+
+static void _write_trace(void) {
+  if (!sk_trace_dump(trace_path))
+    fprintf(stderr, "[ERROR]: could not write trace file %s - %s\n", trace_path, strerror(errno));
+  sk_trace_disable();
+}
+
+static void _write_profile(const char* path, bool alloc) {
+  assert(path != NULL);
+
+  FILE* file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (file == NULL) {
+    fprintf(stderr, "[ERROR]: could not open profile file %s - %s\n", path, strerror(errno));
+  } else {
+    (void)sk_profile_write(file, alloc);
+    if (file != stdout)
+      fclose(file);
+  }
+  sk_profile_disable();
+}
+
+static char* _replace_extension(const char* filename, const char* extension) {
+  assert(filename != NULL && extension != NULL);
+
+  const char* dot = strrchr(filename, '.');
+  size_t s_stem = dot != NULL ? (size_t)(dot - filename) : strlen(filename);
+
+  char* replaced = (char*)malloc(s_stem + strlen(extension) + 1);
+  assert(replaced != NULL);
+  memcpy(replaced, filename, s_stem);
+  strcpy(replaced + s_stem, extension);
+  return replaced;
+}
+
+static bool _has_extension(const char* filename, const char* extension) {
+  assert(filename != NULL && extension != NULL);
+
+  size_t s_filename  = strlen(filename),
+         s_extension = strlen(extension);
+  return s_filename > s_extension && strcmp(filename + s_filename - s_extension, extension) == 0;
+}